@@ -1,15 +1,22 @@
 #include <iostream>		// cout, cin
 #include <string>		// std::string
-#include <Windows.h>	// CreateFile ..
 #include <fstream>      // std::ofstream
 #include <ctime>      // time
 #include <algorithm>      // for_each
+#include <cstdio>		// rename, remove
+#include <queue>		// priority_queue
+#include <thread>		// thread
+#include <mutex>		// mutex
+#include <atomic>		// atomic
 
 
 // possible model solutions possibilities
 #include "../src/nxnGridOfflineGlobalActions.h"
 #include "../src/nxnGridOfflineLocalActions.h"
 
+// solver
+#include "../src/PointBasedSolver.h"
+
 // properties of objects
 #include "../src/Coordinate.h"
 #include "../src/Move_Properties.h"
@@ -25,144 +32,20 @@
 // choose model to run
 enum MODELS_AVAILABLE { NXN_LOCAL_ACTIONS, NXN_GLOBAL_ACTIONS };
 static MODELS_AVAILABLE s_UsingModel = NXN_GLOBAL_ACTIONS;
-// buffer size for read
-const static int s_BUFFER_SIZE = 1024;
 
 using lutSarsop = std::map<int, std::vector<double>>;
 
-// appl solver directory location
-std::string s_SOLVER_LOCATION = "D:\\madaan\\SARSOP\\src\\Release\\";
-
-static std::ofstream s_BACKUP_FILE;
-
-// lut from object identity to char symbolized it
-static char * s_OBJ_TO_STRING;
-
-void TranlateToX(const std::string &pomdp, const std::string &pomdpx)
-{
-	STARTUPINFO si;
-	PROCESS_INFORMATION pi;
-
-	ZeroMemory(&si, sizeof(si));
-	si.cb = sizeof(si);
-	//si.dwFlags |= STARTF_USESTDHANDLES;
-	ZeroMemory(&pi, sizeof(pi));
-
-	//run solver with timeout of 100 seconds and precision boundary of 0.005 (the first among these two conditions)
-	std::string cmd = s_SOLVER_LOCATION + "pomdpconvert.exe " + pomdp + " " + pomdpx;
-	if (!CreateProcess(NULL, const_cast<char *>(cmd.c_str()), NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi))
-	{
-		std::cout << "CreateProcess failed (" << GetLastError() << ")\n";
-		exit(1);
-	}
-	// wait for the solver to finish
-	WaitForSingleObject(pi.hProcess, INFINITE);
-}
-/// run solver save policy in policty_name
-void RunSolver(std::string &fname, std::string &policy_name, std::string &solverOutF)
-{
-	//STARTUPINFO si;
-	//PROCESS_INFORMATION pi;
-
-	//ZeroMemory(&si, sizeof(si));
-	//si.cb = sizeof(si);
-	//ZeroMemory(&pi, sizeof(pi));
-	//// direct the output to the write pipe
-	//si.hStdInput = NULL;
-
-	//run solver with timeout of 10000 seconds and precision boundary of 0.005 (the first among these two conditions)
-	std::string cmd = s_SOLVER_LOCATION + "pomdpsol.exe --timeout 30000 --precision 0.005 ";
-	cmd += fname + " -o " + policy_name + " > " + solverOutF;
-	
-	//if (!CreateProcess(NULL, const_cast<char *>(cmd.c_str()), NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi))
-	//{
-	//	std::cerr << "CreateProcess failed (" << GetLastError() << ")\n";
-	//	exit(1);
-	//}
-
-	//// wait for the evaluation to finish
-	//WaitForSingleObject(pi.hProcess, INFINITE);
-	
-	
-	int stat = system(cmd.c_str());
-
-	if (stat != 0)
-	{
-		std::cerr << "error in running SARSOP solver\n";
-		exit(1);
-	}
-}
-
-void RunSimulator(std::string &fname, std::string &policy_name)
-{
-	STARTUPINFO si;
-	PROCESS_INFORMATION pi;
-
-	ZeroMemory(&si, sizeof(si));
-	si.cb = sizeof(si);
-	ZeroMemory(&pi, sizeof(pi));
-	// direct the output to the write pipe
-	si.hStdInput = NULL;
-
-	// run evaluator with 200 simulations
-	std::string cmd = s_SOLVER_LOCATION + "pomdpsim.exe --simLen 50 --simNum 50 ";
-	cmd += "--policy-file " + policy_name + " " + fname;
-	if (!CreateProcess(NULL, const_cast<char *>(cmd.c_str()), NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi))
-	{
-		std::cerr << "CreateProcess failed (" << GetLastError() << ")\n";
-		exit(1);
-	}
-	// wait for the evaluation to finish
-	WaitForSingleObject(pi.hProcess, INFINITE);
-}
-
-double FindAndAdvance(const char **str)
-{
-	// search for the nearest number and return it
-	const char *curr = *str;
-	while (!isdigit(*curr))
-	{
-		++curr;
-	}
-
-	// if the  number is negative don't forget the minus
-	if (*(curr - 1) == '-')
-	{
-		--curr;
-	}
-	return strtod(curr, const_cast<char**>(str));
-}
-
-
-void ReadReward(nxnGridOffline * pomdp, lutSarsop & sarsopMap, std::string & sarsopDataFName)
-{
-	std::ifstream data(sarsopDataFName, std::ios::in | std::ios::binary);
-	if (data.fail())
-	{
-		std::cout << "open sarsop file failed with error code = " << GetLastError() << "\npress any key to exit\n";
-		char c;
-		std::cin >> c;
-		exit(0);
-	}
-
-	int size;
-	data.read((char *)&size, sizeof(int));
-	int numActions;
-	data.read((char *)&numActions, sizeof(int));
-	for (int stateCount = 0; stateCount < size; ++stateCount)
-	{
-		int stateIdx = pomdp->StateCount2StateIdx(stateCount);
-		sarsopMap[stateIdx].resize(numActions);
-
-		for (int action = 0; action < numActions; ++action)
-		{
-			double reward;
-			data.read((char *)&reward, sizeof(double));
-			sarsopMap[stateIdx][action] = reward;
-		}
-
-	}
-}
+// solver parameters (solve until num of beliefs reached and precision of initial belief value or until timeout)
+static const int s_MAX_BELIEFS = 20000;
+static const int s_BACKUPS_PER_EXPANSION = 5;
+static const double s_SOLVER_TIMEOUT = 30000.0;
+static const double s_PRECISION = 0.005;
+// num of solver threads of each job (0 = all cores)
+static const int s_NUM_THREADS = 0;
+// num of jobs (shelter locations) solved concurrently (the solver threads of all jobs share the cores)
+static const int s_NUM_PARALLEL_JOBS = 2;
+// save the model as binary sparse matrices (prefix.sparse) for other consumers
+static const bool s_SAVE_SPARSE_MODEL = true;
 
 Attack_Obj CreateEnemy(int gridSize, Coordinate & location)
 {
@@ -214,75 +97,44 @@ ObjInGrid CreateShelter(Coordinate & location)
 	return ObjInGrid(location);
 }
 
-void CreateLUT(nxnGridOffline * pomdp, std::string & prefix, lutSarsop & sarsopMap)
+/// a single lut build: the model with a specific shelter location (-1 for model without shelters). the result is saved to a partial lut file
+struct LUTJob
 {
-	std::string pomdpFName = prefix + ".pomdp";
-	// remove pomdp file before writing it
-	remove(pomdpFName.c_str());
-	FILE *fptr;
-	auto err = fopen_s(&fptr, pomdpFName.c_str(), "w");
-	if (0 != err)
-	{
-		std::cout << "ERROR OPEN\n";
-		exit(1);
-	}
-	// write pomdp file
-	pomdp->SaveInPomdpFormat(fptr);
-	fclose(fptr);
-
-	// print initial state
-	std::cout << "finished writing pomdp file\n";
+	std::string m_prefix;
+	int m_shelterLoc;
+};
 
-	// create policy and calculate duration of solver
-	std::string policyName = prefix + ".policy";
-	std::string solverOutFname = prefix + ".txt";
-	time_t solverStart = time(nullptr);
-	RunSolver(pomdpFName, policyName, solverOutFname);
-	time_t solverDuration = time(nullptr) - solverStart;
+static std::mutex s_printMutex;
 
-	
-	std::cout << "finished creating policy file\n";
-	// run simulator
-	RunSimulator(pomdpFName, policyName);
-	std::cout << "finished running simulator\n";
-	std::string sarsopDataFName = prefix + "_sarsopData.bin";
-	ReadReward(pomdp, sarsopMap, sarsopDataFName);
+void Print(const std::string & str)
+{
+	std::lock_guard<std::mutex> lock(s_printMutex);
+	std::cout << str;
 }
 
-void TraverseAllShelterLoc(nxnGridOffline * pomdp, std::vector<int> possibleShelterLoc, std::string & prefix, lutSarsop & sarsopMap)
+std::string PartialLUTFName(const std::string & prefix)
 {
-	int gridSize = pomdp->GetGridSize();
+	return prefix + "_LUT.part";
+}
 
-	prefix += "S";
-	for (auto s : possibleShelterLoc)
-	{
-		Coordinate point(s % gridSize, s / gridSize);
-		pomdp->SetLocationShelter(point, pomdp->CountMovableObj());
-
-		prefix += std::to_string(s);
-		CreateLUT(pomdp, prefix, sarsopMap);
-		prefix.pop_back();
-		if (s > 9)
-			prefix.pop_back();
-		if (s > 99)
-			prefix.pop_back();
-	}
+bool FileExist(const std::string & fName)
+{
+	std::ifstream file(fName, std::ios::in | std::ios::binary);
+	return file.good();
 }
 
-int main()
+nxnGridOffline * CreateModel(int gridSize)
 {
-	// create model
-	int gridSize = 10;
-	
 	Coordinate m(0, 0);
 	int target = gridSize * gridSize - 1;
+	Self_Obj self = CreateSelf(gridSize, m);
 
 	nxnGridOffline * model = nullptr;
 
 	if (s_UsingModel == NXN_LOCAL_ACTIONS)
-		model = new nxnGridOfflineLocalActions(gridSize, target, CreateSelf(gridSize, m), false);
+		model = new nxnGridOfflineLocalActions(gridSize, target, self, false);
 	else if (s_UsingModel == NXN_GLOBAL_ACTIONS)
-		model = new nxnGridOfflineGlobalActions(gridSize, target, CreateSelf(gridSize, m), false);
+		model = new nxnGridOfflineGlobalActions(gridSize, target, self, false);
 	else
 	{
 		std::cout << "model not recognized... exiting!!\n";
@@ -304,36 +156,13 @@ int main()
 	Coordinate s(0, 0);
 	model->AddObj(CreateShelter(s));
 
-	// optional shelter loc
-	std::vector<int> shelterLoc{ 62,63,72,73 };
-
-	// create prefix for file name
-	std::string prefix = std::to_string(gridSize) + "x" + std::to_string(gridSize) + "Grid";
-	prefix += std::to_string(model->CountEnemies()) + "x" + std::to_string(model->CountNInv()) + "x" + std::to_string(model->CountShelters());
-
-	std::string lutFName(prefix);
-	lutFName += "_LUT.bin";
-	lutSarsop sarsopMap;
-	
-	// create all format and solver options for the model
-	//if (0 != model->CountShelters())
-	//	TraverseAllShelterLoc(model, shelterLoc, prefix, sarsopMap);
-	//else
-	//	CreateLUT(model, prefix, sarsopMap);
-
-	prefix += "S";
-	for (auto s : shelterLoc)
-	{
-		Coordinate point(s % gridSize, s / gridSize);
-		model->SetLocationShelter(point, model->CountMovableObj());
-		std::string sarsopDataFName = prefix + std::to_string(s) + "_sarsopData.bin";
-		ReadReward(model, sarsopMap, sarsopDataFName);
-	}
-
+	return model;
+}
 
-	// write map to lut
-	int numActions = model->GetNumActions();
-	std::ofstream lut(lutFName, std::ios::out | std::ios::binary);
+/// write lut (num of states, num of actions and for each state: state idx and action values) to file. return false on failure
+bool WriteLUT(const std::string & fName, const lutSarsop & sarsopMap, int numActions)
+{
+	std::ofstream lut(fName, std::ios::out | std::ios::binary);
 	int mapSize = sarsopMap.size();
 	lut.write((const char *)&mapSize, sizeof(int));
 	lut.write((const char *)&numActions, sizeof(int));
@@ -346,15 +175,184 @@ int main()
 		}
 	});
 
-	std::string dest = "C:\\Users\\moshe\\Documents\\GitHub\\Despot\\" + lutFName;
-	std::string src = "C:\\Users\\moshe\\Documents\\GitHub\\Despot\\" + lutFName;
+	lut.close();
+	return lut.good();
+}
+
+/// solve model and save the action values to the partial lut of the job. the partial lut is written to a temporary file and renamed
+/// so an existing partial lut is always complete. return false on failure
+bool CreateLUT(nxnGridOffline * pomdp, const std::string & prefix)
+{
+	Print(prefix + ": building model\n");
+	SparsePomdp sparsePomdp;
+	std::vector<long> lutKeys;
+	pomdp->BuildSparsePomdp(sparsePomdp, lutKeys);
+	if (s_SAVE_SPARSE_MODEL && !sparsePomdp.Write(prefix + ".sparse", lutKeys))
+		return false;
+
+	Print(prefix + ": solving model with " + std::to_string(sparsePomdp.NumStates()) + " states\n");
+	time_t solverStart = time(nullptr);
+	PointBasedSolver solver(sparsePomdp, s_NUM_THREADS);
+	solver.Solve(s_MAX_BELIEFS, s_BACKUPS_PER_EXPANSION, s_SOLVER_TIMEOUT, s_PRECISION);
+	time_t solverDuration = time(nullptr) - solverStart;
+	Print(prefix + ": finished solving in " + std::to_string(solverDuration) + " seconds (beliefs = " + std::to_string(solver.NumBeliefs()) 
+		+ ", alpha vectors = " + std::to_string(solver.NumAlphaVectors()) + ")\n");
+
+	// insert action values of all states (without win and loss states) to lut
+	std::vector<std::vector<double>> values;
+	solver.AllActionValues(values);
+	lutSarsop sarsopMap;
+	for (int s = 0; s < lutKeys.size(); ++s)
+		sarsopMap[lutKeys[s]] = values[s];
+
+	std::string partFName = PartialLUTFName(prefix);
+	std::string tmpFName = partFName + ".tmp";
+	if (!WriteLUT(tmpFName, sarsopMap, pomdp->GetNumActions()))
+		return false;
+
+	std::remove(partFName.c_str());
+	return std::rename(tmpFName.c_str(), partFName.c_str()) == 0;
+}
+
+/// run all jobs on s_NUM_PARALLEL_JOBS workers. jobs with existing partial lut are skipped. return num of failed jobs
+int RunJobs(const std::vector<LUTJob> & jobs, int gridSize)
+{
+	std::atomic<int> next(0);
+	std::atomic<int> numFailed(0);
+	auto worker = [&jobs, &next, &numFailed, gridSize]()
+	{
+		for (int j = next++; j < jobs.size(); j = next++)
+		{
+			const LUTJob & job = jobs[j];
+			if (FileExist(PartialLUTFName(job.m_prefix)))
+			{
+				Print(job.m_prefix + ": already solved\n");
+				continue;
+			}
+
+			nxnGridOffline * model = CreateModel(gridSize);
+			if (job.m_shelterLoc >= 0)
+			{
+				Coordinate point(job.m_shelterLoc % gridSize, job.m_shelterLoc / gridSize);
+				model->SetLocationShelter(point, model->CountMovableObj());
+			}
+
+			if (!CreateLUT(model, job.m_prefix))
+			{
+				Print(job.m_prefix + ": failed\n");
+				++numFailed;
+			}
+			delete model;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int t = 1; t < s_NUM_PARALLEL_JOBS; ++t)
+		threads.emplace_back(worker);
+	worker();
+
+	for (auto & t : threads)
+		t.join();
+
+	return numFailed;
+}
+
+/// merge the partial luts (each sorted by state idx) to a single lut sorted by state idx in a single pass. return false on failure
+bool MergeLUTs(const std::vector<std::string> & partFNames, const std::string & lutFName, int numActions)
+{
+	std::vector<std::ifstream> parts(partFNames.size());
+	std::vector<int> left(partFNames.size());
+	int mapSize = 0;
+	for (int p = 0; p < parts.size(); ++p)
+	{
+		parts[p].open(partFNames[p], std::ios::in | std::ios::binary);
+		int partNumActions = 0;
+		parts[p].read((char *)&left[p], sizeof(int));
+		parts[p].read((char *)&partNumActions, sizeof(int));
+		if (!parts[p] || partNumActions != numActions)
+		{
+			std::cerr << "failed reading " << partFNames[p] << "\n";
+			return false;
+		}
+		mapSize += left[p];
+	}
+
+	std::ofstream lut(lutFName, std::ios::out | std::ios::binary);
+	lut.write((const char *)&mapSize, sizeof(int));
+	lut.write((const char *)&numActions, sizeof(int));
+
+	// (state idx, part) of the next entry of each part. smallest state idx first
+	using entry = std::pair<int, int>;
+	std::priority_queue<entry, std::vector<entry>, std::greater<entry>> heads;
+	auto readHead = [&parts, &left, &heads](int p)
+	{
+		int key;
+		if (left[p]-- > 0 && parts[p].read((char *)&key, sizeof(int)))
+			heads.emplace(key, p);
+	};
+	for (int p = 0; p < parts.size(); ++p)
+		readHead(p);
+
+	std::vector<double> values(numActions);
+	while (!heads.empty())
+	{
+		entry head = heads.top();
+		heads.pop();
+		parts[head.second].read((char *)values.data(), numActions * sizeof(double));
+		lut.write((const char *)&head.first, sizeof(int));
+		lut.write((const char *)values.data(), numActions * sizeof(double));
+		readHead(head.second);
+	}
 
 	lut.close();
-	if (!MoveFile(src.c_str(), dest.c_str()))
+	return lut.good();
+}
+
+int main()
+{
+	// create model
+	int gridSize = 10;
+	nxnGridOffline * model = CreateModel(gridSize);
+
+	// optional shelter loc
+	std::vector<int> shelterLoc{ 62,63,72,73 };
+
+	// create prefix for file name
+	std::string prefix = std::to_string(gridSize) + "x" + std::to_string(gridSize) + "Grid";
+	prefix += std::to_string(model->CountEnemies()) + "x" + std::to_string(model->CountNInv()) + "x" + std::to_string(model->CountShelters());
+
+	std::string lutFName(prefix);
+	lutFName += "_LUT.bin";
+
+	// a job for each shelter location
+	std::vector<LUTJob> jobs;
+	if (0 != model->CountShelters())
 	{
-		std::cout << "failed moving lut to main directory\n";
-		std::cout << "press any key to exit";
-		char c;
-		std::cin >> c;
+		for (auto s : shelterLoc)
+			jobs.emplace_back(LUTJob{ prefix + "S" + std::to_string(s), s });
 	}
+	else
+		jobs.emplace_back(LUTJob{ prefix, -1 });
+
+	// solve the model for all jobs (the partial luts of finished jobs are kept so a rerun continues from the unfinished jobs)
+	int numFailed = RunJobs(jobs, gridSize);
+	if (numFailed > 0)
+	{
+		std::cout << numFailed << " jobs failed. run again to solve the remaining jobs\n";
+		exit(1);
+	}
+
+	// merge partial luts to lut
+	std::vector<std::string> partFNames;
+	for (auto & job : jobs)
+		partFNames.emplace_back(PartialLUTFName(job.m_prefix));
+
+	if (!MergeLUTs(partFNames, lutFName, model->GetNumActions()))
+	{
+		std::cout << "failed saving lut to " << lutFName << "\n";
+		exit(1);
+	}
+	std::cout << "lut saved to " << lutFName << "\n";
+
+	delete model;
 }
@@ -19,6 +19,11 @@ struct Config {
 	int max_policy_sim_len; // Maximum number of steps for simulating the default policy
 	double noise;
 	bool silence;
+	int transition_cache_size; // Number of cached transitions (0 = no transition cache)
+	int num_search_threads; // Number of threads running DESPOT trials (1 = serial search)
+	int num_expand_threads; // Number of threads stepping particles in DESPOT node expansion (1 = serial expansion)
+	bool reuse_tree; // Keep the DESPOT subtree of the executed action and observation for the next search
+	double reuse_min_scenarios; // Fraction of the scenarios a kept subtree must hold to be reused
 	
 
 	Config() :
@@ -34,7 +39,12 @@ struct Config {
 		default_action(""),
 		max_policy_sim_len(90),
 		noise(0.1),
-		silence(false) {
+		silence(false),
+		transition_cache_size(0),
+		num_search_threads(1),
+		num_expand_threads(1),
+		reuse_tree(false),
+		reuse_min_scenarios(0.25) {
 }
 };
 
@@ -46,6 +46,12 @@ public:
 	 */
 	virtual ValuedAction Value(const std::vector<State*>& particles,
 		RandomStreams& streams, History& history) const = 0;
+
+	/**
+	 * Returns true if Value can be called from concurrent threads, as done by
+	 * DESPOT::ParallelTrials. Override this to opt in, the default is false.
+	 */
+	virtual bool IsThreadSafe() const;
 };
 
 /* =============================================================================
@@ -109,6 +115,8 @@ public:
 
 public:
 	virtual ValuedAction Value(const std::vector<State*>& particles) const;
+
+	virtual bool IsThreadSafe() const;
 };
 
 /* =============================================================================
@@ -5,11 +5,20 @@
 #include "../util/util.h"
 #include "../random_streams.h"
 #include "../util/logging.h"
+#include "../util/arena.h"
 
 namespace despot {
 
+class VNode;
 class QNode;
 
+// Children of a belief node (one per action) and of a Q-node (one per
+// observation). They allocate from the arena of their node, or from the heap
+// for nodes created outside an arena
+typedef std::vector<QNode*, ArenaAllocator<QNode*> > ActionChildren;
+typedef std::map<OBS_TYPE, VNode*, std::less<OBS_TYPE>,
+	ArenaAllocator<std::pair<const OBS_TYPE, VNode*> > > ObsChildren;
+
 /* =============================================================================
  * VNode class
  * =============================================================================*/
@@ -26,7 +35,7 @@ protected:
 	QNode* parent_;
 	OBS_TYPE edge_;
 
-	std::vector<QNode*> children_;
+	ActionChildren children_;
 
 	ValuedAction default_move_; // Value and action given by default policy
 	double lower_bound_;
@@ -41,14 +50,36 @@ public:
 	double likelihood; // Used in AEMS
 	double utility_upper_bound;
 
+	// For parallel DESPOT
+	int virtual_loss; // Number of search threads whose trial passes through the node
+	bool expanding; // True while a search thread expands the node
+
 	VNode(std::vector<State*>& particles, int depth = 0, QNode* parent = NULL,
-		OBS_TYPE edge = -1);
+		OBS_TYPE edge = -1, Arena* arena = NULL);
 	VNode(Belief* belief, int depth = 0, QNode* parent = NULL, OBS_TYPE edge =
 		-1);
 	VNode(int count, double value, int depth = 0, QNode* parent = NULL,
-		OBS_TYPE edge = -1);
+		OBS_TYPE edge = -1, Arena* arena = NULL);
 	~VNode();
 
+	/**
+	 * Create a node in the arena, or with new if arena is NULL. A node in an
+	 * arena is never deleted: its subtree is released by resetting the arena,
+	 * after VNode::Free has released the particles.
+	 */
+	static VNode* Create(Arena* arena, std::vector<State*>& particles,
+		int depth = 0, QNode* parent = NULL, OBS_TYPE edge = -1);
+	static VNode* Create(Arena* arena, int count, double value, int depth = 0,
+		QNode* parent = NULL, OBS_TYPE edge = -1);
+
+	/**
+	 * Move the subtree rooted at the node into an arena (or the heap if arena
+	 * is NULL). The particles are moved to the new nodes; the original nodes
+	 * are left without particles and are released with their arena.
+	 */
+	VNode* MoveSubtree(Arena* arena, QNode* parent = NULL);
+
+	Arena* arena() const; // NULL for nodes on the heap
 	Belief* belief() const;
 	const std::vector<State*>& particles() const;
 	void depth(int d);
@@ -59,8 +90,8 @@ public:
 
 	double Weight() const;
 
-	const std::vector<QNode*>& children() const;
-	std::vector<QNode*>& children();
+	const ActionChildren& children() const;
+	ActionChildren& children();
 	const QNode* Child(int action) const;
 	QNode* Child(int action);
 	int Size() const;
@@ -103,7 +134,7 @@ class QNode {
 protected:
 	VNode* parent_;
 	int edge_;
-	std::map<OBS_TYPE, VNode*> children_;
+	ObsChildren children_;
 	double lower_bound_;
 	double upper_bound_;
 
@@ -117,15 +148,22 @@ public:
 	double step_reward;
 	double likelihood;
 	VNode* vstar;
+	int virtual_loss; // For parallel DESPOT: number of search threads whose trial passes through the node
 
-	QNode(VNode* parent, int edge);
+	QNode(VNode* parent, int edge, Arena* arena = NULL);
 	QNode(int count, double value);
 	~QNode();
 
+	// Create a node in the arena, or with new if arena is NULL
+	static QNode* Create(Arena* arena, VNode* parent, int edge);
+
+	QNode* MoveSubtree(Arena* arena, VNode* parent);
+
+	Arena* arena() const;
 	void parent(VNode* parent);
 	VNode* parent();
 	int edge();
-	std::map<OBS_TYPE, VNode*>& children();
+	ObsChildren& children();
 	VNode* Child(OBS_TYPE obs);
 	int Size() const;
 	int PolicyTreeSize() const;
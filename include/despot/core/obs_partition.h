@@ -0,0 +1,52 @@
+#ifndef OBS_PARTITION_H
+#define OBS_PARTITION_H
+
+#include <vector>
+#include <utility>
+
+#include "../core/globals.h"
+
+namespace despot {
+
+class State;
+
+/* =============================================================================
+ * ObsPartition class
+ * =============================================================================*/
+/**
+ * Groups particles by observation. The (observation, particle index) pairs
+ * added are sorted in place, which gives one contiguous range per distinct
+ * observation. Ranges are in ascending observation order and the indices in
+ * a range are increasing, the same grouping as pushing the particles in index
+ * order into a std::map<OBS_TYPE, std::vector<State*> >. The buffers are kept
+ * between uses, so a partition reused across calls does not allocate once it
+ * has grown to the number of particles.
+ */
+class ObsPartition {
+private:
+	std::vector<std::pair<OBS_TYPE, int> > entries_;
+	std::vector<int> range_begin_; // the last range ends at entries_.size()
+
+public:
+	void Clear();
+	void Add(OBS_TYPE obs, int index);
+
+	/**
+	 * Sort the added pairs and find the ranges of equal observations.
+	 */
+	void Partition();
+
+	int NumRanges() const;
+	OBS_TYPE Observation(int range) const;
+
+	/**
+	 * Replace the content of out with the particles whose indices are in the
+	 * given range.
+	 */
+	void Gather(int range, const std::vector<State*>& particles,
+		std::vector<State*>& out) const;
+};
+
+} // namespace despot
+
+#endif
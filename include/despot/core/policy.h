@@ -43,11 +43,10 @@ struct ValuedAction {
 
 class Policy: public ScenarioLowerBound {
 private:
-	mutable int initial_depth_;
 	ParticleLowerBound* particle_lower_bound_;
 
 	ValuedAction RecursiveValue(const std::vector<State*>& particles,
-		RandomStreams& streams, History& history) const;
+		RandomStreams& streams, History& history, int initial_depth) const;
 
 public:
 	Policy(const DSPOMDP* model, ParticleLowerBound* particle_lower_bound,
@@ -81,6 +80,9 @@ public:
 	int Action(const std::vector<State*>& particles, RandomStreams& streams,
 		History& history) const;
 
+	// Thread-safe when its particle lower bound is
+	bool IsThreadSafe() const;
+
 	ValuedAction Search();
 	void Update(int action, OBS_TYPE obs);
 };
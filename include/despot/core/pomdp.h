@@ -1,6 +1,8 @@
 #ifndef POMDP_H
 #define POMDP_H
 
+#include <memory>
+
 #include "../core/globals.h"
 #include "../core/belief.h"
 #include "../random_streams.h"
@@ -84,6 +86,7 @@ public:
 };
 
 class POMCPPrior;
+class TransitionCache;
 
 /* =============================================================================
  * DSPOMDP class
@@ -92,11 +95,17 @@ class POMCPPrior;
  * Interface for a deterministic simulative model for POMDP.
  */
 class DSPOMDP {
+protected:
+	std::unique_ptr<TransitionCache> transition_cache_;
+
 public:
 	DSPOMDP();
 
 	virtual ~DSPOMDP();
 
+	DSPOMDP(const DSPOMDP&) = delete;
+	DSPOMDP& operator=(const DSPOMDP&) = delete;
+
 	/* ========================================================================
 	 * Deterministic simulative model and related functions
 	 * ========================================================================*/
@@ -119,6 +128,68 @@ public:
 	virtual bool Step(State& state, int action, OBS_TYPE lastObs, double& reward,
 		OBS_TYPE& obs) const;
 
+	/**
+	 * Batched determistic simulative model. Steps particles[i] with randomNums[i]
+	 * and lastObs[i], and sets rewards[i], obs[i] and terminals[i]. Override this
+	 * to get speedup for belief update and tree expansion, the default
+	 * implementation calls Step for each particle.
+	 */
+	virtual void StepBatch(const std::vector<State*>& particles,
+		const std::vector<double>& randomNums, int action,
+		const std::vector<OBS_TYPE>& lastObs, std::vector<double>& rewards,
+		std::vector<OBS_TYPE>& obs, std::vector<bool>& terminals) const;
+
+	/* ========================================================================
+	 * Transition cache
+	 * ========================================================================*/
+	/**
+	 * Memoizes the transitions stepped by the solvers (rollouts, tree expansion
+	 * and default policy) in a cache of capacity transitions, capacity = 0
+	 * removes the cache. Only for models that return true in
+	 * SupportsTransitionCache.
+	 */
+	void EnableTransitionCache(int capacity, int random_buckets = 65536);
+
+	/**
+	 * Returns true if the state is fully described by state_id and Step is
+	 * deterministic given the random number, so transitions can be memoized.
+	 * Override this to opt in to the transition cache, the default is false.
+	 */
+	virtual bool SupportsTransitionCache() const;
+
+	/**
+	 * Returns true if the const members used by the search (Step, Copy, Free,
+	 * bounds such as GetMinRewardAction) can be called from concurrent threads,
+	 * as done by DESPOT::ParallelTrials. Override this to opt in, the default
+	 * is false.
+	 */
+	virtual bool IsThreadSafe() const;
+
+	TransitionCache* transition_cache() const;
+
+	/**
+	 * Steps through the transition cache when it is enabled, and through Step
+	 * otherwise.
+	 */
+	bool CachedStep(State& state, double random_num, int action,
+		OBS_TYPE lastObs, double& reward, OBS_TYPE& obs) const;
+
+	/**
+	 * Steps through the transition cache when it is enabled, and through
+	 * StepBatch otherwise.
+	 */
+	void CachedStepBatch(const std::vector<State*>& particles,
+		const std::vector<double>& randomNums, int action,
+		const std::vector<OBS_TYPE>& lastObs, std::vector<double>& rewards,
+		std::vector<OBS_TYPE>& obs, std::vector<bool>& terminals) const;
+
+	/**
+	 * Returns the part of lastObs that affects the transition of action (used
+	 * as part of the transition cache key). The default is the whole
+	 * observation, override this to get more cache hits.
+	 */
+	virtual OBS_TYPE TransitionObs(int action, OBS_TYPE lastObs) const;
+
 	/* ========================================================================
 	 * Action
 	 * ========================================================================*/
@@ -136,6 +207,13 @@ public:
 	virtual double ObsProb(OBS_TYPE obs, const State& state,
 		int action) const = 0;
 
+	/**
+	 * Returns the observation probability for each particle in probs. The
+	 * default implementation calls ObsProb for each particle.
+	 */
+	virtual void ObsProbBatch(OBS_TYPE obs, const std::vector<State*>& particles,
+		int action, std::vector<double>& probs) const;
+
 	/**
 	 * Returns a starting state.
 	 */
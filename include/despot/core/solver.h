@@ -28,6 +28,9 @@ struct SearchStatistics {
 	int num_particles_after_search;
 	int num_trials;
 	int longest_trial_length;
+	bool prior_cache_used; // Set by POMCP priors that keep a cache
+	long num_prior_cache_hits;
+	long num_prior_cache_misses;
 
 	SearchStatistics();
 
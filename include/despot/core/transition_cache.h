@@ -0,0 +1,92 @@
+#ifndef TRANSITION_CACHE_H
+#define TRANSITION_CACHE_H
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+
+#include "../core/globals.h"
+
+namespace despot {
+
+class State;
+class DSPOMDP;
+
+/* =============================================================================
+ * TransitionCache class
+ * =============================================================================*/
+/**
+ * Bounded memo of the transitions of a discrete-state model, i.e. a model whose
+ * state is fully described by state_id and whose Step is a pure function of
+ * (state, random number, action, last observation).
+ *
+ * A transition is keyed by (state_id, action, TransitionObs(action, lastObs),
+ * random bucket). The random number is quantized to its bucket before stepping,
+ * so a cached transition is exactly the model transition for the bucket. The
+ * table is direct mapped (a new transition replaces the one in its slot) and
+ * each stripe of slots is guarded by its own lock, so the cache can be shared
+ * by several threads.
+ */
+class TransitionCache {
+private:
+	struct Entry {
+		bool valid;
+		STATE_TYPE state_id;
+		int action;
+		int bucket;
+		OBS_TYPE last_obs;
+
+		STATE_TYPE next_state_id;
+		double reward;
+		OBS_TYPE obs;
+		bool terminal;
+	};
+
+	const DSPOMDP* model_;
+	int random_buckets_;
+
+	mutable std::vector<Entry> entries_;
+	mutable std::vector<std::mutex> locks_;
+
+	mutable std::atomic<long long> hits_;
+	mutable std::atomic<long long> misses_;
+
+	size_t Slot(STATE_TYPE state_id, int action, int bucket,
+		OBS_TYPE last_obs) const;
+
+public:
+	TransitionCache(const DSPOMDP* model, int capacity,
+		int random_buckets = 65536, int num_stripes = 64);
+
+	/**
+	 * Same as DSPOMDP::Step, the transition is taken from the cache when it is
+	 * there and is stepped by the model and inserted otherwise.
+	 */
+	bool Step(State& state, double random_num, int action, OBS_TYPE lastObs,
+		double& reward, OBS_TYPE& obs) const;
+
+	/**
+	 * Same as DSPOMDP::StepBatch through the cache.
+	 */
+	void StepBatch(const std::vector<State*>& particles,
+		const std::vector<double>& randomNums, int action,
+		const std::vector<OBS_TYPE>& lastObs, std::vector<double>& rewards,
+		std::vector<OBS_TYPE>& obs, std::vector<bool>& terminals) const;
+
+	/**
+	 * Removes all transitions (the statistics are kept).
+	 */
+	void Clear();
+
+	long long hits() const;
+	long long misses() const;
+	double HitRate() const;
+	void ResetStatistics();
+
+	void PrintStatistics(std::ostream& out) const;
+};
+
+} // namespace despot
+
+#endif
@@ -29,6 +29,12 @@ public:
 
 	virtual double Value(const std::vector<State*>& particles,
 		RandomStreams& streams, History& history) const = 0;
+
+	/**
+	 * Returns true if Value can be called from concurrent threads, as done by
+	 * DESPOT::ParallelTrials. Override this to opt in, the default is false.
+	 */
+	virtual bool IsThreadSafe() const;
 };
 
 /* =============================================================================
@@ -65,6 +71,8 @@ public:
 
 	virtual double Value(const std::vector<State*>& particles,
 		RandomStreams& streams, History& history) const;
+
+	virtual bool IsThreadSafe() const;
 };
 
 /* =============================================================================
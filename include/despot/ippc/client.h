@@ -2,12 +2,15 @@
 #define CLIENT_H_
 
 #include <cstring>      // Needed for memset
-//####include <unistd.h>
-//###include <sys/socket.h> // Needed for the socket functions
+#ifdef _WIN32
 #include <winsock2.h>
 #include <WS2tcpip.h>
+#else
+#include <unistd.h>
+#include <sys/socket.h> // Needed for the socket functions
+#include <netdb.h>      // Needed for the socket functions
+#endif
 #include <sys/types.h>
-//####include <netdb.h>      // Needed for the socket functions
 #include <vector>
 #include <string>
 #include <map>
@@ -47,6 +47,13 @@ public:
 	double Entry(int stream) const;
 	double Entry(int stream, int position) const;
 
+	/**
+	 * Drops the first entry of every sequence and appends a new random entry,
+	 * so that entry j becomes what entry j + 1 was. Keeps the scenarios of a
+	 * search tree reused one step deeper aligned with the sequences.
+	 */
+	void Shift();
+
 	friend std::ostream& operator<<(std::ostream& os, const RandomStreams& stream);
 };
 
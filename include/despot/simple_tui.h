@@ -52,6 +52,10 @@ enum OptionIndex {
   E_SERVER,
   E_PORT,
   E_LOG,
+  E_TRANSITION_CACHE,
+  E_SEARCH_THREADS,
+  E_EXPAND_THREADS,
+  E_REUSE_TREE,
 };
 
 // option::Arg::Required is a misnomer. The program won't complain if these
@@ -124,6 +128,18 @@ const option::Descriptor usage[] = {
   // solver for remaining runs." },
   { E_PRIOR, 0, "", "prior", option::Arg::Required, 
     "  \t--prior <arg>  \tPOMCP prior." },
+  { E_TRANSITION_CACHE, 0, "", "transition-cache", option::Arg::Required,
+    "  \t--transition-cache <arg>  \tNumber of cached transitions for "
+    "discrete-state models (default 0 = no cache)." },
+  { E_SEARCH_THREADS, 0, "", "search-threads", option::Arg::Required,
+    "  \t--search-threads <arg>  \tNumber of threads constructing the DESPOT "
+    "tree (default 1 = serial search)." },
+  { E_EXPAND_THREADS, 0, "", "expand-threads", option::Arg::Required,
+    "  \t--expand-threads <arg>  \tNumber of threads stepping particles in "
+    "DESPOT node expansion (default 1 = serial expansion)." },
+  { E_REUSE_TREE, 0, "", "reuse-tree", option::Arg::None,
+    "  \t--reuse-tree  \tStart each DESPOT search from the subtree of the "
+    "executed action and observation." },
   // { E_SERVER, 0, "", "server", option::Arg::Required, "  \t--server <arg>
   // \tServer address." },
   // { E_PORT, 0, "", "port", option::Arg::Required, "  \t--port <arg>  \tPort
@@ -1,6 +1,8 @@
 #ifndef DESPOT_H
 #define DESPOT_H
 
+#include <mutex>
+
 #include "../core/solver.h"
 #include "../core/pomdp.h"
 #include "../core/belief.h"
@@ -16,6 +18,11 @@ friend class VNode;
 
 protected:
 	VNode* root_;
+	// root_ is in arenas_[tree_arena_] and is released at once after each
+	// search, or kept until Update when the tree is reused (see
+	// Config::reuse_tree). The reused subtree is moved to the other arena
+	Arena arenas_[2];
+	int tree_arena_;
 	SearchStatistics statistics_;
 
 	ScenarioLowerBound* lower_bound_;
@@ -33,16 +40,59 @@ public:
 	ScenarioLowerBound* lower_bound() const;
 	ScenarioUpperBound* upper_bound() const;
 
+	// The nodes of the tree are created in arena if one is given
 	static VNode* ConstructTree(std::vector<State*>& particles, RandomStreams& streams,
+		ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
+		const DSPOMDP* model, History& history, double timeout,
+		SearchStatistics* statistics = NULL, Arena* arena = NULL);
+	// Run trials on a tree whose root bounds are initialized
+	static void ExtendTree(VNode* root, RandomStreams& streams,
 		ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
 		const DSPOMDP* model, History& history, double timeout,
 		SearchStatistics* statistics = NULL);
+	/**
+	 * Returns true if the model and both bounds declare they are thread-safe.
+	 * Otherwise the trials are run serially whatever
+	 * Globals::config.num_search_threads is.
+	 */
+	static bool SupportsParallelTrials(const DSPOMDP* model,
+		const ScenarioLowerBound* lower_bound,
+		const ScenarioUpperBound* upper_bound);
 
 protected:
+	bool CanReuseTree() const;
+	/**
+	 * Make the subtree of the executed action and observation the tree of the
+	 * next search, or release the tree if that subtree holds too few
+	 * particles.
+	 */
+	void RerootTree(int action, OBS_TYPE obs);
+	// Move the subtree one level up and normalize the particle weights of the
+	// new root (of total weight) together with the values they weigh
+	static void Reroot(VNode* vnode, double weight);
+	void ReleaseTree();
+
 	static VNode* Trial(VNode* root, RandomStreams& streams,
 		ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
 		const DSPOMDP* model, History& history, SearchStatistics* statistics =
 			NULL);
+
+	/**
+	 * Run trials on the tree from Globals::config.num_search_threads threads
+	 * until the timeout (wall time) is reached. The tree is guarded by one lock
+	 * that is released while a thread expands a node. The lower and upper
+	 * bounds and the model must be safe to call from concurrent threads (see
+	 * SupportsParallelTrials). Returns the number of trials.
+	 */
+	static int ParallelTrials(VNode* root, RandomStreams& streams,
+		ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
+		const DSPOMDP* model, History& history, double timeout,
+		SearchStatistics* statistics, double& used_time);
+	static VNode* ParallelTrial(VNode* root, std::unique_lock<std::mutex>& tree_lock,
+		RandomStreams& streams, ScenarioLowerBound* lower_bound,
+		ScenarioUpperBound* upper_bound, const DSPOMDP* model, History& history,
+		SearchStatistics& statistics);
+	static void ReleaseVirtualLoss(VNode* vnode);
 	static void InitLowerBound(VNode* vnode, ScenarioLowerBound* lower_bound,
 		RandomStreams& streams, History& history);
 	static void InitUpperBound(VNode* vnode, ScenarioUpperBound* upper_bound,
@@ -53,6 +103,15 @@ protected:
 	static void Expand(VNode* vnode,
 		ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
 		const DSPOMDP* model, RandomStreams& streams, History& history);
+	// Build the action children of vnode without attaching them to vnode
+	static void Expand(VNode* vnode, ActionChildren& children,
+		ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
+		const DSPOMDP* model, RandomStreams& streams, History& history);
+	// Expand with particles of all actions stepped in parallel chunks by
+	// Globals::config.num_expand_threads threads
+	static void ParallelExpand(VNode* vnode, ActionChildren& children,
+		ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
+		const DSPOMDP* model, RandomStreams& streams, History& history);
 	static void Backup(VNode* vnode);
 
 	static double Gap(VNode* vnode);
@@ -66,6 +125,19 @@ protected:
 	static void Expand(QNode* qnode, ScenarioLowerBound* lower_bound,
 		ScenarioUpperBound* upper_bound, const DSPOMDP* model,
 		RandomStreams& streams, History& history);
+	// Step copies of particles [begin, end) of the parent of qnode with the
+	// action of qnode. Sets copies[i] (NULL if terminal), rewards[i] (weighted)
+	// and obs[i]. Safe to call concurrently on disjoint ranges
+	static void Step(QNode* qnode, int begin, int end, const DSPOMDP* model,
+		const RandomStreams& streams, const History& history,
+		std::vector<State*>& copies, std::vector<double>& rewards,
+		std::vector<OBS_TYPE>& obs);
+	// Partition the stepped copies by observation and create the belief
+	// children of qnode
+	static void CreateChildren(QNode* qnode, const std::vector<State*>& copies,
+		const std::vector<double>& rewards, const std::vector<OBS_TYPE>& obs,
+		ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
+		const DSPOMDP* model, RandomStreams& streams, History& history);
 	static void Update(VNode* vnode);
 	static void Update(QNode* qnode);
 	static VNode* Prune(VNode* vnode, int& pruned_action, double& pruned_value);
@@ -68,6 +68,13 @@ public:
 
 	virtual void ComputePreference(const State& state) = 0;
 
+	/**
+	 * Add prior specific counters (e.g. cache hits) gathered since the last
+	 * call to the search statistics.
+	 */
+	inline virtual void CollectStatistics(SearchStatistics& statistics) {
+	}
+
 	const std::vector<int>& preferred_actions() const;
 	const std::vector<int>& legal_actions() const;
 
@@ -93,8 +100,13 @@ public:
 class POMCP: public Solver {
 protected:
 	VNode* root_;
+	// root_ is in arenas_[tree_arena_]; the subtree reused after an update is
+	// moved to the other arena before the tree arena is reset
+	Arena arenas_[2];
+	int tree_arena_;
 	POMCPPrior* prior_;
 	bool reuse_;
+	SearchStatistics statistics_;
 
 public:
 	POMCP(const DSPOMDP* model, POMCPPrior* prior, Belief* belief = NULL);
@@ -110,7 +122,7 @@ public:
 	void SaveTreeInFile(std::ofstream & out) const; // NATAN CHANGES
 
 	static VNode* CreateVNode(int depth, const State*, POMCPPrior* prior,
-		const DSPOMDP* model);
+		const DSPOMDP* model, Arena* arena = NULL);
 	static double Simulate(State* particle, VNode* root, const DSPOMDP* model,
 		POMCPPrior* prior);
 	static double Simulate(State* particle, RandomStreams& streams,
@@ -139,7 +151,7 @@ public:
 	virtual ValuedAction Search(double timeout);
 	static VNode* ConstructTree(std::vector<State*>& particles,
 		RandomStreams& streams, const DSPOMDP* model, POMCPPrior* prior,
-		History& history, double timeout);
+		History& history, double timeout, Arena* arena = NULL);
 
 	virtual void belief(Belief* b);
 	virtual void Update(int action, OBS_TYPE obs);
@@ -0,0 +1,106 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <new>
+
+namespace despot {
+
+/* =============================================================================
+ * Arena class
+ * =============================================================================*/
+/**
+ * Bump allocator for objects that are released together, such as the nodes of
+ * a search tree. Allocate hands out memory from large chunks and Reset makes
+ * all of it available again without running any destructor, so objects in an
+ * arena must not own memory outside it when the arena is reset. Chunks are
+ * kept across resets and freed when the arena is destroyed. Allocate is
+ * guarded by a mutex so concurrent search threads can share an arena.
+ */
+class Arena {
+private:
+	struct Chunk {
+		char* data;
+		std::size_t size;
+	};
+
+	std::vector<Chunk> chunks_;
+	int current_; // chunk allocations are made from
+	std::size_t offset_; // first free byte in the current chunk
+	std::size_t chunk_size_;
+	std::size_t num_bytes_;
+	std::mutex lock_;
+
+public:
+	Arena(std::size_t chunk_size = 1 << 20);
+	~Arena();
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void* Allocate(std::size_t size, std::size_t alignment);
+
+	/**
+	 * Release everything allocated in the arena at once.
+	 */
+	void Reset();
+
+	std::size_t num_bytes() const; // Bytes allocated since the last reset
+};
+
+/* =============================================================================
+ * ArenaAllocator class
+ * =============================================================================*/
+/**
+ * Standard library allocator drawing from an arena, or from the heap when no
+ * arena is given. Memory taken from an arena is only given back by resetting
+ * the arena.
+ */
+template<class T>
+class ArenaAllocator {
+private:
+	Arena* arena_;
+
+public:
+	typedef T value_type;
+
+	ArenaAllocator(Arena* arena = NULL) :
+		arena_(arena) {
+	}
+
+	template<class U>
+	ArenaAllocator(const ArenaAllocator<U>& other) :
+		arena_(other.arena()) {
+	}
+
+	Arena* arena() const {
+		return arena_;
+	}
+
+	T* allocate(std::size_t n) {
+		if (arena_ == NULL)
+			return static_cast<T*>(::operator new(n * sizeof(T)));
+		return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* p, std::size_t /* n */) {
+		if (arena_ == NULL)
+			::operator delete(p);
+	}
+};
+
+template<class T, class U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+	return a.arena() == b.arena();
+}
+
+template<class T, class U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+	return a.arena() != b.arena();
+}
+
+} // namespace despot
+
+#endif
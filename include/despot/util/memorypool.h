@@ -4,6 +4,7 @@
 #include <cassert>
 #include <vector>
 #include <ostream>
+#include <mutex>
 
 namespace despot {
 
@@ -23,6 +24,8 @@ private:
 	bool allocated_;
 };
 
+// Allocate and Free are guarded by a mutex so particles can be copied and freed
+// by concurrent search threads
 template<class T>
 class MemoryPool {
 public:
@@ -45,6 +48,7 @@ public:
 	}
 
 	T* Allocate() {
+		std::lock_guard<std::mutex> guard(lock_);
 		if (freelist_.empty())
 			NewChunk();
 		T* obj = freelist_.back();
@@ -56,6 +60,7 @@ public:
 	}
 
 	void Free(T* obj) {
+		std::lock_guard<std::mutex> guard(lock_);
 		assert(obj->IsAllocated());
 		obj->ClearAllocated();
 		freelist_.push_back(obj);
@@ -63,6 +68,7 @@ public:
 	}
 
 	void DeleteAll() {
+		std::lock_guard<std::mutex> guard(lock_);
 		for (chunk_iterator_ i_chunk = chunks_.begin();
 			i_chunk != chunks_.end(); ++i_chunk)
 			delete *i_chunk;
@@ -92,6 +98,7 @@ private:
 
 	std::vector<Chunk*> chunks_;
 	std::vector<T*> freelist_;
+	std::mutex lock_;
 	typedef typename std::vector<Chunk*>::iterator chunk_iterator_;
 
 public:
@@ -0,0 +1,60 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace despot {
+
+/* =============================================================================
+ * ThreadPool class
+ * =============================================================================*/
+/**
+ * Fixed set of worker threads running batches of indexed tasks. Run hands out
+ * the task indices of a batch to the workers and the calling thread, and
+ * returns when all the tasks of the batch are done. Batches are run one at a
+ * time, Run is meant to be called from a single thread.
+ */
+class ThreadPool {
+private:
+	std::vector<std::thread> workers_;
+	std::mutex lock_;
+	std::condition_variable batch_ready_;
+	std::condition_variable batch_done_;
+
+	const std::function<void(int)>* task_;
+	int num_tasks_;
+	int next_task_;
+	int num_running_;
+	int batch_id_;
+	bool stop_;
+
+	void WorkerLoop();
+	// Run tasks of the current batch until none are left. Called with lock held
+	void RunTasks(std::unique_lock<std::mutex>& lock);
+
+public:
+	/**
+	 * Create a pool running batches on num_threads threads (including the
+	 * thread calling Run).
+	 */
+	ThreadPool(int num_threads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int NumThreads() const;
+
+	/**
+	 * Call task(i) for i in [0, num_tasks) and wait for all the calls to return.
+	 */
+	void Run(int num_tasks, const std::function<void(int)>& task);
+};
+
+} // namespace despot
+
+#endif
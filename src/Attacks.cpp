@@ -43,7 +43,7 @@ inline std::pair<double, double> operator+(std::pair<double, double> & a, std::p
 	return ret;
 }
 
-inline double Distance(std::pair<double, double> & a, std::pair<double, double> & b)
+inline double Distance(const std::pair<double, double> & a, const std::pair<double, double> & b)
 {
 	std::pair<double, double> diff = std::make_pair(a.first - b.first, a.second - b.second);
 	return sqrt(diff.first * diff.first + diff.second * diff.second);
@@ -60,6 +60,7 @@ inline void Swap(int &a, int &b)
 DirectAttack::DirectAttack(double range, double pHit)
 	: m_range(range)
 	, m_pHit(pHit)
+	, m_windowRadius(static_cast<int>(range))
 {
 }
 
@@ -88,6 +89,78 @@ void DirectAttack::AttackOnline(int attackerLoc, int targetLoc, intVec & state,
 	return;
 }
 
+void DirectAttack::AttackOnline(int attackerLoc, int targetLoc, int * state, int stateSize, const intVec & shelterLoc, int gridSize, double random, const AttackTable * table) const
+{
+	// without table (or with target out of grid) calculate attack on state vector
+	bool inTable = (table != nullptr) && (table->GetGridSize() == gridSize);
+	if (!inTable | (targetLoc < 0) | (targetLoc >= gridSize * gridSize))
+	{
+		intVec stateVec(state, state + stateSize);
+		intVec shelters(shelterLoc);
+		AttackOnline(attackerLoc, targetLoc, stateVec, shelters, gridSize, random);
+		std::copy(stateVec.begin(), stateVec.end(), state);
+		return;
+	}
+
+	// tables given to the attack are created by CreateAttackTable
+	const LinesTable & linesTable = static_cast<const LinesTable &>(*table);
+	const LineOfFire * line = FindLineOfFire(linesTable, attackerLoc, targetLoc, gridSize);
+	if (line == nullptr)
+		return;
+
+	// walk on line of fire until the shot hits shelter, object or range limit
+	for (int c = 0; c < line->m_numCells; ++c)
+	{
+		const ShotCell & cell = linesTable.m_shotCells[line->m_firstCell + c];
+		if (SearchForShelter(shelterLoc, cell.m_location))
+		{
+			ResolveShot(cell, -1, state, stateSize, shelterLoc, gridSize, random);
+			return;
+		}
+
+		for (int o = 0; o < stateSize; ++o)
+		{
+			if (state[o] == cell.m_location)
+			{
+				ResolveShot(cell, o, state, stateSize, shelterLoc, gridSize, random);
+				return;
+			}
+		}
+	}
+
+	if (line->m_rangeEnd)
+		ResolveShot(linesTable.m_shotCells[line->m_firstCell + line->m_numCells - 1], -1, state, stateSize, shelterLoc, gridSize, random);
+}
+
+std::shared_ptr<const AttackTable> DirectAttack::CreateAttackTable(int gridSize) const
+{
+	int windowSize = 2 * m_windowRadius + 1;
+	int numLocations = gridSize * gridSize;
+	std::shared_ptr<LinesTable> table = std::make_shared<LinesTable>(gridSize);
+	table->m_linesOfFire.assign((numLocations + 1) * windowSize * windowSize, LineOfFire{ 0, 0, false });
+
+	// attacker location == numLocations is a dead attacker
+	for (int a = 0; a <= numLocations; ++a)
+	{
+		Coordinate attacker(a % gridSize, a / gridSize);
+		for (int yDiff = -m_windowRadius; yDiff <= m_windowRadius; ++yDiff)
+		{
+			for (int xDiff = -m_windowRadius; xDiff <= m_windowRadius; ++xDiff)
+			{
+				Coordinate target(attacker.X() + xDiff, attacker.Y() + yDiff);
+				double dist = target.RealDistance(attacker);
+				if (InFrame(target, gridSize) & dist <= m_range & dist > 0)
+				{
+					int lineIdx = a * windowSize * windowSize + (yDiff + m_windowRadius) * windowSize + xDiff + m_windowRadius;
+					InitLineOfFire(attacker, target, gridSize, table->m_linesOfFire[lineIdx], table->m_shotCells);
+				}
+			}
+		}
+	}
+
+	return table;
+}
+
 void DirectAttack::AttackOffline(int attackerLoc, int targetLoc, intVec & state, intVec & shelters, int gridSize, shootOutcomes & result) const
 {
 	Coordinate attacker(attackerLoc % gridSize, attackerLoc / gridSize);
@@ -205,32 +278,17 @@ void DirectAttack::CalcChanges(Coordinate obj1, Coordinate obj2, std::pair<doubl
 
 double DirectAttack::CalcDiversion(intVec & state, intVec & shelters, Coordinate & hit, int gridSize, Coordinate &  prevShotLocation, shootOutcomes & result) const
 {
-	Coordinate sides[4];
-	for (size_t i = 0; i < 4; ++i)
-		sides[i] = hit;
-
-	++sides[0].X();
-	--sides[1].X();
-	++sides[2].Y();
-	--sides[3].Y();
-
-	std::vector<std::pair<double, int>> dist;
-	for (size_t i = 0; i < 4; ++i)
-	{
-		if (sides[i] != prevShotLocation)
-			dist.emplace_back(std::make_pair(sides[i].RealDistance(prevShotLocation), i));
-	}
-
-	std::sort(dist.begin(), dist.end());
+	int diversions[NUM_DIVERSIONS];
+	FindDiversions(hit, prevShotLocation, gridSize, diversions);
 
 	double outOfFrame = 0.0;
 	for (size_t i = 0; i < NUM_DIVERSIONS; ++i)
 	{
 		intVec newState(state);
 		double pDiverge = (1 - m_pHit) / NUM_DIVERSIONS;
-		if ( InFrame(sides[dist[i].second], gridSize) )
+		if (diversions[i] >= 0)
 		{
-			int divLocation = sides[dist[i].second].X() + sides[dist[i].second].Y() * gridSize;
+			int divLocation = diversions[i];
 			auto v = newState.begin();
 			for (; v != newState.end() ; ++v)
 			{
@@ -258,12 +316,127 @@ double DirectAttack::CalcDiversion(intVec & state, intVec & shelters, Coordinate
 	return outOfFrame;
 }
 
+void DirectAttack::FindDiversions(Coordinate & hit, Coordinate & prevShotLocation, int gridSize, int * diversions)
+{
+	Coordinate sides[4];
+	for (size_t i = 0; i < 4; ++i)
+		sides[i] = hit;
+
+	++sides[0].X();
+	--sides[1].X();
+	++sides[2].Y();
+	--sides[3].Y();
+
+	std::vector<std::pair<double, int>> dist;
+	for (size_t i = 0; i < 4; ++i)
+	{
+		if (sides[i] != prevShotLocation)
+			dist.emplace_back(std::make_pair(sides[i].RealDistance(prevShotLocation), i));
+	}
+
+	std::sort(dist.begin(), dist.end());
+
+	for (size_t i = 0; i < NUM_DIVERSIONS; ++i)
+	{
+		Coordinate & side = sides[dist[i].second];
+		diversions[i] = InFrame(side, gridSize) ? side.X() + side.Y() * gridSize : -1;
+	}
+}
+
+void DirectAttack::InitLineOfFire(Coordinate & attacker, Coordinate & target, int gridSize, LineOfFire & line, std::vector<ShotCell> & shotCells) const
+{
+	// walk on the shot line the same way as CalcAttackResult (without objects and shelters)
+	std::pair<double, double> change;
+	CalcChanges(attacker, target, change);
+
+	std::pair<double, double> selfLocation(attacker.X(), attacker.Y());
+	std::pair<double, double> currLocation(attacker.X(), attacker.Y());
+	Coordinate prevLocation(attacker);
+	Coordinate location;
+
+	line.m_firstCell = shotCells.size();
+	line.m_rangeEnd = false;
+	while (prevLocation != target & !line.m_rangeEnd)
+	{
+		prevLocation = currLocation;
+		currLocation += change;
+		location = currLocation;
+
+		ShotCell cell;
+		cell.m_location = currLocation.first + currLocation.second * gridSize;
+		FindDiversions(location, prevLocation, gridSize, cell.m_diversions);
+		shotCells.emplace_back(cell);
+
+		std::pair<double, double> nextLocation = currLocation + change;
+		line.m_rangeEnd = Distance(selfLocation, nextLocation) > m_range;
+	}
+
+	line.m_numCells = shotCells.size() - line.m_firstCell;
+}
+
+const DirectAttack::LineOfFire * DirectAttack::FindLineOfFire(const LinesTable & table, int attackerLoc, int targetLoc, int gridSize) const
+{
+	int xDiff = targetLoc % gridSize - attackerLoc % gridSize;
+	int yDiff = targetLoc / gridSize - attackerLoc / gridSize;
+	if ((Abs(xDiff) > m_windowRadius) | (Abs(yDiff) > m_windowRadius))
+		return nullptr;
+
+	int windowSize = 2 * m_windowRadius + 1;
+	const LineOfFire & line = table.m_linesOfFire[attackerLoc * windowSize * windowSize + (yDiff + m_windowRadius) * windowSize + xDiff + m_windowRadius];
+	
+	// target is not in range
+	if (line.m_numCells == 0)
+		return nullptr;
+
+	return &line;
+}
+
+void DirectAttack::ResolveShot(const ShotCell & cell, int hitObj, int * state, int stateSize, const intVec & shelters, int gridSize, double random) const
+{
+	// outcomes are by the same order of CalcAttackResult: diversions, miss and hit
+	double outOfFrame = 0.0;
+	for (size_t i = 0; i < NUM_DIVERSIONS; ++i)
+	{
+		double pDiverge = (1 - m_pHit) / NUM_DIVERSIONS;
+		int divObj = -1;
+		if (cell.m_diversions[i] >= 0)
+		{
+			for (int o = 0; o < stateSize & divObj < 0; ++o)
+				divObj = state[o] == cell.m_diversions[i] ? o : -1;
+		}
+
+		if (divObj >= 0 && !SearchForShelter(shelters, cell.m_diversions[i]))
+		{
+			random -= pDiverge;
+			if (random <= 0.0)
+			{
+				state[divObj] = gridSize * gridSize;
+				return;
+			}
+		}
+		else
+			outOfFrame += pDiverge;
+	}
+
+	// shot that hits nothing does not change state
+	if (hitObj < 0)
+		return;
+
+	random -= outOfFrame;
+	if (random <= 0.0)
+		return;
+
+	random -= m_pHit;
+	if (random <= 0.0)
+		state[hitObj] = gridSize * gridSize;
+}
+
 bool DirectAttack::InFrame(Coordinate point, int gridSize)
 {
 	return (point.X() >= 0) & (point.X() < gridSize) & (point.Y() >= 0) & (point.Y() < gridSize);
 }
 
-bool DirectAttack::SearchForShelter(intVec shelters, int location)
+bool DirectAttack::SearchForShelter(const intVec & shelters, int location)
 {
 	for (auto v : shelters)
 	{
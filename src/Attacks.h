@@ -3,9 +3,23 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 
 #include "Coordinate.h"
 
+/// attack data precomputed for one grid size. the table is created by the attack and owned by the model using it
+/// so models of different grid sizes can share an attack
+class AttackTable
+{
+public:
+	explicit AttackTable(int gridSize) : m_gridSize(gridSize) {};
+	virtual ~AttackTable() = default;
+
+	int GetGridSize() const { return m_gridSize; };
+
+private:
+	int m_gridSize;
+};
 
 /// basic attack for attack object
 class Attack
@@ -19,8 +33,13 @@ public:
 	virtual ~Attack() = default;
 
 	virtual void AttackOnline(int attackerLoc, int targetLoc, intVec & state, intVec & shelterLoc, int gridSize, double random) const = 0;
+	/// calculation of attack for online solver on state array (in size of stateSize). table is used when it is created for gridSize
+	virtual void AttackOnline(int attackerLoc, int targetLoc, int * state, int stateSize, const intVec & shelterLoc, int gridSize, double random, const AttackTable * table) const = 0;
 	virtual void AttackOffline(int attackerLoc, int targetLoc, intVec & state, intVec & shelterLoc, int gridSize, shootOutcomes & result) const = 0;
 	
+	/// precompute attack data for a given grid size
+	virtual std::shared_ptr<const AttackTable> CreateAttackTable(int gridSize) const = 0;
+	
 	virtual bool InRange(int location, int otheObjLocation, int gridSize) const = 0;
 	virtual double GetRange() const = 0;
 	virtual double GetPHit() const = 0;
@@ -35,27 +54,67 @@ public:
 	~DirectAttack() = default;
 
 	virtual void AttackOnline(int attackerLoc, int targetLoc, intVec & state, intVec & shelterLoc, int gridSize, double random) const override;
+	virtual void AttackOnline(int attackerLoc, int targetLoc, int * state, int stateSize, const intVec & shelterLoc, int gridSize, double random, const AttackTable * table) const override;
 	virtual void AttackOffline(int attackerLoc, int targetLoc, intVec & state, intVec & shelterLoc, int gridSize, shootOutcomes & result) const override;
 	
+	/// precompute the line of fire of each attacker and target in range
+	virtual std::shared_ptr<const AttackTable> CreateAttackTable(int gridSize) const override;
+	
 	virtual bool InRange(int location, int otheObjLocation, int gridSize) const;
 	virtual double GetRange() const { return m_range; };
 	virtual double GetPHit() const { return m_pHit; };
 
 	virtual std::string String() const override;
 private:
+	static const int NUM_DIVERSIONS = 2;
+
+	/// cell in line of fire and its diversion cells by order (-1 for diversion out of frame)
+	struct ShotCell
+	{
+		int m_location;
+		int m_diversions[NUM_DIVERSIONS];
+	};
+
+	/// line of fire from attacker to target (cells are ordered from attacker)
+	struct LineOfFire
+	{
+		int m_firstCell;
+		int m_numCells;
+		/// true if the shot ends in range limit at the last cell (o.w. the shot passes the target without outcome)
+		bool m_rangeEnd;
+	};
+
+	/// lines of fire for each attacker (including dead attacker) and target in window of range (idx = attacker * windowSize^2 + target offset)
+	class LinesTable : public AttackTable
+	{
+	public:
+		explicit LinesTable(int gridSize) : AttackTable(gridSize), m_linesOfFire(), m_shotCells() {};
+		std::vector<LineOfFire> m_linesOfFire;
+		std::vector<ShotCell> m_shotCells;
+	};
+
 	// return result of attacks given attacker, target, locations and grid size
 	void CalcAttackResult(Coordinate & attacker, Coordinate & target, intVec state, intVec shelters, int gridSize, shootOutcomes & result) const;
 
 	static void CalcChanges(Coordinate obj1, Coordinate obj2, std::pair<double, double> & change);
 	double CalcDiversion(intVec & state, intVec & shelters, Coordinate & hit, int gridSize, Coordinate & prevShotLocation, shootOutcomes & result) const;
+	/// find diversion locations of a hit by order (-1 for diversion out of frame)
+	static void FindDiversions(Coordinate & hit, Coordinate & prevShotLocation, int gridSize, int * diversions);
+
+	/// insert line of fire cells to table
+	void InitLineOfFire(Coordinate & attacker, Coordinate & target, int gridSize, LineOfFire & line, std::vector<ShotCell> & shotCells) const;
+	/// return line of fire from table (nullptr if target is out of range)
+	const LineOfFire * FindLineOfFire(const LinesTable & table, int attackerLoc, int targetLoc, int gridSize) const;
+	/// update state according to shot outcome in cell (hitObj = -1 when no object is hit) and random number
+	void ResolveShot(const ShotCell & cell, int hitObj, int * state, int stateSize, const intVec & shelters, int gridSize, double random) const;
 
 	static bool InFrame(Coordinate point, int gridSize);
-	static bool SearchForShelter(intVec shelters, int location);
+	static bool SearchForShelter(const intVec & shelters, int location);
 
 	double m_range;
 	double m_pHit;
-	
-	static const int NUM_DIVERSIONS = 2;
+
+	int m_windowRadius;
 };
 
 # endif //ATTACKS_H
\ No newline at end of file
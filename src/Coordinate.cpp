@@ -1,5 +1,7 @@
 #include "Coordinate.h"
 
+#include <cmath>		// sqrt
+
 Coordinate::Coordinate(int x, int y)
 : m_x(x)
 , m_y(y)
@@ -10,7 +10,7 @@ const Coordinate & ObjInGrid::GetLocation() const
 	return m_location;
 }
 
-void ObjInGrid::SetLocation(Coordinate & newLocation)
+void ObjInGrid::SetLocation(const Coordinate & newLocation)
 {
 	m_location = newLocation;
 }
@@ -16,7 +16,7 @@ public:
 	/// Get location of object
 	const Coordinate &GetLocation() const;
 	/// Set location of object
-	void SetLocation(Coordinate &newLocation);
+	void SetLocation(const Coordinate &newLocation);
 	
 	/// write object to file
 	friend std::ofstream& operator<<(std::ofstream& out, const ObjInGrid& obj);
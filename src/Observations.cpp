@@ -1,6 +1,7 @@
 #include "Observations.h"
 #include "Coordinate.h"
 
+#include <cmath>		// sqrt
 #include <string>
 
 // constant for 
@@ -19,7 +20,7 @@ bool ObservationByDistance::InRange(int selfLoc, int obsObjLoc, int gridSize) co
 	return true;
 }
 
-double ObservationByDistance::GetProbObservation(int selfLoc, int objLoc, int gridSize, int observation) const
+double ObservationByDistance::GetProbObservation(int selfLoc, int objLoc, int gridSize, int observation, const ObservationTable * table) const
 {
 	// TODO: implement probability of divergence
 
@@ -32,6 +33,79 @@ double ObservationByDistance::GetProbObservation(int selfLoc, int objLoc, int gr
 	if (objLoc == gridSize * gridSize)
 		return 1.0 * (observation == gridSize * gridSize);
 
+	// the table holds only live self locations (dead self is calculated)
+	const ProbTable * probTable = TableOfGrid(table, gridSize);
+	bool inTable = (probTable != nullptr) & (selfLoc < gridSize * gridSize);
+	double pSuccess = inTable ? probTable->m_pSuccess[selfLoc * gridSize * gridSize + objLoc] : CalcPSuccess(selfLoc, objLoc, gridSize);
+
+	return pSuccess * (observation == objLoc) + (1 - pSuccess) * (observation == nonObsLoc);
+}
+
+double ObservationByDistance::GetProbObservationState(const int * state, const int * obsState, int size, int gridSize, const ObservationTable * table) const
+{
+	int deadLoc = gridSize * gridSize;
+	int selfLoc = state[0];
+	const ProbTable * probTable = TableOfGrid(table, gridSize);
+	// without table (or with dead self) calculate each object seperately
+	if ((probTable == nullptr) | (selfLoc >= deadLoc))
+	{
+		double pObs = 1.0;
+		for (int i = 1; i < size & pObs > 0.0; ++i)
+			pObs *= GetProbObservation(selfLoc, state[i], gridSize, obsState[i]);
+
+		return pObs;
+	}
+
+	const double * pSuccessSelf = &probTable->m_pSuccess[selfLoc * deadLoc];
+	double pObs = 1.0;
+	for (int i = 1; i < size; ++i)
+	{
+		int objLoc = state[i];
+		int observation = obsState[i];
+		// dead object is allways observed as dead, o.w. the object is observed in its location or in self location (non-observed)
+		if (objLoc == deadLoc)
+		{
+			pObs *= 1.0 * (observation == deadLoc);
+		}
+		else
+		{
+			double pSuccess = pSuccessSelf[objLoc];
+			pObs *= pSuccess * (observation == objLoc) + (1 - pSuccess) * (observation == selfLoc);
+		}
+
+		if (pObs == 0.0)
+			return 0.0;
+	}
+
+	return pObs;
+}
+
+std::shared_ptr<const ObservationTable> ObservationByDistance::CreateProbTable(int gridSize) const
+{
+	int numLocations = gridSize * gridSize;
+	std::shared_ptr<ProbTable> table = std::make_shared<ProbTable>(gridSize);
+	table->m_pSuccess.resize(numLocations * numLocations);
+
+	for (int self = 0; self < numLocations; ++self)
+	{
+		for (int obj = 0; obj < numLocations; ++obj)
+			table->m_pSuccess[self * numLocations + obj] = CalcPSuccess(self, obj, gridSize);
+	}
+
+	return table;
+}
+
+const ObservationByDistance::ProbTable * ObservationByDistance::TableOfGrid(const ObservationTable * table, int gridSize)
+{
+	// tables given to the observation are created by CreateProbTable
+	if ((table == nullptr) || (table->GetGridSize() != gridSize))
+		return nullptr;
+
+	return static_cast<const ProbTable *>(table);
+}
+
+double ObservationByDistance::CalcPSuccess(int selfLoc, int objLoc, int gridSize) const
+{
 	Coordinate self(selfLoc % gridSize, selfLoc / gridSize);
 	Coordinate obj(objLoc % gridSize, objLoc / gridSize);
 
@@ -40,9 +114,7 @@ double ObservationByDistance::GetProbObservation(int selfLoc, int objLoc, int gr
 	double ratio = dist / (s_SQRT2 * gridSize);
 
 	// calculate prob to success observation
-	double pSuccess = ratio * m_distanceFactor + (1 - ratio);
-
-	return pSuccess * (observation == objLoc) + (1 - pSuccess) * (observation == nonObsLoc);
+	return ratio * m_distanceFactor + (1 - ratio);
 }
 
 int ObservationByDistance::GetObservationObject(int selfLoc, int objLoc, int gridSize, double randomNum) const
@@ -80,6 +152,21 @@ void ObservationByDistance::InitObsAvailableLocations(int selfLoc, int objLoc, c
 		observableLocations.emplace_back(selfLoc);
 }
 
+int ObservationByDistance::InitObsAvailableLocations(int selfLoc, int objLoc, int gridSize, int * observableLocations) const
+{
+	//TODO: until divergence insertion only 2 possible location (observed and non-observed)
+	observableLocations[0] = objLoc;
+
+	// insert non-observed location if the object is not dead
+	if (objLoc != gridSize * gridSize)
+	{
+		observableLocations[1] = selfLoc;
+		return 2;
+	}
+
+	return 1;
+}
+
 std::string ObservationByDistance::String() const
 {
 	std::string ret = "Observation by distance: distance factor = ";
@@ -2,12 +2,29 @@
 #define OBSERVATIONS_H
 
 #include <vector>
+#include <memory>
+
+/// observation data precomputed for one grid size. the table is created by the observation and owned by the model using it
+/// so models of different grid sizes can share an observation
+class ObservationTable
+{
+public:
+	explicit ObservationTable(int gridSize) : m_gridSize(gridSize) {};
+	virtual ~ObservationTable() = default;
+
+	int GetGridSize() const { return m_gridSize; };
+
+private:
+	int m_gridSize;
+};
 
 /// abstract observation class
 class Observation
 {
 public:
 	using intVec = std::vector<int>;
+	/// max num of available observation locations of one object
+	static const int MAX_OBSERVABLE_LOCATIONS = 2;
 
 	explicit Observation() = default;
 	virtual ~Observation() = default;
@@ -15,11 +32,19 @@ public:
 	/// return true if observed location is in range of self object
 	virtual bool InRange(int selfLoc, int obsObjLoc, int gridSize) const = 0;
 	/// get probability for observation given observing object location(self loc), observed object location(objLoc) grid size and observation
-	virtual double GetProbObservation(int selfLoc, int objLoc, int gridSize, int observation) const = 0;
+	/// (table is used when it is created for gridSize)
+	virtual double GetProbObservation(int selfLoc, int objLoc, int gridSize, int observation, const ObservationTable * table = nullptr) const = 0;
 	/// get observation given locations, grid size and random number
 	virtual int GetObservationObject(int selfLoc, int objLoc, int gridSize, double randomNum) const = 0;
 	/// initialize available locations of observation given locations and grid size
 	virtual void InitObsAvailableLocations(int selfLoc, int objLoc, const intVec & state, int gridSize, intVec & observableLocations) const = 0;
+	/// initialize available locations of observation in array (in size of MAX_OBSERVABLE_LOCATIONS) return num of available locations
+	virtual int InitObsAvailableLocations(int selfLoc, int objLoc, int gridSize, int * observableLocations) const = 0;
+
+	/// precompute observation probabilities for a given grid size
+	virtual std::shared_ptr<const ObservationTable> CreateProbTable(int gridSize) const = 0;
+	/// get probability for observation of all objects given state (self location first) and observed state (table is used when it is created for gridSize)
+	virtual double GetProbObservationState(const int * state, const int * obsState, int size, int gridSize, const ObservationTable * table) const = 0;
 
 	virtual std::string String() const = 0;
 };
@@ -30,12 +55,29 @@ public:
 	explicit ObservationByDistance(double distanceFactor, double nonObserved = 1.0);
 
 	virtual bool InRange(int selfLoc, int obsObjLoc, int gridSize) const;
-	virtual double GetProbObservation(int selfLoc, int objLoc, int gridSize, int observation) const override;
+	virtual double GetProbObservation(int selfLoc, int objLoc, int gridSize, int observation, const ObservationTable * table = nullptr) const override;
 	virtual int GetObservationObject(int selfLoc, int objLoc, int gridSize, double randomNum) const override;
 	virtual void InitObsAvailableLocations(int selfLoc, int objLoc, const intVec & state, int gridSize, intVec & observableLocations) const override;
+	virtual int InitObsAvailableLocations(int selfLoc, int objLoc, int gridSize, int * observableLocations) const override;
+
+	virtual std::shared_ptr<const ObservationTable> CreateProbTable(int gridSize) const override;
+	virtual double GetProbObservationState(const int * state, const int * obsState, int size, int gridSize, const ObservationTable * table) const override;
 
 	virtual std::string String() const override;
 private:
+	/// probability of success observation for each (selfLoc, objLoc) (idx = selfLoc * gridSize^2 + objLoc)
+	class ProbTable : public ObservationTable
+	{
+	public:
+		explicit ProbTable(int gridSize) : ObservationTable(gridSize), m_pSuccess() {};
+		std::vector<double> m_pSuccess;
+	};
+
+	/// calculate probability to observe object in its location given self location
+	double CalcPSuccess(int selfLoc, int objLoc, int gridSize) const;
+	/// return the table if it is created for gridSize (nullptr o.w.)
+	static const ProbTable * TableOfGrid(const ObservationTable * table, int gridSize);
+
 	double m_distanceFactor;
 	double m_observationDivergence;
 	double m_nonObserved;
@@ -0,0 +1,526 @@
+#include "OfflineLUT.h"
+
+#include <fstream>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace despot
+{
+
+const char OfflineLUT::s_MAGIC[8] = { 'N', 'X', 'N', 'L', 'U', 'T', '\0', '\0' };
+const char OfflineLUT::s_COMPRESSED_MAGIC[8] = { 'N', 'X', 'N', 'L', 'U', 'T', 'Q', '\0' };
+
+static_assert(sizeof(OfflineLUT::Header) == 24, "lut header must keep keys 8 bytes aligned");
+static_assert(sizeof(OfflineLUT::CompressedHeader) == 40, "compressed lut header must keep blocks 8 bytes aligned");
+static_assert(sizeof(OfflineLUT::KeyBlock) == 16, "key block must be packed");
+
+/// round size up to multiple of 8
+inline size_t Align8(size_t size)
+{
+	return (size + 7) & ~static_cast<size_t>(7);
+}
+
+/// append num as varint (7 bits in each byte, high bit set when more bytes follow)
+static void WriteVarint(uint64_t num, std::vector<uint8_t> & stream)
+{
+	while (num >= 0x80)
+	{
+		stream.emplace_back(static_cast<uint8_t>(num | 0x80));
+		num >>= 7;
+	}
+	stream.emplace_back(static_cast<uint8_t>(num));
+}
+
+/// read varint from ptr and advance ptr
+inline uint64_t ReadVarint(const uint8_t * & ptr)
+{
+	uint64_t num = 0;
+	int shift = 0;
+	while (*ptr & 0x80)
+	{
+		num |= static_cast<uint64_t>(*ptr++ & 0x7f) << shift;
+		shift += 7;
+	}
+	num |= static_cast<uint64_t>(*ptr++) << shift;
+	return num;
+}
+
+/// return size of file in bytes (0 if the file cannot be opened)
+static size_t FileSize(const std::string & fName)
+{
+	std::ifstream in(fName, std::ios::in | std::ios::binary | std::ios::ate);
+	if (in.fail())
+		return 0;
+
+	return static_cast<size_t>(in.tellg());
+}
+
+/// return idx of first max value (as nxnGrid::FindMaxReward)
+static int ArgMax(const double * values, int size)
+{
+	return static_cast<int>(std::max_element(values, values + size) - values);
+}
+
+OfflineLUT::OfflineLUT(const lut_t & lut)
+{
+	Build(lut);
+}
+
+OfflineLUT::~OfflineLUT()
+{
+	Release();
+}
+
+void OfflineLUT::Build(const lut_t & lut)
+{
+	m_numStates = lut.size();
+	m_numActions = lut.empty() ? 0 : lut.begin()->second.size();
+
+	m_ownedKeys.reserve(m_numStates);
+	m_ownedValues.reserve(m_numStates * m_numActions);
+	// map is ordered so keys are inserted ascending
+	for (auto itr = lut.begin(); itr != lut.end(); ++itr)
+	{
+		if (itr->second.size() != m_numActions)
+		{
+			std::cerr << "lut rows must have the same num of actions\n";
+			exit(1);
+		}
+		m_ownedKeys.emplace_back(itr->first);
+		m_ownedValues.insert(m_ownedValues.end(), itr->second.begin(), itr->second.end());
+	}
+
+	m_keys = m_ownedKeys.data();
+	m_values = m_ownedValues.data();
+}
+
+bool OfflineLUT::Load(const std::string & fName)
+{
+	Release();
+
+	std::ifstream in(fName, std::ios::in | std::ios::binary);
+	if (in.fail())
+	{
+		std::cerr << "failed open lut file " << fName << "\n";
+		return false;
+	}
+
+	char magic[sizeof(s_MAGIC)];
+	in.read(magic, sizeof(magic));
+	if (in.gcount() == sizeof(magic) && (memcmp(magic, s_MAGIC, sizeof(magic)) == 0 || memcmp(magic, s_COMPRESSED_MAGIC, sizeof(magic)) == 0))
+	{
+		in.close();
+		return Map(fName);
+	}
+
+	// not a flat file - read old format
+	in.clear();
+	in.seekg(0, std::ios::beg);
+	return ReadOldFormat(in);
+}
+
+bool OfflineLUT::Write(const std::string & fName) const
+{
+	std::ofstream out(fName, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (out.fail())
+	{
+		std::cerr << "failed open lut file " << fName << " for write\n";
+		return false;
+	}
+
+	Header header;
+	memcpy(header.m_magic, s_MAGIC, sizeof(s_MAGIC));
+	header.m_version = s_VERSION;
+	header.m_numActions = m_numActions;
+	header.m_numStates = m_numStates;
+
+	out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+	out.write(reinterpret_cast<const char *>(m_keys), m_numStates * sizeof(STATE_TYPE));
+	out.write(reinterpret_cast<const char *>(m_values), m_numStates * m_numActions * sizeof(double));
+
+	if (out.bad())
+	{
+		std::cerr << "failed write lut file " << fName << "\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool OfflineLUT::Convert(const std::string & oldLutFName, const std::string & flatLutFName)
+{
+	OfflineLUT lut;
+	if (!lut.Load(oldLutFName))
+		return false;
+
+	return lut.Write(flatLutFName);
+}
+
+bool OfflineLUT::WriteCompressed(const std::string & fName, int bits) const
+{
+	if (IsCompressed() || (bits != 8 && bits != 16))
+	{
+		std::cerr << "compressed lut must be written from not compressed table with 8 or 16 bits\n";
+		return false;
+	}
+
+	// keys: the first key of each block is kept in the block table, the rest as varint deltas
+	std::vector<KeyBlock> blocks;
+	std::vector<uint8_t> keyStream;
+	for (uint64_t i = 0; i < m_numStates; ++i)
+	{
+		if (i % s_KEYS_PER_BLOCK == 0)
+			blocks.emplace_back(KeyBlock{ m_keys[i], keyStream.size() });
+		else
+			WriteVarint(static_cast<uint64_t>(m_keys[i] - m_keys[i - 1]), keyStream);
+	}
+	keyStream.resize(Align8(keyStream.size()), 0);
+
+	// rows: values of each row are quantized between the min and the max value of the row
+	int bytesPerValue = bits / 8;
+	uint32_t maxCode = (1u << bits) - 1;
+	size_t rowSize = 2 * sizeof(float) + m_numActions * bytesPerValue;
+	std::vector<char> rows(m_numStates * rowSize);
+	for (uint64_t i = 0; i < m_numStates; ++i)
+	{
+		const double * values = m_values + i * m_numActions;
+		char * row = rows.data() + i * rowSize;
+
+		float offset = static_cast<float>(*std::min_element(values, values + m_numActions));
+		float scale = static_cast<float>((*std::max_element(values, values + m_numActions) - offset) / maxCode);
+		memcpy(row, &offset, sizeof(float));
+		memcpy(row + sizeof(float), &scale, sizeof(float));
+
+		for (int a = 0; a < m_numActions; ++a)
+		{
+			double code = scale > 0.0f ? std::round((values[a] - offset) / scale) : 0.0;
+			uint32_t quantized = static_cast<uint32_t>(std::min(std::max(code, 0.0), static_cast<double>(maxCode)));
+			if (bits == 8)
+				row[2 * sizeof(float) + a] = static_cast<uint8_t>(quantized);
+			else
+			{
+				uint16_t quantized16 = static_cast<uint16_t>(quantized);
+				memcpy(row + 2 * sizeof(float) + a * sizeof(uint16_t), &quantized16, sizeof(uint16_t));
+			}
+		}
+	}
+
+	std::ofstream out(fName, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (out.fail())
+	{
+		std::cerr << "failed open lut file " << fName << " for write\n";
+		return false;
+	}
+
+	CompressedHeader header;
+	memcpy(header.m_magic, s_COMPRESSED_MAGIC, sizeof(s_COMPRESSED_MAGIC));
+	header.m_version = s_COMPRESSED_VERSION;
+	header.m_numActions = m_numActions;
+	header.m_numStates = m_numStates;
+	header.m_bits = bits;
+	header.m_numBlocks = static_cast<uint32_t>(blocks.size());
+	header.m_keyStreamSize = keyStream.size();
+
+	out.write(reinterpret_cast<const char *>(&header), sizeof(CompressedHeader));
+	out.write(reinterpret_cast<const char *>(blocks.data()), blocks.size() * sizeof(KeyBlock));
+	out.write(reinterpret_cast<const char *>(keyStream.data()), keyStream.size());
+	out.write(rows.data(), rows.size());
+
+	if (out.bad())
+	{
+		std::cerr << "failed write lut file " << fName << "\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool OfflineLUT::Compress(const std::string & lutFName, const std::string & compressedLutFName, int bits, CompressionReport & report)
+{
+	OfflineLUT original;
+	if (!original.Load(lutFName) || !original.WriteCompressed(compressedLutFName, bits))
+		return false;
+
+	OfflineLUT compressed;
+	if (!compressed.Load(compressedLutFName))
+		return false;
+
+	report.m_numStates = original.Size();
+	report.m_maxError = 0.0;
+	report.m_numArgmaxDisagree = 0;
+	// size of the file as given (flat or old format)
+	report.m_originalSize = FileSize(lutFName);
+	report.m_compressedSize = compressed.m_mapSize;
+
+	doubleVec values(original.NumActions());
+	for (uint64_t i = 0; i < original.Size(); ++i)
+	{
+		const double * originalValues = original.m_values + i * original.NumActions();
+		if (!compressed.Find(original.m_keys[i], values.data()))
+		{
+			std::cerr << "state " << original.m_keys[i] << " is missing in compressed lut\n";
+			return false;
+		}
+
+		for (int a = 0; a < original.NumActions(); ++a)
+			report.m_maxError = std::max(report.m_maxError, std::abs(values[a] - originalValues[a]));
+
+		report.m_numArgmaxDisagree += ArgMax(values.data(), original.NumActions()) != ArgMax(originalValues, original.NumActions());
+	}
+
+	return true;
+}
+
+bool OfflineLUT::Find(STATE_TYPE state, double * values) const
+{
+	if (m_numStates == 0)
+		return false;
+
+	if (IsCompressed())
+	{
+		int64_t rowIdx = FindCompressedRow(state);
+		if (rowIdx < 0)
+			return false;
+
+		const char * row = m_rows + rowIdx * m_rowSize;
+		float offset, scale;
+		memcpy(&offset, row, sizeof(float));
+		memcpy(&scale, row + sizeof(float), sizeof(float));
+		const char * quantized = row + 2 * sizeof(float);
+		for (int a = 0; a < m_numActions; ++a)
+		{
+			uint32_t code;
+			if (m_bits == 8)
+				code = static_cast<uint8_t>(quantized[a]);
+			else
+			{
+				uint16_t code16;
+				memcpy(&code16, quantized + a * sizeof(uint16_t), sizeof(uint16_t));
+				code = code16;
+			}
+			values[a] = static_cast<double>(offset) + static_cast<double>(scale) * code;
+		}
+
+		return true;
+	}
+
+	// branch free lower bound: the loop count depends only on the table size
+	const STATE_TYPE * base = m_keys;
+	uint64_t n = m_numStates;
+	while (n > 1)
+	{
+		uint64_t half = n / 2;
+		base = base[half] <= state ? base + half : base;
+		n -= half;
+	}
+
+	if (*base != state)
+		return false;
+
+	memcpy(values, m_values + (base - m_keys) * m_numActions, m_numActions * sizeof(double));
+	return true;
+}
+
+int64_t OfflineLUT::FindCompressedRow(STATE_TYPE state) const
+{
+	// last block with first key <= state
+	const KeyBlock * block = std::upper_bound(m_blocks, m_blocks + m_numBlocks, state, 
+		[](STATE_TYPE key, const KeyBlock & b) { return key < b.m_firstKey; });
+	if (block == m_blocks)
+		return -1;
+	--block;
+
+	// decode keys of the block until reaching state
+	uint64_t rowIdx = (block - m_blocks) * s_KEYS_PER_BLOCK;
+	uint64_t blockEnd = std::min(rowIdx + s_KEYS_PER_BLOCK, m_numStates);
+	STATE_TYPE key = block->m_firstKey;
+	const uint8_t * ptr = m_keyStream + block->m_offset;
+	while (key < state && rowIdx + 1 < blockEnd)
+	{
+		key += static_cast<STATE_TYPE>(ReadVarint(ptr));
+		++rowIdx;
+	}
+
+	return key == state ? static_cast<int64_t>(rowIdx) : -1;
+}
+
+void OfflineLUT::Release()
+{
+#ifdef _WIN32
+	if (m_mapAddr != nullptr)
+		UnmapViewOfFile(m_mapAddr);
+	if (m_mapHandle != nullptr)
+		CloseHandle(m_mapHandle);
+	if (m_fileHandle != nullptr)
+		CloseHandle(m_fileHandle);
+#else
+	if (m_mapAddr != nullptr)
+		munmap(m_mapAddr, m_mapSize);
+#endif
+	m_mapAddr = nullptr;
+	m_mapHandle = nullptr;
+	m_fileHandle = nullptr;
+	m_mapSize = 0;
+
+	m_ownedKeys.clear();
+	m_ownedValues.clear();
+
+	m_keys = nullptr;
+	m_values = nullptr;
+	m_numStates = 0;
+	m_numActions = 0;
+
+	m_bits = 0;
+	m_blocks = nullptr;
+	m_numBlocks = 0;
+	m_keyStream = nullptr;
+	m_rows = nullptr;
+	m_rowSize = 0;
+}
+
+bool OfflineLUT::Map(const std::string & fName)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "failed open lut file " << fName << "\n";
+		return false;
+	}
+	m_fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	m_mapSize = static_cast<size_t>(fileSize.QuadPart);
+
+	m_mapHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapHandle != nullptr)
+		m_mapAddr = MapViewOfFile(m_mapHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+	int fd = open(fName.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		std::cerr << "failed open lut file " << fName << "\n";
+		return false;
+	}
+
+	struct stat fileStat;
+	fstat(fd, &fileStat);
+	m_mapSize = fileStat.st_size;
+
+	void * addr = mmap(nullptr, m_mapSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	m_mapAddr = addr == MAP_FAILED ? nullptr : addr;
+#endif
+
+	if (m_mapAddr == nullptr)
+	{
+		std::cerr << "failed map lut file " << fName << "\n";
+		Release();
+		return false;
+	}
+
+	const char * data = static_cast<const char *>(m_mapAddr);
+	bool isCompressed = m_mapSize >= sizeof(s_COMPRESSED_MAGIC) && memcmp(data, s_COMPRESSED_MAGIC, sizeof(s_COMPRESSED_MAGIC)) == 0;
+	if (!(isCompressed ? ParseCompressed(data) : ParseFlat(data)))
+	{
+		std::cerr << "lut file " << fName << " is corrupted or of unknown version\n";
+		Release();
+		return false;
+	}
+
+	return true;
+}
+
+bool OfflineLUT::ParseFlat(const char * data)
+{
+	Header header;
+	memset(&header, 0, sizeof(Header));
+	if (m_mapSize >= sizeof(Header))
+		memcpy(&header, data, sizeof(Header));
+
+	size_t expectedSize = sizeof(Header) + header.m_numStates * (sizeof(STATE_TYPE) + header.m_numActions * sizeof(double));
+	if (header.m_version != s_VERSION || m_mapSize != expectedSize)
+		return false;
+
+	m_numStates = header.m_numStates;
+	m_numActions = header.m_numActions;
+	m_keys = reinterpret_cast<const STATE_TYPE *>(data + sizeof(Header));
+	m_values = reinterpret_cast<const double *>(data + sizeof(Header) + m_numStates * sizeof(STATE_TYPE));
+
+	return true;
+}
+
+bool OfflineLUT::ParseCompressed(const char * data)
+{
+	CompressedHeader header;
+	memset(&header, 0, sizeof(CompressedHeader));
+	if (m_mapSize >= sizeof(CompressedHeader))
+		memcpy(&header, data, sizeof(CompressedHeader));
+
+	size_t rowSize = 2 * sizeof(float) + header.m_numActions * (header.m_bits / 8);
+	size_t expectedSize = sizeof(CompressedHeader) + header.m_numBlocks * sizeof(KeyBlock) + header.m_keyStreamSize + header.m_numStates * rowSize;
+	if (header.m_version != s_COMPRESSED_VERSION || (header.m_bits != 8 && header.m_bits != 16) || m_mapSize != expectedSize)
+		return false;
+
+	m_numStates = header.m_numStates;
+	m_numActions = header.m_numActions;
+	m_bits = header.m_bits;
+	m_numBlocks = header.m_numBlocks;
+	m_rowSize = rowSize;
+	m_blocks = reinterpret_cast<const KeyBlock *>(data + sizeof(CompressedHeader));
+	m_keyStream = reinterpret_cast<const uint8_t *>(data + sizeof(CompressedHeader) + m_numBlocks * sizeof(KeyBlock));
+	m_rows = data + sizeof(CompressedHeader) + m_numBlocks * sizeof(KeyBlock) + header.m_keyStreamSize;
+
+	return true;
+}
+
+bool OfflineLUT::ReadOldFormat(std::ifstream & in)
+{
+	int size, numActions;
+	in.read(reinterpret_cast<char *>(&size), sizeof(int));
+	in.read(reinterpret_cast<char *>(&numActions), sizeof(int));
+	if (in.fail() || size < 0 || numActions < 0)
+	{
+		std::cerr << "failed read lut file header\n";
+		return false;
+	}
+
+	// read all rows at once
+	size_t rowSize = sizeof(int) + numActions * sizeof(double);
+	std::vector<char> rows(size * rowSize);
+	in.read(rows.data(), rows.size());
+	if (in.gcount() != rows.size())
+	{
+		std::cerr << "failed read lut file\n";
+		return false;
+	}
+
+	// rows are not necessarily sorted so the table is built through map (the last row of a repeated state wins, as in the old reader)
+	lut_t lut;
+	for (int i = 0; i < size; ++i)
+	{
+		const char * row = rows.data() + i * rowSize;
+		int state;
+		memcpy(&state, row, sizeof(int));
+		doubleVec & values = lut[state];
+		values.resize(numActions);
+		memcpy(values.data(), row + sizeof(int), numActions * sizeof(double));
+	}
+
+	Build(lut);
+	return true;
+}
+
+} // end ns despot
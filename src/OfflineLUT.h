@@ -0,0 +1,148 @@
+#ifndef OFFLINELUT_H
+#define OFFLINELUT_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+#include "../include/despot/core/globals.h"
+
+namespace despot
+{
+
+/* =============================================================================
+* OfflineLUT class
+* =============================================================================*/
+/// read only table of offline action values (state lut idx -> value of each action)
+/// the table is kept as a sorted key array and a contiguous value matrix (row i holds the values of key i).
+/// flat lut files are memory mapped so loading does not copy or parse the table.
+/// flat file layout (little endian): header, keys[numStates] (int64 ascending), values[numStates * numActions] (double)
+/// compressed files are memory mapped as well and decoded on lookup. compressed file layout (little endian): compressed header,
+/// blocks[numBlocks] (first key and offset of the rest of the block in the key stream), key stream (varint deltas of the keys of each block after the first),
+/// rows[numStates] (float offset, float scale, numActions quantized values of 8 or 16 bits. value = offset + scale * quantized)
+/// the class is thread safe after loading (all queries are const)
+class OfflineLUT
+{
+public:
+	using doubleVec = std::vector<double>;
+	using lut_t = std::map < STATE_TYPE, doubleVec >;
+
+	/// flat file header
+	struct Header
+	{
+		char m_magic[8];
+		uint32_t m_version;
+		uint32_t m_numActions;
+		uint64_t m_numStates;
+	};
+
+	/// compressed file header
+	struct CompressedHeader
+	{
+		char m_magic[8];
+		uint32_t m_version;
+		uint32_t m_numActions;
+		uint64_t m_numStates;
+		uint32_t m_bits;
+		uint32_t m_numBlocks;
+		uint64_t m_keyStreamSize;
+	};
+
+	/// block of keys in compressed file
+	struct KeyBlock
+	{
+		STATE_TYPE m_firstKey;
+		uint64_t m_offset;
+	};
+
+	/// accuracy of compressed lut relative to the original lut
+	struct CompressionReport
+	{
+		uint64_t m_numStates;
+		double m_maxError;
+		uint64_t m_numArgmaxDisagree;
+		size_t m_originalSize;
+		size_t m_compressedSize;
+	};
+
+	static const char s_MAGIC[8];
+	static const uint32_t s_VERSION = 1;
+	static const char s_COMPRESSED_MAGIC[8];
+	static const uint32_t s_COMPRESSED_VERSION = 1;
+	static const int s_KEYS_PER_BLOCK = 64;
+
+	OfflineLUT() = default;
+	/// build table in memory from map
+	explicit OfflineLUT(const lut_t & lut);
+	~OfflineLUT();
+
+	OfflineLUT(const OfflineLUT &) = delete;
+	OfflineLUT & operator=(const OfflineLUT &) = delete;
+
+	/// load lut file. flat and compressed files are memory mapped, old format files (written by CreateSARSOPData) are read to memory. return false on failure
+	bool Load(const std::string & fName);
+	/// write table to flat lut file
+	bool Write(const std::string & fName) const;
+	/// convert old format lut file (int size, int numActions, {int state, double values[numActions]}) to flat lut file
+	static bool Convert(const std::string & oldLutFName, const std::string & flatLutFName);
+	/// write table (not compressed) to compressed lut file with values quantized to bits (8 or 16)
+	bool WriteCompressed(const std::string & fName, int bits) const;
+	/// compress lut file (any format) to compressed lut file and fill report comparing the compressed values to the original values
+	static bool Compress(const std::string & lutFName, const std::string & compressedLutFName, int bits, CompressionReport & report);
+
+	/// insert the values of the actions of state to values (NumActions() values). return false if state is not in the table
+	bool Find(STATE_TYPE state, double * values) const;
+
+	/// num of states in table
+	uint64_t Size() const { return m_numStates; };
+	/// num of values in each row
+	int NumActions() const { return m_numActions; };
+	/// return true if the table is memory mapped from a file
+	bool IsMapped() const { return m_mapAddr != nullptr; };
+	/// return true if the values are quantized
+	bool IsCompressed() const { return m_bits != 0; };
+
+private:
+	/// release mapped file or owned memory
+	void Release();
+	/// map flat or compressed file to memory
+	bool Map(const std::string & fName);
+	/// set table to the flat file in data. return false if size does not match the header
+	bool ParseFlat(const char * data);
+	/// set table to the compressed file in data. return false if size does not match the header
+	bool ParseCompressed(const char * data);
+	/// return row idx of state in compressed table (-1 if not found)
+	int64_t FindCompressedRow(STATE_TYPE state) const;
+	/// read old format file to owned memory
+	bool ReadOldFormat(std::ifstream & in);
+	/// build owned keys and values from map
+	void Build(const lut_t & lut);
+
+	const STATE_TYPE * m_keys = nullptr;
+	const double * m_values = nullptr;
+	uint64_t m_numStates = 0;
+	int m_numActions = 0;
+
+	// compressed table (m_bits = 0 when table is not compressed)
+	int m_bits = 0;
+	const KeyBlock * m_blocks = nullptr;
+	uint32_t m_numBlocks = 0;
+	const uint8_t * m_keyStream = nullptr;
+	const char * m_rows = nullptr;
+	size_t m_rowSize = 0;
+
+	// owned memory (when table is built in memory or read from old format)
+	std::vector<STATE_TYPE> m_ownedKeys;
+	doubleVec m_ownedValues;
+
+	// mapped file
+	void * m_mapAddr = nullptr;
+	size_t m_mapSize = 0;
+	void * m_fileHandle = nullptr;
+	void * m_mapHandle = nullptr;
+};
+
+} // end ns despot
+
+#endif	// OFFLINELUT_H
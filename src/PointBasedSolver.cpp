@@ -0,0 +1,587 @@
+#include "PointBasedSolver.h"
+
+#include <algorithm>	// sort, min
+#include <atomic>		// atomic
+#include <chrono>		// steady_clock
+#include <cmath>		// fabs
+#include <cstring>		// memcpy
+#include <fstream>		// ofstream, ifstream
+#include <iostream>		// cerr
+#include <limits>		// numeric_limits
+#include <random>		// mt19937
+#include <thread>		// thread
+
+/* =============================================================================
+* SparsePomdp Functions
+* =============================================================================*/
+
+const char SparsePomdp::s_MAGIC[8] = { 'N', 'X', 'N', 'P', 'O', 'M', 'D', 'P' };
+
+static_assert(sizeof(SparsePomdp::Header) == 56, "sparse pomdp header must keep arrays 8 bytes aligned");
+
+template<typename T>
+static void WriteArray(std::ofstream & out, const std::vector<T> & arr)
+{
+	out.write(reinterpret_cast<const char *>(arr.data()), arr.size() * sizeof(T));
+}
+
+template<typename T>
+static bool ReadArray(std::ifstream & in, std::vector<T> & arr, uint64_t size)
+{
+	arr.resize(size);
+	in.read(reinterpret_cast<char *>(arr.data()), size * sizeof(T));
+	return static_cast<uint64_t>(in.gcount()) == size * sizeof(T);
+}
+
+SparsePomdp::SparsePomdp(int numActions, double discount)
+: m_initState(-1)
+, m_numActions(numActions)
+, m_numObservations(0)
+, m_discount(discount)
+, m_transBegin(1, 0)
+, m_transNext()
+, m_transProb()
+, m_obsBegin(1, 0)
+, m_obsId()
+, m_obsProb()
+, m_reward()
+{
+}
+
+void SparsePomdp::AddTransitionRow(const row_t & row)
+{
+	for (auto v : row)
+	{
+		m_transNext.emplace_back(v.first);
+		m_transProb.emplace_back(v.second);
+	}
+	m_transBegin.emplace_back(m_transNext.size());
+}
+
+void SparsePomdp::AddObservationRow(const row_t & row)
+{
+	for (auto v : row)
+	{
+		m_obsId.emplace_back(v.first);
+		m_obsProb.emplace_back(v.second);
+	}
+	m_obsBegin.emplace_back(m_obsId.size());
+}
+
+void SparsePomdp::SetRewards(const doubleVec & arrivalReward, const std::vector<bool> & isAbsorbing)
+{
+	m_reward.assign(NumStates() * m_numActions, 0.0);
+	for (int s = 0; s < NumStates(); ++s)
+	{
+		if (isAbsorbing[s])
+			continue;
+
+		for (int a = 0; a < m_numActions; ++a)
+		{
+			int row = s * m_numActions + a;
+			for (int t = m_transBegin[row]; t < m_transBegin[row + 1]; ++t)
+				m_reward[row] += m_transProb[t] * arrivalReward[m_transNext[t]];
+		}
+	}
+}
+
+bool SparsePomdp::Write(const std::string & fName, const std::vector<long> & stateKeys) const
+{
+	std::ofstream out(fName, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (out.fail())
+	{
+		std::cerr << "failed open sparse pomdp file " << fName << " for write\n";
+		return false;
+	}
+
+	Header header;
+	memcpy(header.m_magic, s_MAGIC, sizeof(s_MAGIC));
+	header.m_version = s_VERSION;
+	header.m_numStates = NumStates();
+	header.m_numActions = m_numActions;
+	header.m_numObservations = m_numObservations;
+	header.m_initState = m_initState;
+	header.m_numStateKeys = stateKeys.size();
+	header.m_discount = m_discount;
+	header.m_numTransitions = m_transNext.size();
+	header.m_numObsEntries = m_obsId.size();
+	out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+
+	WriteArray(out, m_transBegin);
+	WriteArray(out, m_transNext);
+	WriteArray(out, m_transProb);
+	WriteArray(out, m_obsBegin);
+	WriteArray(out, m_obsId);
+	WriteArray(out, m_obsProb);
+	WriteArray(out, m_reward);
+	// keys are written as int64 so the file does not depend on the size of long
+	WriteArray(out, std::vector<int64_t>(stateKeys.begin(), stateKeys.end()));
+
+	if (out.bad())
+	{
+		std::cerr << "failed write sparse pomdp file " << fName << "\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool SparsePomdp::Read(const std::string & fName, std::vector<long> & stateKeys)
+{
+	std::ifstream in(fName, std::ios::in | std::ios::binary);
+	if (in.fail())
+	{
+		std::cerr << "failed open sparse pomdp file " << fName << "\n";
+		return false;
+	}
+
+	Header header;
+	in.read(reinterpret_cast<char *>(&header), sizeof(Header));
+	if (in.gcount() != sizeof(Header) || memcmp(header.m_magic, s_MAGIC, sizeof(s_MAGIC)) != 0 || header.m_version != s_VERSION)
+	{
+		std::cerr << "sparse pomdp file " << fName << " is corrupted or of unknown version\n";
+		return false;
+	}
+
+	m_numActions = header.m_numActions;
+	m_numObservations = header.m_numObservations;
+	m_initState = header.m_initState;
+	m_discount = header.m_discount;
+
+	uint64_t numRows = static_cast<uint64_t>(header.m_numStates) * header.m_numActions;
+	std::vector<int64_t> keys;
+	bool success = ReadArray(in, m_transBegin, numRows + 1)
+		&& ReadArray(in, m_transNext, header.m_numTransitions)
+		&& ReadArray(in, m_transProb, header.m_numTransitions)
+		&& ReadArray(in, m_obsBegin, header.m_numStates + 1)
+		&& ReadArray(in, m_obsId, header.m_numObsEntries)
+		&& ReadArray(in, m_obsProb, header.m_numObsEntries)
+		&& ReadArray(in, m_reward, numRows)
+		&& ReadArray(in, keys, header.m_numStateKeys);
+
+	if (!success)
+	{
+		std::cerr << "failed read sparse pomdp file " << fName << "\n";
+		return false;
+	}
+
+	stateKeys.assign(keys.begin(), keys.end());
+	return true;
+}
+
+/* =============================================================================
+* PointBasedSolver Functions
+* =============================================================================*/
+
+PointBasedSolver::PointBasedSolver(const SparsePomdp & pomdp, int numThreads)
+: m_pomdp(pomdp)
+, m_numThreads(numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency()))
+, m_beliefs()
+, m_alphas()
+{
+	// initial belief
+	belief_t initBelief;
+	if (m_pomdp.m_initState >= 0)
+		initBelief.emplace_back(m_pomdp.m_initState, 1.0);
+	else
+	{
+		for (int s = 0; s < m_pomdp.NumStates(); ++s)
+			initBelief.emplace_back(s, 1.0 / m_pomdp.NumStates());
+	}
+	m_beliefs.emplace_back(std::move(initBelief));
+
+	// the action values are queried on all states so the belief of each state is backed up as well
+	for (int s = 0; s < m_pomdp.NumStates(); ++s)
+	{
+		if (s != m_pomdp.m_initState)
+			m_beliefs.emplace_back(belief_t{ std::make_pair(s, 1.0) });
+	}
+
+	// initial alpha vectors are the values of the blind policies (lower bound)
+	m_alphas.resize(m_pomdp.NumActions());
+	ParallelFor(m_pomdp.NumActions(), [this](int a) { BlindPolicyAlpha(a, m_alphas[a]); });
+}
+
+template<typename Func>
+void PointBasedSolver::ParallelFor(int size, Func f) const
+{
+	std::atomic<int> next(0);
+	auto worker = [&next, &f, size]()
+	{
+		for (int i = next++; i < size; i = next++)
+			f(i);
+	};
+
+	std::vector<std::thread> threads;
+	for (int t = 1; t < m_numThreads; ++t)
+		threads.emplace_back(worker);
+	worker();
+
+	for (auto & t : threads)
+		t.join();
+}
+
+void PointBasedSolver::BlindPolicyAlpha(int action, doubleVec & alpha) const
+{
+	static const double s_BLIND_PRECISION = 1e-6;
+
+	// start from min reward / (1 - discount) and iterate alpha(s) = R(s, a) + discount * sum(T(s, a, s') * alpha(s')) until convergence
+	double minReward = *std::min_element(m_pomdp.m_reward.begin(), m_pomdp.m_reward.end());
+	alpha.assign(m_pomdp.NumStates(), minReward / (1 - m_pomdp.Discount()));
+	doubleVec next(m_pomdp.NumStates());
+
+	double change = std::numeric_limits<double>::infinity();
+	while (change > s_BLIND_PRECISION)
+	{
+		change = 0.0;
+		for (int s = 0; s < m_pomdp.NumStates(); ++s)
+		{
+			double future = 0.0;
+			int row = s * m_pomdp.NumActions() + action;
+			for (int t = m_pomdp.m_transBegin[row]; t < m_pomdp.m_transBegin[row + 1]; ++t)
+				future += m_pomdp.m_transProb[t] * alpha[m_pomdp.m_transNext[t]];
+
+			next[s] = m_pomdp.Reward(s, action) + m_pomdp.Discount() * future;
+			change = std::max(change, fabs(next[s] - alpha[s]));
+		}
+		alpha.swap(next);
+	}
+}
+
+void PointBasedSolver::Solve(int maxBeliefs, int backupsPerExpansion, double timeout, double precision)
+{
+	auto start = std::chrono::steady_clock::now();
+	auto elapsed = [&start]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+
+	while (true)
+	{
+		double residual = 0.0;
+		for (int i = 0; i < backupsPerExpansion; ++i)
+			residual = BackupAll();
+
+		if (elapsed() >= timeout)
+			break;
+
+		int added = NumBeliefs() < maxBeliefs ? Expand(maxBeliefs) : 0;
+		if (added == 0 && residual < precision)
+			break;
+	}
+}
+
+void PointBasedSolver::ActionValues(int state, doubleVec & values) const
+{
+	belief_t belief{ std::make_pair(state, 1.0) };
+	std::vector<std::pair<int, int>> obsAlpha;
+
+	values.resize(m_pomdp.NumActions());
+	for (int a = 0; a < m_pomdp.NumActions(); ++a)
+		values[a] = ActionValue(belief, a, obsAlpha);
+}
+
+void PointBasedSolver::AllActionValues(std::vector<doubleVec> & values) const
+{
+	values.resize(m_pomdp.NumStates());
+	ParallelFor(m_pomdp.NumStates(), [this, &values](int s) { ActionValues(s, values[s]); });
+}
+
+double PointBasedSolver::Value(const belief_t & belief) const
+{
+	double value;
+	BestAlpha(belief, value);
+	return value;
+}
+
+double PointBasedSolver::BackupAll()
+{
+	std::vector<intVec> signatures(m_beliefs.size());
+	doubleVec residuals(m_beliefs.size());
+	ParallelFor(NumBeliefs(), [this, &signatures, &residuals](int b) { residuals[b] = Backup(m_beliefs[b], signatures[b]); });
+
+	// beliefs with the same signature create the same alpha vector
+	std::sort(signatures.begin(), signatures.end());
+	signatures.erase(std::unique(signatures.begin(), signatures.end()), signatures.end());
+
+	std::vector<doubleVec> alphas(signatures.size());
+	ParallelFor(signatures.size(), [this, &signatures, &alphas](int i) { CreateAlpha(signatures[i], alphas[i]); });
+	m_alphas.swap(alphas);
+
+	return *std::max_element(residuals.begin(), residuals.end());
+}
+
+double PointBasedSolver::Backup(const belief_t & belief, intVec & signature) const
+{
+	std::vector<std::pair<int, int>> obsAlpha, bestObsAlpha;
+	double bestValue = -std::numeric_limits<double>::infinity();
+	int bestAction = 0;
+	for (int a = 0; a < m_pomdp.NumActions(); ++a)
+	{
+		double value = ActionValue(belief, a, obsAlpha);
+		if (value > bestValue)
+		{
+			bestValue = value;
+			bestAction = a;
+			bestObsAlpha.swap(obsAlpha);
+		}
+	}
+
+	// observations non reachable from belief are using the best alpha vector of belief
+	double value;
+	int defaultAlpha = BestAlpha(belief, value);
+
+	signature.clear();
+	// when the backup does not improve belief the current best alpha vector is kept (values are not decreasing)
+	if (bestValue <= value)
+	{
+		signature.emplace_back(-1);
+		signature.emplace_back(defaultAlpha);
+		return 0.0;
+	}
+
+	signature.emplace_back(bestAction);
+	signature.emplace_back(defaultAlpha);
+	for (auto v : bestObsAlpha)
+	{
+		signature.emplace_back(v.first);
+		signature.emplace_back(v.second);
+	}
+
+	return bestValue - value;
+}
+
+double PointBasedSolver::ActionValue(const belief_t & belief, int action, std::vector<std::pair<int, int>> & obsAlpha) const
+{
+	double reward = 0.0;
+	// (observation, (next state, probability)) of all reachable next states and observations
+	std::vector<std::pair<int, std::pair<int, double>>> next;
+	for (auto b : belief)
+	{
+		reward += b.second * m_pomdp.Reward(b.first, action);
+
+		int row = b.first * m_pomdp.NumActions() + action;
+		for (int t = m_pomdp.m_transBegin[row]; t < m_pomdp.m_transBegin[row + 1]; ++t)
+		{
+			int nextState = m_pomdp.m_transNext[t];
+			double pTrans = b.second * m_pomdp.m_transProb[t];
+			for (int o = m_pomdp.m_obsBegin[nextState]; o < m_pomdp.m_obsBegin[nextState + 1]; ++o)
+				next.emplace_back(m_pomdp.m_obsId[o], std::make_pair(nextState, pTrans * m_pomdp.m_obsProb[o]));
+		}
+	}
+
+	std::sort(next.begin(), next.end());
+
+	// for each observation choose the best alpha vector of the (non normalized) next belief
+	obsAlpha.clear();
+	double futureValue = 0.0;
+	for (size_t begin = 0; begin < next.size();)
+	{
+		size_t end = begin;
+		while (end < next.size() && next[end].first == next[begin].first)
+			++end;
+
+		double bestValue = -std::numeric_limits<double>::infinity();
+		int bestAlpha = 0;
+		for (int i = 0; i < NumAlphaVectors(); ++i)
+		{
+			const doubleVec & alpha = m_alphas[i];
+			double value = 0.0;
+			for (size_t n = begin; n < end; ++n)
+				value += next[n].second.second * alpha[next[n].second.first];
+
+			if (value > bestValue)
+			{
+				bestValue = value;
+				bestAlpha = i;
+			}
+		}
+
+		futureValue += bestValue;
+		obsAlpha.emplace_back(next[begin].first, bestAlpha);
+		begin = end;
+	}
+
+	return reward + m_pomdp.Discount() * futureValue;
+}
+
+void PointBasedSolver::CreateAlpha(const intVec & signature, doubleVec & alpha) const
+{
+	int action = signature[0];
+	if (action < 0)
+	{
+		alpha = m_alphas[signature[1]];
+		return;
+	}
+
+	intVec chosenAlpha(m_pomdp.NumObservations(), signature[1]);
+	for (size_t i = 2; i < signature.size(); i += 2)
+		chosenAlpha[signature[i]] = signature[i + 1];
+
+	// alpha(s) = R(s, a) + discount * sum(T(s, a, s') * O(s', o) * alpha_o(s'))
+	alpha.resize(m_pomdp.NumStates());
+	for (int s = 0; s < m_pomdp.NumStates(); ++s)
+	{
+		double future = 0.0;
+		int row = s * m_pomdp.NumActions() + action;
+		for (int t = m_pomdp.m_transBegin[row]; t < m_pomdp.m_transBegin[row + 1]; ++t)
+		{
+			int nextState = m_pomdp.m_transNext[t];
+			for (int o = m_pomdp.m_obsBegin[nextState]; o < m_pomdp.m_obsBegin[nextState + 1]; ++o)
+				future += m_pomdp.m_transProb[t] * m_pomdp.m_obsProb[o] * m_alphas[chosenAlpha[m_pomdp.m_obsId[o]]][nextState];
+		}
+
+		alpha[s] = m_pomdp.Reward(s, action) + m_pomdp.Discount() * future;
+	}
+}
+
+int PointBasedSolver::Expand(int maxBeliefs)
+{
+	int numBeliefs = NumBeliefs();
+	std::vector<belief_t> candidates(numBeliefs);
+	doubleVec candidatesDist(numBeliefs, 0.0);
+
+	// for each belief simulate one step of each action and keep the next belief farthest from the current beliefs
+	ParallelFor(numBeliefs, [this, numBeliefs, &candidates, &candidatesDist](int b)
+	{
+		// seed by belief idx so the expansion does not depend on the num of threads
+		std::mt19937 rng(static_cast<unsigned int>(b * 7919 + numBeliefs));
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		auto sample = [&uniform, &rng](const doubleVec & probs, const intVec & ids, int begin, int end)
+		{
+			double r = uniform(rng);
+			for (int i = begin; i < end - 1; ++i)
+			{
+				r -= probs[i];
+				if (r < 0)
+					return ids[i];
+			}
+			return ids[end - 1];
+		};
+
+		const belief_t & belief = m_beliefs[b];
+		belief_t nextBelief;
+		for (int a = 0; a < m_pomdp.NumActions(); ++a)
+		{
+			// sample state from belief
+			double r = uniform(rng);
+			int state = belief.back().first;
+			for (auto v : belief)
+			{
+				r -= v.second;
+				if (r < 0)
+				{
+					state = v.first;
+					break;
+				}
+			}
+
+			int row = state * m_pomdp.NumActions() + a;
+			if (m_pomdp.m_transBegin[row] == m_pomdp.m_transBegin[row + 1])
+				continue;
+			int nextState = sample(m_pomdp.m_transProb, m_pomdp.m_transNext, m_pomdp.m_transBegin[row], m_pomdp.m_transBegin[row + 1]);
+			if (m_pomdp.m_obsBegin[nextState] == m_pomdp.m_obsBegin[nextState + 1])
+				continue;
+			int obs = sample(m_pomdp.m_obsProb, m_pomdp.m_obsId, m_pomdp.m_obsBegin[nextState], m_pomdp.m_obsBegin[nextState + 1]);
+
+			NextBelief(belief, a, obs, nextBelief);
+			if (nextBelief.empty())
+				continue;
+
+			double minDist = std::numeric_limits<double>::infinity();
+			for (int i = 0; i < numBeliefs && minDist > candidatesDist[b]; ++i)
+				minDist = std::min(minDist, Distance(nextBelief, m_beliefs[i]));
+
+			if (minDist > candidatesDist[b])
+			{
+				candidatesDist[b] = minDist;
+				candidates[b].swap(nextBelief);
+			}
+		}
+	});
+
+	// add candidates that are new (different candidates may be the same belief)
+	static const double s_MIN_DIST = 1e-6;
+	for (int b = 0; b < numBeliefs && NumBeliefs() < maxBeliefs; ++b)
+	{
+		if (candidatesDist[b] <= s_MIN_DIST)
+			continue;
+
+		bool isNew = true;
+		for (int i = numBeliefs; i < NumBeliefs() && isNew; ++i)
+			isNew = Distance(candidates[b], m_beliefs[i]) > s_MIN_DIST;
+
+		if (isNew)
+			m_beliefs.emplace_back(std::move(candidates[b]));
+	}
+
+	return NumBeliefs() - numBeliefs;
+}
+
+void PointBasedSolver::NextBelief(const belief_t & belief, int action, int obs, belief_t & nextBelief) const
+{
+	// b'(s') = O(s', o) * sum(T(s, a, s') * b(s)) / p(o | b, a)
+	std::map<int, double> next;
+	for (auto b : belief)
+	{
+		int row = b.first * m_pomdp.NumActions() + action;
+		for (int t = m_pomdp.m_transBegin[row]; t < m_pomdp.m_transBegin[row + 1]; ++t)
+		{
+			int nextState = m_pomdp.m_transNext[t];
+			for (int o = m_pomdp.m_obsBegin[nextState]; o < m_pomdp.m_obsBegin[nextState + 1]; ++o)
+			{
+				if (m_pomdp.m_obsId[o] == obs)
+					next[nextState] += b.second * m_pomdp.m_transProb[t] * m_pomdp.m_obsProb[o];
+			}
+		}
+	}
+
+	double pObs = 0.0;
+	for (auto v : next)
+		pObs += v.second;
+
+	nextBelief.clear();
+	if (pObs <= 0.0)
+		return;
+
+	for (auto v : next)
+		nextBelief.emplace_back(v.first, v.second / pObs);
+}
+
+int PointBasedSolver::BestAlpha(const belief_t & belief, double & value) const
+{
+	value = -std::numeric_limits<double>::infinity();
+	int best = 0;
+	for (int i = 0; i < NumAlphaVectors(); ++i)
+	{
+		double currValue = Dot(belief, m_alphas[i]);
+		if (currValue > value)
+		{
+			value = currValue;
+			best = i;
+		}
+	}
+	return best;
+}
+
+double PointBasedSolver::Dot(const belief_t & belief, const doubleVec & alpha)
+{
+	double value = 0.0;
+	for (auto b : belief)
+		value += b.second * alpha[b.first];
+	return value;
+}
+
+double PointBasedSolver::Distance(const belief_t & b1, const belief_t & b2)
+{
+	// L1 distance of sparse beliefs (both sorted by state)
+	double dist = 0.0;
+	size_t i = 0, j = 0;
+	while (i < b1.size() || j < b2.size())
+	{
+		if (j == b2.size() || (i < b1.size() && b1[i].first < b2[j].first))
+			dist += b1[i++].second;
+		else if (i == b1.size() || b2[j].first < b1[i].first)
+			dist += b2[j++].second;
+		else
+			dist += fabs(b1[i++].second - b2[j++].second);
+	}
+	return dist;
+}
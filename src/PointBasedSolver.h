@@ -0,0 +1,151 @@
+#ifndef POINTBASEDSOLVER_H
+#define POINTBASEDSOLVER_H
+
+#include <vector>
+#include <map>
+#include <string>
+#include <utility>
+#include <cstdint>
+
+/* =============================================================================
+* SparsePomdp class
+* =============================================================================*/
+/// discrete pomdp with sparse transition and observation matrices (states, actions and observations are dense idx)
+/// transitions of (state, action) are in row state * numActions + action. observations are given for the arriving state
+/// binary file layout (little endian): header, transBegin, transNext, transProb, obsBegin, obsId, obsProb, reward, stateKeys (int64)
+class SparsePomdp
+{
+public:
+	using intVec = std::vector<int>;
+	using doubleVec = std::vector<double>;
+	/// sparse row (idx -> probability)
+	using row_t = std::map<int, double>;
+
+	/// binary file header
+	struct Header
+	{
+		char m_magic[8];
+		uint32_t m_version;
+		int32_t m_numStates;
+		int32_t m_numActions;
+		int32_t m_numObservations;
+		int32_t m_initState;
+		uint32_t m_numStateKeys;
+		double m_discount;
+		uint64_t m_numTransitions;
+		uint64_t m_numObsEntries;
+	};
+
+	static const char s_MAGIC[8];
+	static const uint32_t s_VERSION = 1;
+
+	explicit SparsePomdp(int numActions = 0, double discount = 0.95);
+
+	/// add transition row of the next (state, action) pair (rows are added by increasing state and action)
+	void AddTransitionRow(const row_t & row);
+	/// add observation row of the next arriving state (rows are added by increasing state)
+	void AddObservationRow(const row_t & row);
+
+	/// fill expected reward of each (state, action) given reward for arriving to each state. absorbing states are given reward 0
+	void SetRewards(const doubleVec & arrivalReward, const std::vector<bool> & isAbsorbing);
+
+	/// write model and key of each state (e.g lut idx of the model states) to binary file. return false on failure
+	bool Write(const std::string & fName, const std::vector<long> & stateKeys) const;
+	/// read model and state keys from binary file. return false on failure
+	bool Read(const std::string & fName, std::vector<long> & stateKeys);
+
+	int NumStates() const { return static_cast<int>(m_obsBegin.size()) - 1; };
+	int NumActions() const { return m_numActions; };
+	int NumObservations() const { return m_numObservations; };
+	double Discount() const { return m_discount; };
+
+	double Reward(int state, int action) const { return m_reward[state * m_numActions + action]; };
+
+	/// initial state (-1 for uniform initial belief)
+	int m_initState;
+
+	int m_numActions;
+	int m_numObservations;
+	double m_discount;
+
+	// transitions (row = state * numActions + action)
+	intVec m_transBegin;
+	intVec m_transNext;
+	doubleVec m_transProb;
+
+	// observations (row = arriving state)
+	intVec m_obsBegin;
+	intVec m_obsId;
+	doubleVec m_obsProb;
+
+	/// expected reward (idx = state * numActions + action)
+	doubleVec m_reward;
+};
+
+/* =============================================================================
+* PointBasedSolver class
+* =============================================================================*/
+/// point based value iteration (PBVI) solver for SparsePomdp.
+/// belief points are the initial belief and the belief of each state, expanded by stochastic simulation (farthest new belief is kept).
+/// all points are backed up in parallel. the alpha vectors are a lower bound of the value function
+class PointBasedSolver
+{
+public:
+	using intVec = std::vector<int>;
+	using doubleVec = std::vector<double>;
+	/// sparse belief (state, probability) sorted by state
+	using belief_t = std::vector<std::pair<int, double>>;
+
+	/// numThreads = 0 means use all available cores
+	explicit PointBasedSolver(const SparsePomdp & pomdp, int numThreads = 0);
+
+	/// expand and backup belief points until num of beliefs is maxBeliefs and the values of the beliefs converged (max change < precision) or until timeout (seconds)
+	void Solve(int maxBeliefs, int backupsPerExpansion, double timeout, double precision);
+
+	/// value of each action when the belief is concentrated in state (one step lookahead over the alpha vectors)
+	void ActionValues(int state, doubleVec & values) const;
+	/// action values of all states (calculated in parallel)
+	void AllActionValues(std::vector<doubleVec> & values) const;
+
+	/// value of belief (max over alpha vectors)
+	double Value(const belief_t & belief) const;
+
+	int NumBeliefs() const { return static_cast<int>(m_beliefs.size()); };
+	int NumAlphaVectors() const { return static_cast<int>(m_alphas.size()); };
+
+private:
+	/// run f(i) for i in [0, size) on all threads
+	template<typename Func>
+	void ParallelFor(int size, Func f) const;
+
+	/// calculate the value of always choosing action
+	void BlindPolicyAlpha(int action, doubleVec & alpha) const;
+
+	/// backup all beliefs and replace alpha vectors. return max improvement in value of beliefs
+	double BackupAll();
+	/// insert signature of backup of belief (action, default alpha and (observation, alpha) pairs, or (-1, current alpha) when backup does not improve belief)
+	/// the signature identifies the new alpha vector. return improvement in value of belief
+	double Backup(const belief_t & belief, intVec & signature) const;
+	/// return value of action given belief and the chosen alpha vector for each reachable observation
+	double ActionValue(const belief_t & belief, int action, std::vector<std::pair<int, int>> & obsAlpha) const;
+	/// create alpha vector of signature
+	void CreateAlpha(const intVec & signature, doubleVec & alpha) const;
+
+	/// add new beliefs reachable from current beliefs. return num of beliefs added
+	int Expand(int maxBeliefs);
+	/// next belief given belief action and observation
+	void NextBelief(const belief_t & belief, int action, int obs, belief_t & nextBelief) const;
+
+	/// return idx of best alpha vector for belief
+	int BestAlpha(const belief_t & belief, double & value) const;
+	static double Dot(const belief_t & belief, const doubleVec & alpha);
+	static double Distance(const belief_t & b1, const belief_t & b2);
+
+	const SparsePomdp & m_pomdp;
+	int m_numThreads;
+
+	std::vector<belief_t> m_beliefs;
+	std::vector<doubleVec> m_alphas;
+};
+
+#endif	// POINTBASEDSOLVER_H
@@ -0,0 +1,112 @@
+#include "PomdpWriter.h"
+
+#include <cstring>		// strlen, memcpy
+#include <cstdlib>		// exit
+#include <iostream>		// cerr
+
+PomdpWriter::PomdpWriter(FILE * fptr, size_t capacity)
+: m_fptr(fptr)
+, m_str(nullptr)
+, m_buffer(capacity)
+, m_size(0)
+{
+}
+
+PomdpWriter::PomdpWriter(std::string & str, size_t capacity)
+: m_fptr(nullptr)
+, m_str(&str)
+, m_buffer(capacity)
+, m_size(0)
+{
+}
+
+PomdpWriter::~PomdpWriter()
+{
+	Flush();
+}
+
+PomdpWriter & PomdpWriter::operator+=(const char * str)
+{
+	Append(str, strlen(str));
+	return *this;
+}
+
+void PomdpWriter::Append(const char * str, size_t size)
+{
+	if (m_size + size > m_buffer.size())
+	{
+		Flush();
+		// text larger than the buffer is written directly
+		if (size > m_buffer.size())
+		{
+			Write(str, size);
+			return;
+		}
+	}
+
+	memcpy(m_buffer.data() + m_size, str, size);
+	m_size += size;
+}
+
+void PomdpWriter::AppendInt(int num)
+{
+	char str[16];
+	char * end = str + sizeof(str);
+	char * begin = end;
+
+	unsigned int absNum = num < 0 ? 0u - static_cast<unsigned int>(num) : num;
+	do
+	{
+		*--begin = '0' + absNum % 10;
+		absNum /= 10;
+	} while (absNum > 0);
+
+	if (num < 0)
+		*--begin = '-';
+
+	Append(begin, end - begin);
+}
+
+void PomdpWriter::AppendDbl(double num)
+{
+	char str[s_DBL_MAX_CHARS];
+	Append(str, FormatDbl(num, str));
+}
+
+void PomdpWriter::Flush()
+{
+	if (m_size > 0)
+		Write(m_buffer.data(), m_size);
+	m_size = 0;
+}
+
+void PomdpWriter::Write(const char * str, size_t size)
+{
+	if (m_str != nullptr)
+		m_str->append(str, size);
+	else if (m_fptr != nullptr && fwrite(str, 1, size, m_fptr) != size)
+	{
+		std::cerr << "Error Writing to file\n";
+		exit(1);
+	}
+}
+
+int PomdpWriter::FormatDbl(double num, char * str)
+{
+	// fixed notation with precision of 10 (same digits as stream with std::fixed and setprecision(10))
+	int size = snprintf(str, s_DBL_MAX_CHARS, "%.10f", num);
+	if (size < 0 || size >= s_DBL_MAX_CHARS)
+	{
+		std::cerr << "failed format number\n";
+		exit(1);
+	}
+
+	// remove trailing zeros and dangling decimal point (123.1200 => 123.12, 123.000 => 123)
+	while (str[size - 1] == '0')
+		--size;
+	if (str[size - 1] == '.')
+		--size;
+
+	str[size] = '\0';
+	return size;
+}
@@ -0,0 +1,54 @@
+#ifndef POMDPWRITER_H
+#define POMDPWRITER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/* =============================================================================
+* PomdpWriter class
+* =============================================================================*/
+/// text sink over a file with a fixed size buffer. the buffer is written to the file whenever it fills so memory does not depend on the size of the text.
+/// a writer with null file discards the text. a writer over a string appends the text to the string (used for chunks written by worker threads)
+class PomdpWriter
+{
+public:
+	static const size_t s_DEFAULT_CAPACITY = 1 << 20;
+	static const size_t s_DEFAULT_CHUNK_CAPACITY = 1 << 16;
+
+	explicit PomdpWriter(FILE * fptr, size_t capacity = s_DEFAULT_CAPACITY);
+	explicit PomdpWriter(std::string & str, size_t capacity = s_DEFAULT_CHUNK_CAPACITY);
+	/// write the remaining text to file
+	~PomdpWriter();
+
+	PomdpWriter(const PomdpWriter &) = delete;
+	PomdpWriter & operator=(const PomdpWriter &) = delete;
+
+	PomdpWriter & operator+=(const std::string & str) { Append(str.c_str(), str.size()); return *this; };
+	PomdpWriter & operator+=(const char * str);
+	PomdpWriter & operator+=(char c) { Append(&c, 1); return *this; };
+
+	void Append(const char * str, size_t size);
+	/// append integer in decimal
+	void AppendInt(int num);
+	/// append double in fixed notation (precision of 10 digits) without trailing zeros
+	void AppendDbl(double num);
+
+	/// write buffer to file
+	void Flush();
+
+	/// format double as AppendDbl to str (str should have s_DBL_MAX_CHARS chars). return num of chars
+	static int FormatDbl(double num, char * str);
+	static const int s_DBL_MAX_CHARS = 512;
+
+private:
+	/// write text to file or string
+	void Write(const char * str, size_t size);
+
+	FILE * m_fptr;
+	std::string * m_str;
+	std::vector<char> m_buffer;
+	size_t m_size;
+};
+
+#endif	// POMDPWRITER_H
@@ -137,7 +137,7 @@ vector<State*> Belief::Resample(int num, const vector<State*>& belief,
 			// Add to obj available locations if survived
 			if (particle->IsAllocated()) 
 			{
-				nxnGridState::IdxToState(particle, stateVec);
+				modelCast->GetContext()->IdxToState(particle->state_id, stateVec);
 				count++;
 				objLocations[obj].emplace_back(stateVec[obj], wgt);
 			}
@@ -367,14 +367,27 @@ void ParticleBelief::Update(int action, OBS_TYPE obs)
 
 	vector<State*> updated;
 	double total_weight = 0;
-	double reward;
-	OBS_TYPE o;
+
+	vector<double> randomNums(particles_.size());
+	vector<OBS_TYPE> lastObs(particles_.size());
+	for (int i = 0; i < particles_.size(); i++) {
+		randomNums[i] = Random::RANDOM.NextDouble();
+		lastObs[i] = prevObs + particles_[i]->state_id * (prevObs == 0);
+	}
+
 	// Update particles
+	vector<double> rewards;
+	vector<OBS_TYPE> o;
+	vector<bool> terminals;
+	model_->StepBatch(particles_, randomNums, action, lastObs, rewards, o, terminals);
+
+	vector<double> probs;
+	model_->ObsProbBatch(obs, particles_, action, probs);
+
 	for (int i = 0; i <particles_.size(); i++) {
 		State* particle = particles_[i];
-		OBS_TYPE lastObs = prevObs + particle->state_id * (prevObs == 0);
-		bool terminal = model_->Step(*particle, Random::RANDOM.NextDouble(), action, lastObs, reward, o);
-		double prob = model_->ObsProb(obs, *particle, action);
+		bool terminal = terminals[i];
+		double prob = probs[i];
 
 		if (!terminal && prob) { // Terminal state is not required to be explicitly represented and may not have any observation
 			particle->weight *= prob;
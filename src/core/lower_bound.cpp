@@ -56,6 +56,10 @@ ValuedAction ScenarioLowerBound::Search() {
 void ScenarioLowerBound::Learn(VNode* tree) {
 }
 
+bool ScenarioLowerBound::IsThreadSafe() const {
+	return false;
+}
+
 /* =============================================================================
  * POMCPScenarioLowerBound class
  * =============================================================================*/
@@ -115,6 +119,10 @@ ValuedAction TrivialParticleLowerBound::Value(
 	return va;
 }
 
+bool TrivialParticleLowerBound::IsThreadSafe() const {
+	return true;
+}
+
 /* =============================================================================
  * BeliefLowerBound class
  * =============================================================================*/
@@ -9,7 +9,7 @@ namespace despot {
  * VNode class
  * =============================================================================*/
 // id for saving tree in file FRAGILE- do not change
-static enum TYPE_FOR_IO{VNODE = 123, QNODE = 456};
+enum TYPE_FOR_IO{VNODE = 123, QNODE = 456};
 
 std::ofstream &operator<<(std::ofstream & out, const VNode & vnode) // NATAN CHANGES
 {
@@ -33,14 +33,17 @@ std::ofstream &operator<<(std::ofstream & out, const QNode & qnode) // NATAN CHA
 }
 
 VNode::VNode(vector<State*>& particles, int depth, QNode* parent,
-	OBS_TYPE edge) :
+	OBS_TYPE edge, Arena* arena) :
 	particles_(particles),
 	belief_(NULL),
 	depth_(depth),
 	parent_(parent),
 	edge_(edge),
+	children_(ActionChildren::allocator_type(arena)),
 	vstar(this),
-	likelihood(1) {
+	likelihood(1),
+	virtual_loss(0),
+	expanding(false) {
 	logd << "Constructed vnode with " << particles_.size() << " particles"
 		<< endl;
 	for (int i = 0; i < particles_.size(); i++) {
@@ -54,23 +57,32 @@ VNode::VNode(Belief* belief, int depth, QNode* parent, OBS_TYPE edge) :
 	parent_(parent),
 	edge_(edge),
 	vstar(this),
-	likelihood(1) {
+	likelihood(1),
+	virtual_loss(0),
+	expanding(false) {
 }
 
-VNode::VNode(int count, double value, int depth, QNode* parent, OBS_TYPE edge) :
+VNode::VNode(int count, double value, int depth, QNode* parent, OBS_TYPE edge,
+	Arena* arena) :
 	belief_(NULL),
 	depth_(depth),
 	parent_(parent),
 	edge_(edge),
+	children_(ActionChildren::allocator_type(arena)),
 	count_(count),
-	value_(value) {
+	value_(value),
+	virtual_loss(0),
+	expanding(false) {
 }
 
 VNode::~VNode() {
-	for (int a = 0; a < children_.size(); a++) {
-		QNode* child = children_[a];
-		assert(child != NULL);
-		delete child;
+	// children in an arena are released with the arena
+	if (arena() == NULL) {
+		for (int a = 0; a < children_.size(); a++) {
+			QNode* child = children_[a];
+			assert(child != NULL);
+			delete child;
+		}
 	}
 	children_.clear();
 
@@ -78,6 +90,44 @@ VNode::~VNode() {
 		delete belief_;
 }
 
+VNode* VNode::Create(Arena* arena, vector<State*>& particles, int depth,
+	QNode* parent, OBS_TYPE edge) {
+	if (arena == NULL)
+		return new VNode(particles, depth, parent, edge);
+	return new (arena->Allocate(sizeof(VNode), alignof(VNode)))
+		VNode(particles, depth, parent, edge, arena);
+}
+
+VNode* VNode::Create(Arena* arena, int count, double value, int depth,
+	QNode* parent, OBS_TYPE edge) {
+	if (arena == NULL)
+		return new VNode(count, value, depth, parent, edge);
+	return new (arena->Allocate(sizeof(VNode), alignof(VNode)))
+		VNode(count, value, depth, parent, edge, arena);
+}
+
+VNode* VNode::MoveSubtree(Arena* arena, QNode* parent) {
+	assert(belief_ == NULL);
+	VNode* copy = Create(arena, count_, value_, depth_, parent, edge_);
+	copy->particles_.swap(particles_);
+	copy->default_move_ = default_move_;
+	copy->lower_bound_ = lower_bound_;
+	copy->upper_bound_ = upper_bound_;
+	copy->vstar = copy;
+	copy->likelihood = likelihood;
+	copy->utility_upper_bound = utility_upper_bound;
+
+	copy->children_.reserve(children_.size());
+	for (int a = 0; a < children_.size(); a++) {
+		copy->children_.push_back(children_[a]->MoveSubtree(arena, copy));
+	}
+	return copy;
+}
+
+Arena* VNode::arena() const {
+	return children_.get_allocator().arena();
+}
+
 Belief* VNode::belief() const {
 	return belief_;
 }
@@ -110,11 +160,11 @@ double VNode::Weight() const {
 	return State::Weight(particles_);
 }
 
-const vector<QNode*>& VNode::children() const {
+const ActionChildren& VNode::children() const {
 	return children_;
 }
 
-vector<QNode*>& VNode::children() {
+ActionChildren& VNode::children() {
 	return children_;
 }
 
@@ -197,11 +247,13 @@ void VNode::Free(const DSPOMDP& model) {
 	for (int i = 0; i < particles_.size(); i++) {
 		model.Free(particles_[i]);
 	}
+	// the particle vector is the only memory outside the arena of a node
+	vector<State*>().swap(particles_);
 
 	for (int a = 0; a < children().size(); a++) {
 		QNode* qnode = Child(a);
-		map<OBS_TYPE, VNode*>& children = qnode->children();
-		for (map<OBS_TYPE, VNode*>::iterator it = children.begin();
+		ObsChildren& children = qnode->children();
+		for (ObsChildren::iterator it = children.begin();
 			it != children.end(); it++) {
 			it->second->Free(model);
 		}
@@ -212,7 +264,7 @@ void VNode::PrintPolicyTree(int depth, ostream& os) {
 	if (depth != -1 && this->depth() > depth)
 		return;
 
-	vector<QNode*>& qnodes = children();
+	ActionChildren& qnodes = children();
 	if (qnodes.size() == 0) {
 		int astar = this->default_move().action;
 		os << this << "-a=" << astar << endl;
@@ -228,8 +280,8 @@ void VNode::PrintPolicyTree(int depth, ostream& os) {
 		os << this << "-a=" << qstar->edge() << endl;
 
 		vector<OBS_TYPE> labels;
-		map<OBS_TYPE, VNode*>& vnodes = qstar->children();
-		for (map<OBS_TYPE, VNode*>::iterator it = vnodes.begin();
+		ObsChildren& vnodes = qstar->children();
+		for (ObsChildren::iterator it = vnodes.begin();
 			it != vnodes.end(); it++) {
 			labels.push_back(it->first);
 		}
@@ -249,9 +301,9 @@ int VNode::Height() // NATAN CHANGES
 	int maxHeight = 0;
 	for (int a = 0; a < children_.size(); a++) 
 	{
-		std::map<OBS_TYPE, VNode *> childs = children_[a]->children();
+		const ObsChildren& childs = children_[a]->children();
 		
-		std::for_each(childs.begin(), childs.end(), [&maxHeight](std::map<OBS_TYPE, VNode *>::const_reference itr)
+		std::for_each(childs.begin(), childs.end(), [&maxHeight](ObsChildren::const_reference itr)
 		{
 			int height = itr.second->Height();
 			maxHeight = height * (height >= maxHeight) + maxHeight * (height < maxHeight);
@@ -265,9 +317,9 @@ void  VNode::LevelSize(std::vector<double> & DividedSize, int currLevel)// NATAN
 {
 	for (int a = 0; a < children_.size(); a++)
 	{
-		std::map<OBS_TYPE, VNode *> childs = children_[a]->children();
+		const ObsChildren& childs = children_[a]->children();
 
-		std::for_each(childs.begin(), childs.end(), [&](std::map<OBS_TYPE, VNode *>::const_reference itr)
+		std::for_each(childs.begin(), childs.end(), [&](ObsChildren::const_reference itr)
 		{
 			itr.second->LevelSize(DividedSize, currLevel + 1);
 			++DividedSize[currLevel];
@@ -280,9 +332,9 @@ void  VNode::LevelActionSize(std::vector<std::vector<double>> & DividedSize, int
 {
 	for (int a = 0; a < children_.size(); a++)
 	{
-		std::map<OBS_TYPE, VNode *> childs = children_[a]->children();
+		const ObsChildren& childs = children_[a]->children();
 
-		std::for_each(childs.begin(), childs.end(), [&](std::map<OBS_TYPE, VNode *>::const_reference itr)
+		std::for_each(childs.begin(), childs.end(), [&](ObsChildren::const_reference itr)
 		{
 			itr.second->LevelActionSize(DividedSize, currLevel + 1);
 			++DividedSize[a][currLevel];
@@ -307,8 +359,8 @@ void VNode::PreferredActionPortion(std::vector<double> & portion, const std::vec
 	double preferredSize = children_[preferredAction]->children().size();
 	
 	// compute the next ratio
-	std::map<OBS_TYPE, VNode *> childs = children_[preferredAction]->children();
-	std::for_each(childs.begin(), childs.end(), [&](std::map<OBS_TYPE, VNode *>::const_reference itr)
+	const ObsChildren& childs = children_[preferredAction]->children();
+	std::for_each(childs.begin(), childs.end(), [&](ObsChildren::const_reference itr)
 	{
 		itr.second->PreferredActionPortion(portion, sizes, currLevel + 1);
 	});
@@ -338,13 +390,13 @@ void VNode::PrintTree(int depth, ostream& os) {
 		<< endl;
 
 
-	vector<QNode*>& qnodes = children();
+	ActionChildren& qnodes = children();
 	for (int a = 0; a < qnodes.size(); a++) {
 		QNode* qnode = qnodes[a];
 
 		vector<OBS_TYPE> labels;
-		map<OBS_TYPE, VNode*>& vnodes = qnode->children();
-		for (map<OBS_TYPE, VNode*>::iterator it = vnodes.begin();
+		ObsChildren& vnodes = qnode->children();
+		for (ObsChildren::iterator it = vnodes.begin();
 			it != vnodes.end(); it++) {
 			labels.push_back(it->first);
 		}
@@ -369,26 +421,65 @@ void VNode::PrintTree(int depth, ostream& os) {
  * QNode class
  * =============================================================================*/
 
-QNode::QNode(VNode* parent, int edge) :
+QNode::QNode(VNode* parent, int edge, Arena* arena) :
 	parent_(parent),
 	edge_(edge),
-	vstar(NULL) {
+	children_(less<OBS_TYPE>(), ObsChildren::allocator_type(arena)),
+	vstar(NULL),
+	virtual_loss(0) {
 }
 
 QNode::QNode(int count, double value) :
 	count_(count),
-	value_(value) {
+	value_(value),
+	virtual_loss(0) {
 }
 
 QNode::~QNode() {
-	for (map<OBS_TYPE, VNode*>::iterator it = children_.begin();
-		it != children_.end(); it++) {
-		assert(it->second != NULL);
-		delete it->second;
+	// children in an arena are released with the arena
+	if (arena() == NULL) {
+		for (ObsChildren::iterator it = children_.begin();
+			it != children_.end(); it++) {
+			assert(it->second != NULL);
+			delete it->second;
+		}
 	}
 	children_.clear();
 }
 
+QNode* QNode::Create(Arena* arena, VNode* parent, int edge) {
+	if (arena == NULL)
+		return new QNode(parent, edge);
+	return new (arena->Allocate(sizeof(QNode), alignof(QNode)))
+		QNode(parent, edge, arena);
+}
+
+QNode* QNode::MoveSubtree(Arena* arena, VNode* parent) {
+	QNode* copy = Create(arena, parent, edge_);
+	copy->lower_bound_ = lower_bound_;
+	copy->upper_bound_ = upper_bound_;
+	copy->count_ = count_;
+	copy->value_ = value_;
+	copy->default_value = default_value;
+	copy->utility_upper_bound = utility_upper_bound;
+	copy->step_reward = step_reward;
+	copy->likelihood = likelihood;
+
+	for (ObsChildren::iterator it = children_.begin();
+		it != children_.end(); it++) {
+		// POMCP keeps NULL entries for observations looked up but not added
+		VNode* child = it->second != NULL
+			? it->second->MoveSubtree(arena, copy) : NULL;
+		copy->children_.insert(copy->children_.end(),
+			make_pair(it->first, child));
+	}
+	return copy;
+}
+
+Arena* QNode::arena() const {
+	return children_.get_allocator().arena();
+}
+
 void QNode::parent(VNode* parent) {
 	parent_ = parent;
 }
@@ -401,7 +492,7 @@ int QNode::edge() {
 	return edge_;
 }
 
-map<OBS_TYPE, VNode*>& QNode::children() {
+ObsChildren& QNode::children() {
 	return children_;
 }
 
@@ -411,7 +502,7 @@ VNode* QNode::Child(OBS_TYPE obs) {
 
 int QNode::Size() const {
 	int size = 0;
-	for (map<OBS_TYPE, VNode*>::const_iterator it = children_.begin();
+	for (ObsChildren::const_iterator it = children_.begin();
 		it != children_.end(); it++) {
 		size += it->second->Size();
 	}
@@ -420,7 +511,7 @@ int QNode::Size() const {
 
 int QNode::PolicyTreeSize() const {
 	int size = 0;
-	for (map<OBS_TYPE, VNode*>::const_iterator it = children_.begin();
+	for (ObsChildren::const_iterator it = children_.begin();
 		it != children_.end(); it++) {
 		size += it->second->PolicyTreeSize();
 	}
@@ -429,7 +520,7 @@ int QNode::PolicyTreeSize() const {
 
 double QNode::Weight() const {
 	double weight = 0;
-	for (map<OBS_TYPE, VNode*>::const_iterator it = children_.begin();
+	for (ObsChildren::const_iterator it = children_.begin();
 		it != children_.end(); it++) {
 		weight += it->second->Weight();
 	}
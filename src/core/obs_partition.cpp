@@ -0,0 +1,53 @@
+#include "../../include/despot/core/obs_partition.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace despot {
+
+/* =============================================================================
+ * ObsPartition class
+ * =============================================================================*/
+
+void ObsPartition::Clear() {
+	entries_.clear();
+	range_begin_.clear();
+}
+
+void ObsPartition::Add(OBS_TYPE obs, int index) {
+	entries_.push_back(make_pair(obs, index));
+}
+
+void ObsPartition::Partition() {
+	// ties on the observation are broken by index, so each range lists its
+	// particles in index order
+	sort(entries_.begin(), entries_.end());
+
+	range_begin_.clear();
+	for (int i = 0; i < entries_.size(); i++) {
+		if (i == 0 || entries_[i].first != entries_[i - 1].first)
+			range_begin_.push_back(i);
+	}
+}
+
+int ObsPartition::NumRanges() const {
+	return range_begin_.size();
+}
+
+OBS_TYPE ObsPartition::Observation(int range) const {
+	return entries_[range_begin_[range]].first;
+}
+
+void ObsPartition::Gather(int range, const vector<State*>& particles,
+	vector<State*>& out) const {
+	int begin = range_begin_[range];
+	int end = range + 1 < range_begin_.size() ? range_begin_[range + 1]
+		: entries_.size();
+
+	out.clear();
+	for (int i = begin; i < end; i++)
+		out.push_back(particles[entries_[i].second]);
+}
+
+} // namespace despot
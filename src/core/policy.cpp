@@ -1,5 +1,7 @@
 #include "../../include/despot/core/policy.h"
 #include "../../include/despot/core/pomdp.h"
+#include "../../include/despot/core/obs_partition.h"
+#include <deque>
 //#include <unistd.h>
 
 using namespace std;
@@ -26,8 +28,9 @@ ValuedAction Policy::Value(const vector<State*>& particles,
 	for (int i = 0; i < particles.size(); i++)
 		copy.push_back(model_->Copy(particles[i]));
 
-	initial_depth_ = history.Size();
-	ValuedAction va = RecursiveValue(copy, streams, history);
+	// the initial depth is passed down instead of kept in the policy so
+	// concurrent search threads can share the policy
+	ValuedAction va = RecursiveValue(copy, streams, history, history.Size());
 
 	for (int i = 0; i < copy.size(); i++)
 		model_->Free(copy[i]);
@@ -35,38 +38,71 @@ ValuedAction Policy::Value(const vector<State*>& particles,
 	return va;
 }
 
+// Buffers of one level of the policy simulation, reused across calls
+struct PolicyLevelScratch {
+	vector<double> randomNums;
+	vector<OBS_TYPE> lastObs;
+	vector<double> rewards;
+	vector<OBS_TYPE> obs;
+	vector<bool> terminals;
+	ObsPartition partition;
+	vector<State*> child_particles;
+};
+
 ValuedAction Policy::RecursiveValue(const vector<State*>& particles,
-	RandomStreams& streams, History& history) const {
+	RandomStreams& streams, History& history, int initial_depth) const {
 	if (streams.Exhausted()
-		|| (history.Size() - initial_depth_
+		|| (history.Size() - initial_depth
 			>= Globals::config.max_policy_sim_len)) {
 		return particle_lower_bound_->Value(particles);
 	} else {
+		// one scratch per level of each thread; a deque keeps the references of
+		// the outer levels valid when a deeper level is added
+		static thread_local deque<PolicyLevelScratch> levels;
+		int level = history.Size() - initial_depth;
+		while (levels.size() <= level)
+			levels.push_back(PolicyLevelScratch());
+		PolicyLevelScratch& scratch = levels[level];
+
 		int action = Action(particles, streams, history);
 
 		double value = 0;
 
-		map<OBS_TYPE, vector<State*> > partitions;
-		OBS_TYPE obs;
-		double reward;
+		OBS_TYPE prevObs = history.Size() > 0 ? history.LastObservation() : 0;
+		vector<double>& randomNums = scratch.randomNums;
+		vector<OBS_TYPE>& lastObs = scratch.lastObs;
+		randomNums.resize(particles.size());
+		lastObs.resize(particles.size());
 		for (int i = 0; i < particles.size(); i++) {
-			State* particle = particles[i];
-			bool terminal = model_->Step(*particle,
-				streams.Entry(particle->scenario_id), action, reward, obs);
+			randomNums[i] = streams.Entry(particles[i]->scenario_id);
+			lastObs[i] = prevObs + particles[i]->state_id * (prevObs == 0);
+		}
 
-			value += reward * particle->weight;
+		vector<double>& rewards = scratch.rewards;
+		vector<OBS_TYPE>& obs = scratch.obs;
+		vector<bool>& terminals = scratch.terminals;
+		model_->CachedStepBatch(particles, randomNums, action, lastObs, rewards, obs,
+			terminals);
 
-			if (!terminal) {
-				partitions[obs].push_back(particle);
+		ObsPartition& partition = scratch.partition;
+		partition.Clear();
+		for (int i = 0; i < particles.size(); i++) {
+			State* particle = particles[i];
+			value += rewards[i] * particle->weight;
+
+			if (!terminals[i]) {
+				partition.Add(obs[i], i);
 			}
 		}
+		partition.Partition();
 
-		for (map<OBS_TYPE, vector<State*> >::iterator it = partitions.begin();
-			it != partitions.end(); it++) {
-			OBS_TYPE obs = it->first;
+		for (int r = 0; r < partition.NumRanges(); r++) {
+			OBS_TYPE obs = partition.Observation(r);
+			partition.Gather(r, particles, scratch.child_particles);
 			history.Add(action, obs);
 			streams.Advance();
-			ValuedAction va = RecursiveValue(it->second, streams, history);
+			ValuedAction va = RecursiveValue(scratch.child_particles, streams,
+				history, initial_depth);
 			value += Globals::Discount() * va.value;
 			streams.Back();
 			history.RemoveLast();
@@ -112,6 +148,10 @@ int BlindPolicy::Action(const vector<State*>& particles, RandomStreams& streams,
 	return action_;
 }
 
+bool BlindPolicy::IsThreadSafe() const {
+	return particle_lower_bound()->IsThreadSafe();
+}
+
 ValuedAction BlindPolicy::Search() {
 	double dummy_value = Globals::NEG_INFTY;
 	return ValuedAction(action_, dummy_value);
@@ -2,6 +2,7 @@
 #include "../../include/despot/core/policy.h"
 #include "../../include/despot/core/lower_bound.h"
 #include "../../include/despot/core/upper_bound.h"
+#include "../../include/despot/core/transition_cache.h"
 #include "../../include/despot/solver/pomcp.h"
 
 using namespace std;
@@ -79,6 +80,67 @@ bool DSPOMDP::Step(State& state, double random_num, int action, OBS_TYPE lastObs
 	return Step(state, random_num, action, lastObs, reward, obs);
 }
 
+void DSPOMDP::StepBatch(const vector<State*>& particles,
+	const vector<double>& randomNums, int action,
+	const vector<OBS_TYPE>& lastObs, vector<double>& rewards,
+	vector<OBS_TYPE>& obs, vector<bool>& terminals) const {
+	rewards.resize(particles.size());
+	obs.resize(particles.size());
+	terminals.resize(particles.size());
+	for (int i = 0; i < particles.size(); i++) {
+		terminals[i] = Step(*particles[i], randomNums[i], action, lastObs[i],
+			rewards[i], obs[i]);
+	}
+}
+
+void DSPOMDP::EnableTransitionCache(int capacity, int random_buckets) {
+	transition_cache_.reset(capacity > 0 ?
+		new TransitionCache(this, capacity, random_buckets) : NULL);
+}
+
+bool DSPOMDP::SupportsTransitionCache() const {
+	return false;
+}
+
+bool DSPOMDP::IsThreadSafe() const {
+	return false;
+}
+
+TransitionCache* DSPOMDP::transition_cache() const {
+	return transition_cache_.get();
+}
+
+bool DSPOMDP::CachedStep(State& state, double random_num, int action,
+	OBS_TYPE lastObs, double& reward, OBS_TYPE& obs) const {
+	if (transition_cache_ != NULL)
+		return transition_cache_->Step(state, random_num, action, lastObs,
+			reward, obs);
+	return Step(state, random_num, action, lastObs, reward, obs);
+}
+
+void DSPOMDP::CachedStepBatch(const vector<State*>& particles,
+	const vector<double>& randomNums, int action,
+	const vector<OBS_TYPE>& lastObs, vector<double>& rewards,
+	vector<OBS_TYPE>& obs, vector<bool>& terminals) const {
+	if (transition_cache_ != NULL)
+		transition_cache_->StepBatch(particles, randomNums, action, lastObs,
+			rewards, obs, terminals);
+	else
+		StepBatch(particles, randomNums, action, lastObs, rewards, obs,
+			terminals);
+}
+
+OBS_TYPE DSPOMDP::TransitionObs(int action, OBS_TYPE lastObs) const {
+	return lastObs;
+}
+
+void DSPOMDP::ObsProbBatch(OBS_TYPE obs, const vector<State*>& particles,
+	int action, vector<double>& probs) const {
+	probs.resize(particles.size());
+	for (int i = 0; i < particles.size(); i++)
+		probs[i] = ObsProb(obs, *particles[i], action);
+}
+
 ParticleUpperBound* DSPOMDP::CreateParticleUpperBound(string name) const {
 	if (name == "TRIVIAL" || name == "DEFAULT") {
 		return new TrivialParticleUpperBound(this);
@@ -27,7 +27,10 @@ SearchStatistics::SearchStatistics() :
 	num_particles_before_search(0),
 	num_particles_after_search(0),
 	num_trials(0),
-	longest_trial_length(0) {
+	longest_trial_length(0),
+	prior_cache_used(false),
+	num_prior_cache_hits(0),
+	num_prior_cache_misses(0) {
 }
 
 ostream& operator<<(ostream& os, const SearchStatistics& statistics) {
@@ -44,6 +47,9 @@ ostream& operator<<(ostream& os, const SearchStatistics& statistics) {
 	os << "# nodes: expanded / total / policy = "
 		<< statistics.num_expanded_nodes << " / " << statistics.num_tree_nodes
 		<< " / " << statistics.num_policy_nodes << endl;
+	if (statistics.prior_cache_used)
+		os << "Prior cache: hits / misses = " << statistics.num_prior_cache_hits
+			<< " / " << statistics.num_prior_cache_misses << endl;
 	os << "# particles: initial / final / tree = "
 		<< statistics.num_particles_before_search << " / "
 		<< statistics.num_particles_after_search << " / "
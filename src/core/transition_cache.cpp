@@ -0,0 +1,126 @@
+#include "../../include/despot/core/transition_cache.h"
+#include "../../include/despot/core/pomdp.h"
+
+using namespace std;
+
+namespace despot {
+
+/* =============================================================================
+ * TransitionCache class
+ * =============================================================================*/
+
+TransitionCache::TransitionCache(const DSPOMDP* model, int capacity,
+	int random_buckets, int num_stripes) :
+	model_(model),
+	random_buckets_(random_buckets),
+	entries_(capacity),
+	locks_(num_stripes),
+	hits_(0),
+	misses_(0) {
+	Clear();
+}
+
+size_t TransitionCache::Slot(STATE_TYPE state_id, int action, int bucket,
+	OBS_TYPE last_obs) const {
+	// mix the key fields (splitmix64 finalizer) so near states spread over the table
+	uint64_t x = static_cast<uint64_t>(state_id);
+	x = x * 0x9E3779B97F4A7C15ULL + static_cast<uint64_t>(action);
+	x = x * 0x9E3779B97F4A7C15ULL + static_cast<uint64_t>(bucket);
+	x = x * 0x9E3779B97F4A7C15ULL + static_cast<uint64_t>(last_obs);
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	x ^= x >> 31;
+	return x % entries_.size();
+}
+
+bool TransitionCache::Step(State& state, double random_num, int action,
+	OBS_TYPE lastObs, double& reward, OBS_TYPE& obs) const {
+	int bucket = min((int) (random_num * random_buckets_), random_buckets_ - 1);
+	OBS_TYPE last_obs = model_->TransitionObs(action, lastObs);
+	STATE_TYPE state_id = state.state_id;
+
+	size_t slot = Slot(state_id, action, bucket, last_obs);
+	mutex& lock = locks_[slot % locks_.size()];
+	{
+		lock_guard<mutex> guard(lock);
+		const Entry& entry = entries_[slot];
+		if (entry.valid && entry.state_id == state_id && entry.action == action
+			&& entry.bucket == bucket && entry.last_obs == last_obs) {
+			state.state_id = entry.next_state_id;
+			reward = entry.reward;
+			obs = entry.obs;
+			hits_++;
+			return entry.terminal;
+		}
+	}
+
+	// step with the center of the bucket so every random number in the bucket has the same transition
+	double bucket_random = (bucket + 0.5) / random_buckets_;
+	bool terminal = model_->Step(state, bucket_random, action, lastObs, reward,
+		obs);
+	misses_++;
+
+	lock_guard<mutex> guard(lock);
+	Entry& entry = entries_[slot];
+	entry.valid = true;
+	entry.state_id = state_id;
+	entry.action = action;
+	entry.bucket = bucket;
+	entry.last_obs = last_obs;
+	entry.next_state_id = state.state_id;
+	entry.reward = reward;
+	entry.obs = obs;
+	entry.terminal = terminal;
+
+	return terminal;
+}
+
+void TransitionCache::StepBatch(const vector<State*>& particles,
+	const vector<double>& randomNums, int action,
+	const vector<OBS_TYPE>& lastObs, vector<double>& rewards,
+	vector<OBS_TYPE>& obs, vector<bool>& terminals) const {
+	rewards.resize(particles.size());
+	obs.resize(particles.size());
+	terminals.resize(particles.size());
+	for (int i = 0; i < particles.size(); i++) {
+		terminals[i] = Step(*particles[i], randomNums[i], action, lastObs[i],
+			rewards[i], obs[i]);
+	}
+}
+
+void TransitionCache::Clear() {
+	for (int i = 0; i < locks_.size(); i++)
+		locks_[i].lock();
+
+	for (int i = 0; i < entries_.size(); i++)
+		entries_[i].valid = false;
+
+	for (int i = 0; i < locks_.size(); i++)
+		locks_[i].unlock();
+}
+
+long long TransitionCache::hits() const {
+	return hits_;
+}
+
+long long TransitionCache::misses() const {
+	return misses_;
+}
+
+double TransitionCache::HitRate() const {
+	long long total = hits_ + misses_;
+	return total > 0 ? (double) hits_ / total : 0;
+}
+
+void TransitionCache::ResetStatistics() {
+	hits_ = 0;
+	misses_ = 0;
+}
+
+void TransitionCache::PrintStatistics(ostream& out) const {
+	out << "Transition cache: size = " << entries_.size() << ", hits = "
+		<< hits() << ", misses = " << misses() << ", hit rate = " << HitRate()
+		<< endl;
+}
+
+} // namespace despot
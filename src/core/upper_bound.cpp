@@ -19,6 +19,10 @@ ScenarioUpperBound::~ScenarioUpperBound() {
 void ScenarioUpperBound::Init(const RandomStreams& streams) {
 }
 
+bool ScenarioUpperBound::IsThreadSafe() const {
+	return false;
+}
+
 /* =============================================================================
  * ParticleUpperBound
  * =============================================================================*/
@@ -59,6 +63,10 @@ double TrivialParticleUpperBound::Value(const vector<State*>& particles,
 	return State::Weight(particles) * model_->GetMaxReward() / (1 - Globals::Discount());
 }
 
+bool TrivialParticleUpperBound::IsThreadSafe() const {
+	return true;
+}
+
 /* =============================================================================
  * LookaheadUpperBound
  * =============================================================================*/
@@ -30,11 +30,14 @@ static MODELS_AVAILABLE s_UsingModel = NXN_GLOBAL_ACTIONS;
 static std::vector<std::string> s_LUTFILENAMES{  "10x10Grid1x0x1_LUT_POMDP.bin"}; // "5x5Grid2x0x1_LUT_POMDP.bin", 
 static std::vector<int> s_LUT_GRIDSIZE{ 10};
 static std::vector<nxnGrid::CALCULATION_TYPE> s_CALCTYPE{ nxnGrid::CALCULATION_TYPE::WO_NINV }; // , nxnGrid::CALCULATION_TYPE::ONE_ENEMY
+// lut pyramid (luts of the same problem in different grid sizes). empty pyramid skips the pyramid run
+static std::vector<std::string> s_PYRAMID_LUTFILENAMES{}; // "5x5Grid1x0x1_LUT_POMDP.bin", "10x10Grid1x0x1_LUT_POMDP.bin", "20x20Grid1x0x1_LUT_POMDP.bin"
+static std::vector<int> s_PYRAMID_GRIDSIZE{}; // 5, 10, 20
 
 static int s_onlineGridSize = 10;
 
-void ReadOfflineLUT(std::string & lutFName, std::map<STATE_TYPE, std::vector<double>> &offlineLut);
-void Run(int argc, char* argv[], std::string & outputFName, int numRuns);
+std::shared_ptr<const OfflineLUT> ReadOfflineLUT(std::string & lutFName);
+void Run(int argc, char* argv[], std::string & outputFName, int numRuns, const nxnGrid::Settings & settings);
 void InitObjectsLocations(std::vector<std::vector<int>> & objVec, int gridSize);
 
 Attack_Obj CreateEnemy(int x, int y, int gridSize);
@@ -45,7 +48,7 @@ ObjInGrid CreateShelter(int x, int y);
 /// solve nxn Grid problem
 class NXNGrid : public SimpleTUI {
 public:
-	NXNGrid() {}
+	explicit NXNGrid(const nxnGrid::Settings & settings) : m_settings(settings) {}
 
 	DSPOMDP* InitializeModel(option::Option* options) override
 	{
@@ -62,9 +65,9 @@ public:
 
 		nxnGrid *model;
 		if (s_UsingModel == NXN_LOCAL_ACTIONS)
-			model = new nxnGridLocalActions(s_onlineGridSize, targetLoc, self, objVec);
+			model = new nxnGridLocalActions(s_onlineGridSize, targetLoc, self, objVec, m_settings);
 		else if (s_UsingModel == NXN_GLOBAL_ACTIONS)
-			model = new nxnGridGlobalActions(s_onlineGridSize, targetLoc, self, objVec);
+			model = new nxnGridGlobalActions(s_onlineGridSize, targetLoc, self, objVec, true, m_settings);
 		else
 		{
 			std::cout << "model not recognized... exiting!!\n";
@@ -83,6 +86,10 @@ public:
 	}
 
 	void InitializeDefaultParameters() override {}
+
+private:
+	/// lut and simulator connection of the created models
+	nxnGrid::Settings m_settings;
 };
 
 int main(int argc, char* argv[]) 
@@ -90,14 +97,41 @@ int main(int argc, char* argv[])
 	int numRuns = 15;
 	srand(time(NULL));
 
-	nxnGrid::InitUDP();
+	// convert old lut file to flat (memory mapped) lut file: despot --convert-lut <old lut> <flat lut>
+	if (argc == 4 && std::string(argv[1]) == "--convert-lut")
+	{
+		bool stat = OfflineLUT::Convert(argv[2], argv[3]);
+		std::cout << (stat ? "lut converted succesfuly\n" : "failed convert lut\n");
+		return stat ? 0 : 1;
+	}
+
+	// compress lut file with values quantized to 8 or 16 bits: despot --compress-lut <lut> <compressed lut> <bits>
+	if (argc == 5 && std::string(argv[1]) == "--compress-lut")
+	{
+		OfflineLUT::CompressionReport report;
+		bool stat = OfflineLUT::Compress(argv[2], argv[3], atoi(argv[4]), report);
+		if (stat)
+		{
+			std::cout << "lut compressed from " << report.m_originalSize << " bytes to " << report.m_compressedSize << " bytes\n";
+			std::cout << "max value error = " << report.m_maxError << "\n";
+			std::cout << "argmax action disagreement = " << report.m_numArgmaxDisagree << " / " << report.m_numStates << " states ("
+				<< (report.m_numStates > 0 ? 100.0 * report.m_numArgmaxDisagree / report.m_numStates : 0.0) << "%)\n";
+		}
+		else
+			std::cout << "failed compress lut\n";
+		return stat ? 0 : 1;
+	}
+
+	std::shared_ptr<UDP_Server> udpServer = nxnGrid::InitUDP();
 
 	//for (int j = 0; j < s_LUTFILENAMES.size(); ++j)
 	//{
 	//	// init lut
-	//	std::map<STATE_TYPE, std::vector<double>> offlineLut;
-	//	ReadOfflineLUT(s_LUTFILENAMES[j], offlineLut);
-	//	nxnGrid::InitLUT(offlineLut, s_LUT_GRIDSIZE[j], nxnGrid::ONLINE ,s_CALCTYPE[j]);
+	//	std::shared_ptr<const OfflineLUT> offlineLut = ReadOfflineLUT(s_LUTFILENAMES[j]);
+	//	nxnGrid::Settings settings;
+	//	settings.m_LUTs = { { offlineLut, s_LUT_GRIDSIZE[j] } };
+	//	settings.m_calculationType = s_CALCTYPE[j];
+	//	settings.m_udpServer = udpServer;
 	//	// create output file
 
 	//	std::string outputFName(s_LUTFILENAMES[j]);
@@ -109,14 +143,30 @@ int main(int argc, char* argv[])
 
 	//	//outputFName.append("_resultOffline.txt");
 	//	outputFName.append("_result.txt");
-	//	Run(argc, argv, outputFName, numRuns);
+	//	Run(argc, argv, outputFName, numRuns, settings);
 	//}
 
+	if (!s_PYRAMID_LUTFILENAMES.empty())
+	{
+		std::vector<nxnGrid::LUTLevel> levels;
+		for (int j = 0; j < s_PYRAMID_LUTFILENAMES.size(); ++j)
+			levels.push_back({ ReadOfflineLUT(s_PYRAMID_LUTFILENAMES[j]), s_PYRAMID_GRIDSIZE[j] });
+
+		nxnGrid::Settings settings;
+		settings.m_LUTs = levels;
+		settings.m_calculationType = s_CALCTYPE[0];
+		settings.m_udpServer = udpServer;
+		std::string outputFName("pyramid_result.txt");
+		Run(argc, argv, outputFName, numRuns, settings);
+	}
+
 	{
 		std::string outputFName("naive_result.txt");
 		std::map<STATE_TYPE, std::vector<double>> offlineLut;
-		nxnGrid::InitLUT(offlineLut, 10);
-		Run(argc, argv, outputFName, numRuns);
+		nxnGrid::Settings settings;
+		settings.m_LUTs = { { std::make_shared<const OfflineLUT>(offlineLut), 10 } };
+		settings.m_udpServer = udpServer;
+		Run(argc, argv, outputFName, numRuns, settings);
 	}
 
 	char c;
@@ -125,46 +175,21 @@ int main(int argc, char* argv[])
 	return 0;
 }
 
-void ReadOfflineLUT(std::string & lutFName, std::map<STATE_TYPE, std::vector<double>> &offlineLut)
+std::shared_ptr<const OfflineLUT> ReadOfflineLUT(std::string & lutFName)
 {
-	std::ifstream readLut(lutFName, std::ios::in | std::ios::binary);
-	if (readLut.fail())
+	// flat lut files are mapped to memory, old format files are read and kept in memory
+	std::shared_ptr<OfflineLUT> offlineLut = std::make_shared<OfflineLUT>();
+	if (!offlineLut->Load(lutFName))
 	{
-		std::cout << "failed open lut file for write\n\n\n";
+		std::cout << "failed read lut\n\n\n";
 		exit(1);
 	}
-	else
-	{
-		int size;
-		readLut.read(reinterpret_cast<char *>(&size), sizeof(int));
-		int numActions;
-		readLut.read(reinterpret_cast<char *>(&numActions), sizeof(int));
-		for (int i = 0; i < size; ++i)
-		{
-			int state;
-			readLut.read(reinterpret_cast<char *>(&state), sizeof(int));
-			
-			std::vector<double> rewards(numActions);
-			for (int a = 0; a < numActions; ++a)
-			{
-				readLut.read(reinterpret_cast<char *>(&rewards[a]), sizeof(double));
-			}
-
-			offlineLut[state] = rewards;
-		}
-		if (readLut.bad())
-		{
-			std::cout << "failed write lut\n\n\n";
-			exit(1);
-		}
-		else
-			std::cout << "lut written succesfuly\n\n\n";
 
-		readLut.close();
-	}
+	std::cout << "lut read succesfuly (" << offlineLut->Size() << " states" << (offlineLut->IsMapped() ? ", mapped" : "") << ")\n\n\n";
+	return offlineLut;
 }
 
-void Run(int argc, char* argv[], std::string & outputFName, int numRuns)
+void Run(int argc, char* argv[], std::string & outputFName, int numRuns, const nxnGrid::Settings & settings)
 {
 	remove(outputFName.c_str());
 	std::ofstream output(outputFName.c_str(), std::ios::out);
@@ -180,7 +205,7 @@ void Run(int argc, char* argv[], std::string & outputFName, int numRuns)
 	{
 		std::cout << "\n\n\trun #" << i << ":\n";
 		output << "\n\n\trun #" << i << ":\n";
-		NXNGrid().run(argc, argv, output);
+		NXNGrid(settings).run(argc, argv, output);
 		output.flush();
 	}
 
@@ -167,12 +167,11 @@ bool Evaluator::RunStep(int step, int round) {
 	double offlineReward;
 	int action;
 	double startStep = get_time_second();
-	if (nxnGrid::GetModelType() == nxnGrid::ONLINE)
+	if (static_cast<nxnGrid *>(model_)->GetModelType() == nxnGrid::ONLINE)
 		action = solver_->Search().action;
 	else
 	{
-		std::vector<double> rewards;
-		static_cast<nxnGrid *>(model_)->ChoosePreferredAction(static_cast<POMCP *>(solver_)->GetPrior(), model_, rewards);
+		const std::vector<double> & rewards = static_cast<nxnGrid *>(model_)->ChoosePreferredAction(static_cast<POMCP *>(solver_)->GetPrior(), model_);
 	}
 	double endSearch = get_time_second();
 	
@@ -191,7 +190,7 @@ bool Evaluator::RunStep(int step, int round) {
 	bool terminal;
 
 	// if evaluation is with vbs send action and recieve state
-	if (nxnGrid::GetModelType() == nxnGrid::VBS)
+	if (static_cast<nxnGrid *>(model_)->GetModelType() == nxnGrid::VBS)
 	{
 		// send action to simulator
 		static_cast<nxnGrid *>(model_)->SendAction(action);
@@ -269,7 +268,7 @@ bool Evaluator::RunStep(int step, int round) {
 	start_t = get_time_second();
 
 	// update action and observation in history and belief state(not exist in offline)
-	if (nxnGrid::GetModelType() != nxnGrid::OFFLINE )
+	if (static_cast<nxnGrid *>(model_)->GetModelType() != nxnGrid::OFFLINE )
 		solver_->Update(action, obs);
 	else
 		solver_->UpdateHistory(action, obs);
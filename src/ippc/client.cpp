@@ -1,9 +1,6 @@
 #include "../../include/despot/ippc/client.h"
 #include "../../include/despot/util/tinyxml/tinyxml.h"
 #include <iostream>
-//#include <winsock2.h>
-#include <WS2tcpip.h>
-#include <winsock2.h>
 
 #pragma comment(lib,"ws2_32.lib")
 
@@ -73,8 +70,11 @@ void Client::connectToServer() {
 
 void Client::closeConnection() {
 	freeaddrinfo(host_info_list);
-//###	close(socketfd);
+#ifdef _WIN32
 	closesocket(socketfd);
+#else
+	close(socketfd);
+#endif
 }
 void Client::sendMessage(string sendbuf) {
 	cout << "message: " << sendbuf << endl;
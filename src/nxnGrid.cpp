@@ -1,8 +1,11 @@
 #include <string>
 #include <math.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 
 
-#include "..\include\despot\solver\pomcp.h"
+#include "../include/despot/solver/pomcp.h"
 #include "nxnGrid.h"
 #include "Coordinate.h"
 
@@ -20,23 +23,16 @@ static const int s_lutSecondSquare[s_numPixelsSecondSquare][2] = { { 0, 2 }, { 0
 																{ -1, 2 }, { -1, -2 }, { 2, -1 }, { -2, -1 },															
 																{ 2, 2 }, { 2, -2 }, { -2, 2 }, { -2, -2 } };
 
-
-// init static members
-
-int nxnGridState::s_sizeState = 1;
-int nxnGridState::s_numEnemies = 1;
-
-int nxnGridState::s_gridSize = 0;
-int nxnGridState::s_targetLoc = 0;
-
-std::vector<int> nxnGridState::s_shelters;
+/// x, y change for each step toward code ((xChange + 1) + 3 * (yChange + 1))
+static const int s_stepTowardChange[9][2] = { { -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 }, { 0, 0 }, { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+static const int STEP_TOWARD_CHANGE_MASK = 0xF;
+/// flag for step toward when the single axis y move is preffered over x move
+static const int STEP_TOWARD_Y_FIRST = 0x10;
+/// terminator of directions list in steps from
+static const unsigned int NO_DIRECTION = 0xF;
 
 
-int nxnGrid::s_numBasicActions = -1;
-int nxnGrid::s_numEnemyRelatedActions = -1;
-
-std::vector<nxnGrid::intVec> nxnGrid::s_objectsInitLocations;
-UDP_Server nxnGrid::s_udpServer;
+// init static members
 
 const double nxnGrid::REWARD_WIN = 50.0;
 const double nxnGrid::REWARD_LOSS = -100.0;
@@ -44,12 +40,6 @@ const double nxnGrid::REWARD_KILL_ENEMY = 0.0;
 const double nxnGrid::REWARD_KILL_NINV = REWARD_LOSS;
 const double nxnGrid::REWARD_ILLEGAL_MOVE = 0;
 
-// for lut
-nxnGrid::lut_t nxnGrid::s_LUT;
-int nxnGrid::s_lutGridSize;
-enum nxnGrid::MODEL_TYPE nxnGrid::s_modelType = nxnGrid::ONLINE;
-enum nxnGrid::CALCULATION_TYPE nxnGrid::s_calculationType = nxnGrid::WITHOUT;
-
 // for synchronizing between sarsop rewards to despot rewards
 static double REWARD_WIN_MAP = 1.0; 
 static double REWARD_LOSS_MAP = -2.0;
@@ -85,30 +75,55 @@ inline int Distance(int a, int b, int gridSize)
 	return xDiff * xDiff + yDiff * yDiff;
 }
 
+/// return direction (idx in s_lutDirections) of random object move given random number (0-1)
+inline int ObjMoveDirection(double random)
+{
+	if (random > 0.5)
+	{
+		random = (random - 0.5) * 2;
+		if (random > 0.5)
+			return random > 0.75 ? 4 : 5;
+		else
+			return random > 0.25 ? 6 : 7;
+	}
+	
+	random *= 2;
+	if (random > 0.5)
+		return random > 0.75 ? 0 : 1;
+	else
+		return random > 0.25 ? 2 : 3;
+}
+
 
 /* =============================================================================
 * nxnGridState Functions
 * =============================================================================*/
 
-nxnGridState::nxnGridState(STATE_TYPE state_id, double weight)
+nxnGridState::nxnGridState(STATE_TYPE state_id, double weight, const nxnGridContext * context)
 	: State(state_id, weight)
+	, m_context(context)
 {
 }
 
 std::string nxnGridState::text() const
+{
+	return text(intVec(), -1);
+}
+
+std::string nxnGridState::text(const intVec & shelters, int targetLoc) const
 {
 	intVec state;
-	IdxToState(state_id, state);
+	m_context->IdxToState(state_id, state);
 	std::string ret = "(";
 	for (auto v : state)
 		ret += std::to_string(v) + ", ";
 	ret += ")\n";
-	for (int y = 0; y < s_gridSize; ++y)
+	for (int y = 0; y < m_context->m_gridSize; ++y)
 	{
-		for (int x = 0; x < s_gridSize; ++x)
+		for (int x = 0; x < m_context->m_gridSize; ++x)
 		{
-			int loc = x + y * s_gridSize;
-			ret += ObjIdentity(state, loc);
+			int loc = x + y * m_context->m_gridSize;
+			ret += m_context->ObjIdentity(state, loc, shelters, targetLoc);
 		}
 		ret += "\n";
 	}
@@ -123,35 +138,14 @@ void nxnGridState::UpdateState(STATE_TYPE newStateIdx)
 
 void nxnGridState::UpdateState(intVec newState)
 {
-	state_id = StateToIdx(newState);
+	state_id = m_context->StateToIdx(newState);
 }
 
 void nxnGridState::InitStatic()
 {
-	s_sizeState = 1;
-	s_numEnemies = 0;
-	s_gridSize = 0;
-	s_shelters.resize(0);
-}
-void nxnGridState::IdxToState(STATE_TYPE idx, intVec & stateVec)
-{
-	stateVec.resize(s_sizeState);
-	int numStates = s_gridSize * s_gridSize + 1;
-
-	// running on all varied objects and concluding from the obs num the observed state
-	for (int i = s_sizeState - 1; i >= 0; --i)
-	{
-		stateVec[i] = idx % numStates;
-		idx /= numStates;
-	}
-}
-
-STATE_TYPE nxnGridState::StateToIdx(const intVec &state)
-{
-	return StateToIdx(state, s_gridSize);
 }
 
-STATE_TYPE nxnGridState::StateToIdx(const intVec &state, int gridSize)
+STATE_TYPE nxnGridState::StateToLUTIdx(const intVec &state, int gridSize)
 {
 	STATE_TYPE idx = 0;
 	// add 1 for num states for dead objects
@@ -166,21 +160,55 @@ STATE_TYPE nxnGridState::StateToIdx(const intVec &state, int gridSize)
 	return idx;
 }
 
-STATE_TYPE nxnGridState::MaxState()
+/* =============================================================================
+* nxnGridContext Functions
+* =============================================================================*/
+
+void nxnGridContext::InitPacking(int gridSize)
 {
-	int numStates = s_gridSize * s_gridSize + 1;
+	// each field should hold locations 0 - gridSize^2 (gridSize^2 = dead)
+	m_bitsPerObj = 1;
+	while ((1 << m_bitsPerObj) <= gridSize * gridSize)
+		++m_bitsPerObj;
 
-	return pow(numStates, s_sizeState);
+	m_objMask = (static_cast<STATE_TYPE>(1) << m_bitsPerObj) - 1;
 }
 
-char nxnGridState::ObjIdentity(intVec & state, int location)
+void nxnGridContext::IdxToState(STATE_TYPE idx, intVec & stateVec) const
+{
+	stateVec.resize(m_sizeState);
+
+	// running on all objects from the last (lsb field) to the first
+	for (int i = m_sizeState - 1; i >= 0; --i)
+	{
+		stateVec[i] = static_cast<int>(idx & m_objMask);
+		idx >>= m_bitsPerObj;
+	}
+}
+
+STATE_TYPE nxnGridContext::StateToIdx(const intVec &state) const
+{
+	STATE_TYPE idx = 0;
+	// idx = s[0] << bits * n | s[1] << bits * (n - 1) ... | s[n]
+	for (int i = 0; i < state.size(); ++i)
+		idx = (idx << m_bitsPerObj) | state[i];
+
+	return idx;
+}
+
+STATE_TYPE nxnGridContext::MaxState() const
+{
+	return static_cast<STATE_TYPE>(1) << (m_bitsPerObj * m_sizeState);
+}
+
+char nxnGridContext::ObjIdentity(const intVec & state, int location, const intVec & shelters, int targetLoc) const
 {
 	if (state[0] == location)
 		return 'M';
 
 	int o = 1;
 	
-	for (; o < s_numEnemies + 1; ++o)
+	for (; o < m_numEnemies + 1; ++o)
 	{
 		if (state[o] == location)
 			return o + '0';
@@ -193,64 +221,165 @@ char nxnGridState::ObjIdentity(intVec & state, int location)
 	}
 
 	int s = 0;
-	for (; s < s_shelters.size(); ++s)
+	for (; s < shelters.size(); ++s)
 	{
-		if (location == s_shelters[s])
+		if (location == shelters[s])
 			return 'S';
 	}
 
-	if (location == s_targetLoc)
+	if (location == targetLoc)
 		return 'T';
 
 	return '_';
 }
 
+/* =============================================================================
+* nxnGridStateView Functions
+* =============================================================================*/
+
+nxnGridStateView::nxnGridStateView(const intVec & state, const nxnGridContext & context)
+	: m_size(state.size())
+	, m_bitsPerObj(context.m_bitsPerObj)
+{
+	for (int i = 0; i < m_size; ++i)
+		m_locations[i] = state[i];
+}
+
+void nxnGridStateView::ToVec(intVec & state) const
+{
+	state.assign(begin(), end());
+}
+
 /* =============================================================================
 * nxnGrid Functions
 * =============================================================================*/
 
-nxnGrid::nxnGrid(int gridSize, int target, Self_Obj & self, std::vector<intVec> & objectsInitLoc)
+nxnGrid::Settings::Settings()
+	: m_LUTs{ { std::make_shared<const OfflineLUT>(), 0 } }
+	, m_modelType(ONLINE)
+	, m_calculationType(WITHOUT)
+	, m_udpServer()
+{
+}
+
+nxnGrid::nxnGrid(int gridSize, int target, Self_Obj & self, std::vector<intVec> & objectsInitLoc, const Settings & settings)
 	: m_gridSize(gridSize)
 	, m_targetIdx(target)
 	, m_self(self)
 	, m_enemyVec()
 	, m_shelters()
 	, m_nonInvolvedVec()
+	, m_sheltersLocations()
+	, m_context()
 {
+	std::shared_ptr<nxnGridContext> context = std::make_shared<nxnGridContext>();
 	// init size  of state for nxnGridstate
-	nxnGridState::s_sizeState = 1;
-	nxnGridState::s_gridSize = gridSize;
-	nxnGridState::s_targetLoc = target;
+	context->m_sizeState = 1;
+	context->m_gridSize = gridSize;
+	context->InitPacking(gridSize);
+	context->m_objectsInitLocations = objectsInitLoc;
+
+	context->m_LUTs = settings.m_LUTs;
+	OrganizeLUTLevels(context->m_LUTs);
+	context->m_modelType = settings.m_modelType;
+	context->m_calculationType = settings.m_calculationType;
+	context->m_udpServer = settings.m_udpServer;
 
-	s_objectsInitLocations = objectsInitLoc;
+	// observation probabilities, attack lines and moves are calculated once for the grid (the tables are owned by the model 
+	// so the observation and attack objects can be shared with models of other grid sizes)
+	context->m_observationTable = m_self.GetObservation()->CreateProbTable(gridSize);
+	context->m_selfAttackTable = m_self.GetAttack()->CreateAttackTable(gridSize);
+	m_context = context;
+
+	InitMoveTables();
+	InitLUTScaleTables();
+}
+
+nxnGrid::MODEL_TYPE nxnGrid::GetModelType() const
+{
+	return m_context->m_modelType;
 }
 
-bool nxnGrid::InitUDP(int portNum)
+std::shared_ptr<UDP_Server> nxnGrid::InitUDP(int portNum)
 {
-	bool stat;
+	std::shared_ptr<UDP_Server> udpServer = std::make_shared<UDP_Server>();
 	if (portNum < 0)
-		stat = s_udpServer.Init();
+		udpServer->Init();
 	else
-		stat = s_udpServer.Init(portNum);
+		udpServer->Init(portNum);
 
 	std::cout << "udp connection initialized\n";
 
-	return stat;
+	return udpServer;
 }
 
-void nxnGrid::InitLUT(lut_t & offlineLut, int offlineGridSize, MODEL_TYPE mType,CALCULATION_TYPE ctype)
+void nxnGrid::OrganizeLUTLevels(std::vector<LUTLevel> & levels)
 {
-	s_modelType = mType;
-	s_calculationType = ctype;
-	s_lutGridSize = offlineGridSize;
-	s_LUT = offlineLut;
+	if (levels.empty())
+	{
+		std::cerr << "lut pyramid must contain at least one level\n";
+		exit(1);
+	}
+
+	for (const LUTLevel & level : levels)
+	{
+		if (level.m_LUT->NumActions() != levels[0].m_LUT->NumActions())
+		{
+			std::cerr << "all lut pyramid levels must have the same num of actions\n";
+			exit(1);
+		}
+	}
+
+	// finest level first
+	std::stable_sort(levels.begin(), levels.end(), [](const LUTLevel & a, const LUTLevel & b) { return a.m_gridSize > b.m_gridSize; });
+}
+
+void nxnGrid::InitLUTScaleTables()
+{
+	m_lutScaleTables.resize(m_context->m_LUTs.size());
+	for (size_t l = 0; l < m_context->m_LUTs.size(); ++l)
+	{
+		// grid size of empty lut (model without lut) is 0 and its table is left empty
+		if (m_context->m_LUTs[l].m_gridSize > 0)
+			InitScaleTable(m_lutScaleTables[l], m_context->m_LUTs[l].m_gridSize, m_gridSize);
+		else
+			m_lutScaleTables[l].clear();
+	}
+}
+
+bool nxnGrid::FindLUTValues(const intVec & state, double * values) const
+{
+	const std::vector<LUTLevel> & levels = m_context->m_LUTs;
+	int coarsest = levels.size() - 1;
+	intVec scaledState(state.size());
+
+	// finer levels are used only when the state scales to them without fix-up
+	for (int l = 0; l < coarsest; ++l)
+	{
+		const intVec & scaleTable = m_lutScaleTables[l];
+		for (size_t i = 0; i < state.size(); ++i)
+			scaledState[i] = scaleTable[state[i]];
+
+		if (!ScaleCollision(scaledState, levels[l].m_gridSize) && levels[l].m_LUT->Find(nxnGridState::StateToLUTIdx(scaledState, levels[l].m_gridSize), values))
+			return true;
+	}
+
+	if (m_lutScaleTables[coarsest].empty())
+		return false;
+
+	ScaleState(state, scaledState, m_lutScaleTables[coarsest], levels[coarsest].m_gridSize);
+	return levels[coarsest].m_LUT->Find(nxnGridState::StateToLUTIdx(scaledState, levels[coarsest].m_gridSize), values);
 }
 
 void nxnGrid::AddObj(Attack_Obj&& obj)
 {
 	m_enemyVec.emplace_back(std::forward<Attack_Obj>(obj));
-	nxnGridState::s_sizeState = 1 + m_enemyVec.size() + m_nonInvolvedVec.size();
-	nxnGridState::s_numEnemies = m_enemyVec.size();
+
+	std::shared_ptr<nxnGridContext> context = CopyContext();
+	context->m_enemyAttackTables.emplace_back(m_enemyVec.back().GetAttack()->CreateAttackTable(m_gridSize));
+	context->m_numEnemies = m_enemyVec.size();
+	UpdateStateSize(*context);
+	m_context = context;
 
 	AddActionsToEnemy();
 }
@@ -258,13 +387,39 @@ void nxnGrid::AddObj(Attack_Obj&& obj)
 void nxnGrid::AddObj(Movable_Obj&& obj)
 {
 	m_nonInvolvedVec.emplace_back(std::forward<Movable_Obj>(obj));
-	nxnGridState::s_sizeState = 1 + m_enemyVec.size() + m_nonInvolvedVec.size();
+
+	std::shared_ptr<nxnGridContext> context = CopyContext();
+	UpdateStateSize(*context);
+	m_context = context;
+}
+
+std::shared_ptr<nxnGridContext> nxnGrid::CopyContext() const
+{
+	if (memory_pool_.num_allocated() > 0)
+	{
+		std::cerr << "nxnGrid: objects must be added before states are allocated (" << memory_pool_.num_allocated() << " states in use)\n";
+		exit(1);
+	}
+
+	return std::make_shared<nxnGridContext>(*m_context);
+}
+
+void nxnGrid::UpdateStateSize(nxnGridContext & context) const
+{
+	context.m_sizeState = CountMovingObjects();
+
+	// the state and the observation are packed to 1 word (the sign bit is not in use)
+	if (context.m_sizeState > nxnGridStateView::MAX_OBJECTS || context.m_sizeState * context.m_bitsPerObj > 63)
+	{
+		std::cerr << "nxnGrid: too many objects (" << context.m_sizeState << ") to pack state of grid size " << m_gridSize << "\n";
+		exit(1);
+	}
 }
 
 void nxnGrid::AddObj(ObjInGrid&& obj)
 {
 	m_shelters.emplace_back(std::forward<ObjInGrid>(obj));
-	nxnGridState::s_shelters.emplace_back(obj.GetLocation().GetIdx(m_gridSize));
+	m_sheltersLocations.emplace_back(m_shelters.back().GetLocation().GetIdx(m_gridSize));
 	
 	AddActionsToShelter();
 }
@@ -273,76 +428,66 @@ void nxnGrid::AddObj(ObjInGrid&& obj)
 
 int nxnGrid::GetObsLoc(OBS_TYPE obs, int objIdx) const
 {
-	intVec obsState;
-	nxnGridState::IdxToState(obs, obsState);
+	nxnGridStateView obsState(obs, *m_context);
 
 	return obsState[objIdx];
 }
 
 double nxnGrid::ObsProb(OBS_TYPE obs, const State & s, int action) const
 {
-	intVec state;
-	nxnGridState::IdxToState(&s, state);
-
-	intVec obsState;
-	nxnGridState::IdxToState(obs, obsState);
+	nxnGridStateView state(s.state_id, *m_context);
+	nxnGridStateView obsState(obs, *m_context);
 
 	// if observation is not including the location of the robot return 0
 	if (state[0] != obsState[0])
 		return 0.0;
 
-	double pObs = 1.0;
-	// run on all non-self objects location
-	for (int i = 1; i < CountMovingObjects(); ++i)
+	// probability of all non-self objects location (the probability of non-observable location is 0)
+	return m_self.GetObservation()->GetProbObservationState(state.begin(), obsState.begin(), state.size(), m_gridSize, m_context->m_observationTable.get());
+}
+
+void nxnGrid::ObsProbBatch(OBS_TYPE obs, const std::vector<State*>& particles, int action, doubleVec & probs) const
+{
+	static const int CHUNK_SIZE = 64;
+	probs.resize(particles.size());
+
+	// the observation is unpacked once for all particles
+	nxnGridStateView obsState(obs, *m_context);
+	const Observation * observation = m_self.GetObservation();
+	const ObservationTable * table = m_context->m_observationTable.get();
+
+	nxnGridStateView chunk[CHUNK_SIZE];
+	for (int start = 0; start < particles.size(); start += CHUNK_SIZE)
 	{
-		// create possible observation of obj location
-		intVec observableLocations;
-		m_self.GetObservation()->InitObsAvailableLocations(state[0], state[i], state, m_gridSize, observableLocations);
+		int end = Min(start + CHUNK_SIZE, particles.size());
 		
-		// run on possible observable location
-		bool isObserved = false;
-		for (auto obsLoc : observableLocations)
+		// unpack chunk of particles
+		for (int i = start; i < end; ++i)
+			chunk[i - start].Unpack(particles[i]->state_id, *m_context);
+
+		// if observation is not including the location of the robot probability is 0
+		for (int i = start; i < end; ++i)
 		{
-			if (obsLoc == obsState[i])
-			{
-				pObs *= m_self.GetObservation()->GetProbObservation(state[0], state[i], m_gridSize, obsLoc);
-				isObserved = true;
-			}
+			const nxnGridStateView & state = chunk[i - start];
+			probs[i] = state[0] != obsState[0] ? 0.0 : observation->GetProbObservationState(state.begin(), obsState.begin(), state.size(), m_gridSize, table);
 		}
-		
-		// if the object is not in observable locations return 0
-		if (!isObserved)
-			return 0.0;
 	}
-	
-	return pObs;
 }
 
-double nxnGrid::ObsProbOneObj(OBS_TYPE obs, const State & s, int action, int objIdx) const
+OBS_TYPE nxnGrid::TransitionObs(int action, OBS_TYPE lastObs) const
 {
-	intVec state;
-	nxnGridState::IdxToState(&s, state);
+	return EnemyRelatedAction(action) ? lastObs : 0;
+}
 
-	intVec obsState;
-	nxnGridState::IdxToState(obs, obsState);
+double nxnGrid::ObsProbOneObj(OBS_TYPE obs, const State & s, int action, int objIdx) const
+{
+	nxnGridStateView state(s.state_id, *m_context);
+	nxnGridStateView obsState(obs, *m_context);
 
 	if (objIdx == 0)
 		return state[0] == obsState[0];
 
-	double pObs = 0.0;
-
-	// create possible observation of obj location
-	intVec observableLocations;
-	m_self.GetObservation()->InitObsAvailableLocations(state[0], state[objIdx], state, m_gridSize, observableLocations);
-
-	// run on possible observable location
-	for (auto obsLoc : observableLocations)
-	{
-		if (obsLoc == obsState[objIdx])
-			return m_self.GetObservation()->GetProbObservation(state[0], state[objIdx], m_gridSize, obsLoc);
-	}
-
-	return 0.0;
+	return m_self.GetObservation()->GetProbObservation(state[0], state[objIdx], m_gridSize, obsState[objIdx], m_context->m_observationTable.get());
 }
 
 void nxnGrid::CreateParticleVec(std::vector<std::vector<std::pair<int, double> > > & objLocations, std::vector<State*> & particles) const
@@ -353,19 +498,16 @@ void nxnGrid::CreateParticleVec(std::vector<std::vector<std::pair<int, double> >
 
 void nxnGrid::ChoosePreferredActionIMP(intVec & beliefState, doubleVec & expectedReward) const
 {
-	lut_t::iterator itr, itr2;
-	intVec scaledState;
+	int numLutActions = m_context->m_LUTs[0].m_LUT->NumActions();
+	doubleVec rewards, rewards2;
+	bool isRewards, isRewards2;
 	intVec modifiedBeliefState;
 
-	switch (s_calculationType)
+	switch (m_context->m_calculationType)
 	{
 	case ALL:
-		scaledState.resize(beliefState.size());
-		ScaleState(beliefState, scaledState);
-		itr = s_LUT.find(nxnGridState::StateToIdx(scaledState, s_lutGridSize));
-		if (itr != s_LUT.end())
-			expectedReward = itr->second;
-		else
+		expectedReward.resize(numLutActions);
+		if (!FindLUTValues(beliefState, expectedReward.data()))
 			expectedReward = doubleVec(NumActions(), REWARD_LOSS);
 		break;
 
@@ -374,12 +516,8 @@ void nxnGrid::ChoosePreferredActionIMP(intVec & beliefState, doubleVec & expecte
 		for (int i = 0; i < m_nonInvolvedVec.size(); ++i)
 			beliefState.erase(beliefState.begin() + 1 + m_enemyVec.size());
 
-		scaledState.resize(beliefState.size());
-		ScaleState(beliefState, scaledState);
-		itr = s_LUT.find(nxnGridState::StateToIdx(scaledState, s_lutGridSize));
-		if (itr != s_LUT.end())
-			expectedReward = itr->second;
-		else
+		expectedReward.resize(numLutActions);
+		if (!FindLUTValues(beliefState, expectedReward.data()))
 			expectedReward = doubleVec(NumActions(), REWARD_LOSS);
 		break;
 
@@ -391,12 +529,8 @@ void nxnGrid::ChoosePreferredActionIMP(intVec & beliefState, doubleVec & expecte
 		for (int i = 0; i < m_shelters.size(); ++i)
 			beliefState.erase(beliefState.begin() + 1 + m_enemyVec.size());
 
-		scaledState.resize(beliefState.size());
-		ScaleState(beliefState, scaledState);
-		itr = s_LUT.find(nxnGridState::StateToIdx(scaledState, s_lutGridSize));
-		if (itr != s_LUT.end())
-			expectedReward = itr->second;
-		else
+		expectedReward.resize(numLutActions);
+		if (!FindLUTValues(beliefState, expectedReward.data()))
 			expectedReward = doubleVec(NumActions(), REWARD_LOSS);
 		break;
 
@@ -405,38 +539,33 @@ void nxnGrid::ChoosePreferredActionIMP(intVec & beliefState, doubleVec & expecte
 		for (int i = 0; i < m_nonInvolvedVec.size(); ++i)
 			beliefState.erase(beliefState.begin() + 1 + m_enemyVec.size());
 
+		rewards.resize(numLutActions);
+		rewards2.resize(numLutActions);
+
 		// calculate reward with first enemy
 		modifiedBeliefState = beliefState;
 		modifiedBeliefState.erase(modifiedBeliefState.begin() + 1 + 1);
 
-		scaledState.resize(modifiedBeliefState.size());
-		ScaleState(modifiedBeliefState, scaledState);
-		itr = s_LUT.find(nxnGridState::StateToIdx(scaledState, s_lutGridSize));
+		isRewards = FindLUTValues(modifiedBeliefState, rewards.data());
 
 		// calculate reward with second enemy
 		modifiedBeliefState = beliefState;
 		modifiedBeliefState.erase(modifiedBeliefState.begin() + 1);
 
-		scaledState.resize(modifiedBeliefState.size());
-		ScaleState(modifiedBeliefState, scaledState);
-		itr2 = s_LUT.find(nxnGridState::StateToIdx(scaledState, s_lutGridSize));
+		isRewards2 = FindLUTValues(modifiedBeliefState, rewards2.data());
 
-		if (itr != s_LUT.end() & itr2 != s_LUT.end())
-			Combine2EnemiesRewards(beliefState, itr->second, itr2->second, expectedReward);
+		if (isRewards & isRewards2)
+			Combine2EnemiesRewards(beliefState, rewards.data(), rewards2.data(), expectedReward);
 		else
 			expectedReward = doubleVec(NumActions(), REWARD_LOSS);
 		break;
 	
 	case WO_NINV_STUPID:
 		beliefState.erase(beliefState.begin() + 1 + m_enemyVec.size());
-		scaledState.resize(beliefState.size());
-		ScaleState(beliefState, scaledState);
-		itr = s_LUT.find(nxnGridState::StateToIdx(scaledState, s_lutGridSize));
+		expectedReward.resize(numLutActions);
 		
 		// TODO : move members 1 slot right
-		if (itr != s_LUT.end())
-			expectedReward = itr->second;
-		else
+		if (!FindLUTValues(beliefState, expectedReward.data()))
 			expectedReward = doubleVec(NumActions(), REWARD_LOSS);
 		break;
 	default: // calc type = WITHOUT
@@ -467,7 +596,7 @@ void nxnGrid::CreateParticleVecRec(intVec & state, std::vector<std::vector<std::
 {
 	if (currIdx == state.size())
 	{
-		auto beliefState = static_cast<nxnGridState*>(Allocate(nxnGridState::StateToIdx(state), weight));
+		auto beliefState = static_cast<nxnGridState*>(Allocate(m_context->StateToIdx(state), weight));
 		particles.push_back(beliefState);
 	}
 	else
@@ -493,7 +622,7 @@ State * nxnGrid::CreateStartState(std::string type) const
 		state[i + 1 + m_enemyVec.size()] = m_nonInvolvedVec[i].GetLocation().GetIdx(m_gridSize);
 
 
-	return new nxnGridState(nxnGridState::StateToIdx(state));
+	return new nxnGridState(m_context->StateToIdx(state), 0.0, m_context.get());
 }
 
 Belief * nxnGrid::InitialBelief(const State * start, std::string type) const
@@ -506,7 +635,7 @@ Belief * nxnGrid::InitialBelief(const State * start, std::string type) const
 	int numStates = 1;
 	// assumption : init states cannot be in same locations for different object
 	for (int i = 1; i < CountMovingObjects(); ++i)
-		numStates *= s_objectsInitLocations[i].size();
+		numStates *= m_context->m_objectsInitLocations[i].size();
 
 	double stateProb = 1.0 / numStates;
 	
@@ -520,6 +649,7 @@ State * nxnGrid::Allocate(STATE_TYPE state_id, double weight) const
 	nxnGridState* particle = memory_pool_.Allocate();
 	particle->state_id = state_id;
 	particle->weight = weight;
+	particle->m_context = m_context.get();
 	return particle;
 }
 
@@ -544,7 +674,7 @@ int nxnGrid::NumActiveParticles() const
 void nxnGrid::PrintState(const State & s, std::ostream & out) const
 {
 	const nxnGridState& state = static_cast<const nxnGridState&>(s);
-	out << state.text() << "\n";
+	out << state.text(m_sheltersLocations, m_targetIdx) << "\n";
 }
 
 void nxnGrid::PrintBelief(const Belief & belief, std::ostream & out) const
@@ -553,8 +683,8 @@ void nxnGrid::PrintBelief(const Belief & belief, std::ostream & out) const
 
 void nxnGrid::PrintObs(const State & state, OBS_TYPE obs, std::ostream & out) const
 {
-	nxnGridState obsState(obs);
-	out << obsState.text() << "\n";
+	nxnGridState obsState(obs, 0.0, m_context.get());
+	out << obsState.text(m_sheltersLocations, m_targetIdx) << "\n";
 }
 
 bool nxnGrid::InRange(int locationSelf, int locationObj, double range, int gridSize)
@@ -566,16 +696,13 @@ bool nxnGrid::InRange(int locationSelf, int locationObj, double range, int gridS
 	return self.RealDistance(enemy) <= range;
 }
 
-bool nxnGrid::CalcIfDead(int enemyIdx, intVec state, double & randomNum) const
+bool nxnGrid::CalcIfDead(int enemyIdx, const nxnGridStateView & state, double & randomNum) const
 {
-	intVec shelters(m_shelters.size());
+	// only self death is relevant so the attack is calculated on a copy of the state
+	nxnGridStateView attackedState(state);
+	m_enemyVec[enemyIdx].GetAttack()->AttackOnline(state[enemyIdx + 1], state[0], attackedState.data(), attackedState.size(), m_sheltersLocations, m_gridSize, randomNum, m_context->m_enemyAttackTables[enemyIdx].get());
 
-	for (size_t i = 0; i < shelters.size(); ++i)
-		shelters[i] = m_shelters[i].GetLocation().GetIdx(m_gridSize);
-	
-	m_enemyVec[enemyIdx].AttackOnline(state[enemyIdx + 1], state[0], state, shelters, m_gridSize, randomNum);
-
-	return state[0] == m_gridSize * m_gridSize;
+	return attackedState[0] == m_gridSize * m_gridSize;
 }
 
 void nxnGrid::MoveNonProtectedShelters(const intVec & beliefState, intVec & scaledState, int newGridSize) const
@@ -690,7 +817,7 @@ void nxnGrid::DropUnProtectedShelter(intVec & state, int gridSize) const
 int nxnGrid::NumEnemiesInCalc() const
 {
 	// TODO : make this function more modular
-	return m_enemyVec.size() * (s_calculationType == WO_NINV) + 1 * (s_calculationType == ONE_ENEMY);
+	return m_enemyVec.size() * (m_context->m_calculationType == WO_NINV) + 1 * (m_context->m_calculationType == ONE_ENEMY);
 }
 
 int nxnGrid::NumNonInvInCalc() const 
@@ -721,30 +848,29 @@ void nxnGrid::InitialBeliefStateRec(intVec & state, int currObj, double statePro
 {
 	if (currObj == CountMovingObjects())
 	{
-		auto beliefState = static_cast<nxnGridState*>(Allocate(nxnGridState::StateToIdx(state), stateProb));
+		auto beliefState = static_cast<nxnGridState*>(Allocate(m_context->StateToIdx(state), stateProb));
 		particles.push_back(beliefState);
 	}
 	else
 	{
-		for (auto obj : s_objectsInitLocations[currObj])
+		for (auto obj : m_context->m_objectsInitLocations[currObj])
 		{
 			state[currObj] = obj;
 			InitialBeliefStateRec(state, currObj + 1, stateProb, particles);
 		}
 	}
 }
-OBS_TYPE nxnGrid::FindObservation(intVec & state, double p) const
+OBS_TYPE nxnGrid::FindObservation(const nxnGridStateView & state, double p) const
 {
-	intVec obsState(CountMovingObjects());
-	obsState[0] = state[0];
+	nxnGridStateView obsState(state);
 	// calculate observed state
 	DecreasePObsRec(obsState, state, 1, 1.0, p);
 
 	// return the observed state
-	return nxnGridState::StateToIdx(obsState);
+	return obsState.Pack();
 }
 
-void nxnGrid::SetNextPosition(intVec & state, doubleVec & randomNum) const
+void nxnGrid::SetNextPosition(nxnGridStateView & state, const double * randomNum) const
 {
 	// run on all enemies
 	for (int i = 0; i < m_enemyVec.size(); ++i)
@@ -762,7 +888,7 @@ void nxnGrid::SetNextPosition(intVec & state, doubleVec & randomNum) const
 	}
 }
 
-void nxnGrid::CalcMovement(intVec & state, const Movable_Obj *object, double rand, int objIdx) const
+void nxnGrid::CalcMovement(nxnGridStateView & state, const Movable_Obj *object, double rand, int objIdx) const
 {
 	// if the p that was pulled is in the pStay range do nothing
 	double pStay = object->GetMovement().GetStay();
@@ -781,17 +907,17 @@ void nxnGrid::CalcMovement(intVec & state, const Movable_Obj *object, double ran
 				return;
 		}
 
-		GetCloser(state, objIdx, m_gridSize);
+		GetCloser(state, objIdx);
 		return;
 	}
 	// else treat the probability left as the new whole and cmove according to probability
 	double pEqual = (rand - pToward) / (1 - pToward);
-	int newLoc = FindObjMove(state[objIdx], pEqual, m_gridSize);
+	int newLoc = FindObjMove(state[objIdx], pEqual);
 	if (ValidLocation(state, newLoc))
 		state[objIdx] = newLoc;
 }
 
-bool nxnGrid::ValidLocation(intVec & state, int location)
+bool nxnGrid::ValidLocation(const nxnGridStateView & state, int location)
 {
 	for (auto v : state)
 	{
@@ -804,7 +930,7 @@ bool nxnGrid::ValidLocation(intVec & state, int location)
 	return true;
 }
 
-bool nxnGrid::ValidLegalLocation(intVec & state, Coordinate location, int end, int gridSize)
+bool nxnGrid::ValidLegalLocation(const intVec & state, Coordinate location, int end, int gridSize)
 {
 	if ((location.X() >= gridSize) | (location.X() < 0) | (location.Y() >= gridSize) | (location.Y() < 0))
 		return false;
@@ -821,21 +947,39 @@ bool nxnGrid::ValidLegalLocation(intVec & state, Coordinate location, int end, i
 	return true;
 }
 
-void nxnGrid::ScaleState(const intVec & beliefState, intVec & scaledState) const
+bool nxnGrid::ValidLegalLocation(const nxnGridStateView & state, Coordinate location, int end, int gridSize)
 {
-	ScaleState(beliefState, scaledState, s_lutGridSize, m_gridSize);
+	if ((location.X() >= gridSize) | (location.X() < 0) | (location.Y() >= gridSize) | (location.Y() < 0))
+		return false;
+
+	int locationIdx = location.X() + location.Y() * gridSize;
+	for (int i = 0; i < end; ++i)
+	{
+		if (locationIdx == state[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
 void nxnGrid::ScaleState(const intVec & beliefState, intVec & scaledState, int newGridSize, int prevGridSize) const
 {
-	double scale = static_cast<double>(prevGridSize) / newGridSize;
+	// table for grid sizes other than the lut levels (e.g. vbs state) is built once per call and covers all locations in the state
+	intVec scaleTable;
+	InitScaleTable(scaleTable, newGridSize, prevGridSize, *std::max_element(beliefState.begin(), beliefState.end()));
+	ScaleState(beliefState, scaledState, scaleTable, newGridSize);
+}
 
+void nxnGrid::ScaleState(const intVec & beliefState, intVec & scaledState, const intVec & scaleTable, int newGridSize) const
+{
 	for (size_t i = 0; i < beliefState.size(); ++i)
-	{
-		Coordinate location(beliefState[i] % prevGridSize, beliefState[i] / prevGridSize);
-		location /= scale;
-		scaledState[i] = location.X() + location.Y() * newGridSize;
-	}
+		scaledState[i] = scaleTable[beliefState[i]];
+
+	// fix-ups below change the scaled state only when objects collide or self is on target
+	if (!ScaleCollision(scaledState, newGridSize))
+		return;
 
 	// if target is in self location shift map to the left or upper so self won't be in target location 
 	if (scaledState[0] == newGridSize * newGridSize - 1)
@@ -861,7 +1005,39 @@ void nxnGrid::ScaleState(const intVec & beliefState, intVec & scaledState, int n
 	MoveNonProtectedShelters(beliefState, scaledState, newGridSize);
 }
 
-void nxnGrid::Combine2EnemiesRewards(const intVec & beliefState, const doubleVec & rewards1E, const doubleVec & rewards2E, doubleVec & rewards) const
+void nxnGrid::InitScaleTable(intVec & scaleTable, int newGridSize, int prevGridSize, int maxLocation)
+{
+	double scale = static_cast<double>(prevGridSize) / newGridSize;
+	int numLocations = std::max(prevGridSize * prevGridSize, maxLocation);
+
+	scaleTable.resize(numLocations + 1);
+	for (int loc = 0; loc <= numLocations; ++loc)
+	{
+		Coordinate location(loc % prevGridSize, loc / prevGridSize);
+		location /= scale;
+		scaleTable[loc] = location.X() + location.Y() * newGridSize;
+	}
+}
+
+bool nxnGrid::ScaleCollision(const intVec & scaledState, int newGridSize)
+{
+	int outOfGrid = newGridSize * newGridSize;
+	if (scaledState[0] == outOfGrid - 1)
+		return true;
+
+	for (size_t i = 1; i < scaledState.size(); ++i)
+	{
+		for (size_t j = 0; j < i; ++j)
+		{
+			if (scaledState[i] == scaledState[j] && scaledState[i] != outOfGrid)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+void nxnGrid::Combine2EnemiesRewards(const intVec & beliefState, const double * rewards1E, const double * rewards2E, doubleVec & rewards) const
 {
 	static int bitE1 = 1;
 	static int bitE2 = 2;
@@ -870,27 +1046,27 @@ void nxnGrid::Combine2EnemiesRewards(const intVec & beliefState, const doubleVec
 	rewards.resize(NumActions());
 	// insert first enemy related actions rewards (if dead insert reward loss)
 	if (beliefState[1] != m_gridSize * m_gridSize)
-		for (int a = s_numBasicActions; a < s_numBasicActions + s_numEnemyRelatedActions; ++a)
+		for (int a = m_numBasicActions; a < m_numBasicActions + m_numEnemyRelatedActions; ++a)
 			rewards[a] = rewards1E[a];
 	else
 	{
 		deadEnemies |= bitE1;
-		for (int a = s_numBasicActions; a < s_numBasicActions + s_numEnemyRelatedActions; ++a)
+		for (int a = m_numBasicActions; a < m_numBasicActions + m_numEnemyRelatedActions; ++a)
 			rewards[a] = REWARD_LOSS;
 	}
 	// insert second enemy related actions rewards (if dead insert reward loss)
 	if (beliefState[2] != m_gridSize * m_gridSize)
-		for (int a = s_numBasicActions; a < s_numBasicActions + s_numEnemyRelatedActions; ++a)
-			rewards[a + s_numEnemyRelatedActions] = rewards2E[a];
+		for (int a = m_numBasicActions; a < m_numBasicActions + m_numEnemyRelatedActions; ++a)
+			rewards[a + m_numEnemyRelatedActions] = rewards2E[a];
 	else
 	{
 		deadEnemies |= bitE2;
-		for (int a = s_numBasicActions; a < s_numBasicActions + s_numEnemyRelatedActions; ++a)
-			rewards[a + s_numEnemyRelatedActions] = REWARD_LOSS;
+		for (int a = m_numBasicActions; a < m_numBasicActions + m_numEnemyRelatedActions; ++a)
+			rewards[a + m_numEnemyRelatedActions] = REWARD_LOSS;
 	}
 
 	// for non enemy related action do average of rewards
-	for (int a = 0; a < s_numBasicActions; ++a)
+	for (int a = 0; a < m_numBasicActions; ++a)
 	{
 		// when only 1 enemy is dead insert to rewards calculation only reward of the live enemy
 		double rE1 = rewards1E[a] * (deadEnemies != bitE1) + rewards2E[a] * (deadEnemies == bitE1);
@@ -921,9 +1097,9 @@ const Move_Properties & nxnGrid::GetMovement(int objIdx)
 }
 
 
-void nxnGrid::DecreasePObsRec(intVec & currState, const intVec & originalState, int currIdx, double pToDecrease, double &pLeft) const
+void nxnGrid::DecreasePObsRec(nxnGridStateView & currState, const nxnGridStateView & originalState, int currIdx, double pToDecrease, double &pLeft) const
 {
-	if (currIdx == CountMovingObjects())
+	if (currIdx == originalState.size())
 	{
 		// decrease observed state probability from the left probability
 		pLeft -= pToDecrease;
@@ -932,47 +1108,55 @@ void nxnGrid::DecreasePObsRec(intVec & currState, const intVec & originalState,
 	{
 		int selfLoc = originalState[0];
 		int objLoc = originalState[currIdx];
-		intVec observableLocations;
-		m_self.GetObservation()->InitObsAvailableLocations(selfLoc, objLoc, originalState, m_gridSize, observableLocations);
+		int observableLocations[Observation::MAX_OBSERVABLE_LOCATIONS];
+		int numObservable = m_self.GetObservation()->InitObsAvailableLocations(selfLoc, objLoc, m_gridSize, observableLocations);
 		
-		for (int obs = 0; obs < observableLocations.size() & pLeft >= 0.0; ++obs)
+		for (int obs = 0; obs < numObservable & pLeft >= 0.0; ++obs)
 		{
 			currState[currIdx] = observableLocations[obs];
-			double pObs = m_self.GetObservation()->GetProbObservation(selfLoc, objLoc, m_gridSize, observableLocations[obs]);
+			double pObs = m_self.GetObservation()->GetProbObservation(selfLoc, objLoc, m_gridSize, observableLocations[obs], m_context->m_observationTable.get());
 			DecreasePObsRec(currState, originalState, currIdx + 1, pToDecrease * pObs, pLeft);
 		}
 	}
 }
 
-inline int nxnGrid::CountMovingObjects() const
+int nxnGrid::CountMovingObjects() const
 {
 	return 1 + m_enemyVec.size() + m_nonInvolvedVec.size();
 }
 
-void nxnGrid::CreateRandomVec(doubleVec & randomVec, int size)
+double nxnGrid::ScenarioRandom(double randomNum, int counter)
+{
+	// counter based generator (splitmix64 finalizer) keyed by the bits of the scenario random number
+	uint64_t key;
+	std::memcpy(&key, &randomNum, sizeof(key));
+	uint64_t x = key + (static_cast<uint64_t>(counter) + 1) * 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	x ^= x >> 31;
+
+	// use the 53 high bits as the mantissa of number between 0-1
+	return static_cast<double>(x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void nxnGrid::CreateRandomVec(double * randomVec, int size, double randomNum, int firstCounter)
 {
-	// insert to a vector numbers between 0-1
+	// insert to the array numbers between 0-1
 	for (int i = 0; i < size; ++i)
 	{
-		randomVec.emplace_back(Random::RANDOM.NextDouble());
+		randomVec[i] = ScenarioRandom(randomNum, firstCounter + i);
 	}
 }
 
-void nxnGrid::GetCloser(intVec & state, int objIdx, int gridSize) const
+void nxnGrid::GetCloser(nxnGridStateView & state, int objIdx) const
 {
-	int xSelf = state[0] % gridSize;
-	int ySelf = state[0] / gridSize;
-	int xObj = state[objIdx] % gridSize;
-	int yObj = state[objIdx] / gridSize;
-
 	int objLocation = state[objIdx];
 	int move = objLocation;
 
-	int xDiff = xSelf - xObj;
-	int yDiff = ySelf - yObj;
-
-	int changeToInsertX = xDiff != 0 ? xDiff / Abs(xDiff) : 0;
-	int changeToInsertY = yDiff != 0 ? (yDiff / Abs(yDiff)) * m_gridSize : 0;
+	// step of object toward self
+	int step = m_stepToward[objLocation * NumMoveGoals() + state[0]] & STEP_TOWARD_CHANGE_MASK;
+	int changeToInsertX = s_stepTowardChange[step][0];
+	int changeToInsertY = s_stepTowardChange[step][1] * m_gridSize;
 
 	// insert to move the best valid option
 	if (ValidLocation(state, move + changeToInsertX))
@@ -983,54 +1167,123 @@ void nxnGrid::GetCloser(intVec & state, int objIdx, int gridSize) const
 	state[objIdx] = move;
 }
 
-int nxnGrid::FindObjMove(int currLocation, double random, int gridSize) const
+int nxnGrid::FindObjMove(int currLocation, double random) const
 {
-	int x = currLocation % gridSize;
-	int y = currLocation / gridSize;
-	// change x and y according to random probability
-	if (random > 0.5)
+	// if the move is out of grid the object stays in place
+	int move = m_neighbors[currLocation * s_numMoves + ObjMoveDirection(random)];
+	return move >= 0 ? move : currLocation;
+}
+
+int nxnGrid::MoveToward(const nxnGridStateView & state, int location) const
+{
+	int selfLocation = state[0];
+	int step = m_stepToward[selfLocation * NumMoveGoals() + location];
+	int changeToInsertX = s_stepTowardChange[step & STEP_TOWARD_CHANGE_MASK][0];
+	int changeToInsertY = s_stepTowardChange[step & STEP_TOWARD_CHANGE_MASK][1] * m_gridSize;
+	// only steps toward location below the grid can leave the grid (from the last row)
+	int numLocations = m_gridSize * m_gridSize;
+
+	// if the best move is valid return it
+	int move = selfLocation + changeToInsertX + changeToInsertY;
+	if (move < numLocations && ValidLocation(state, move))
+		return move;
+
+	// if the best move is not availabe try the single axis moves by order of distance to location
+	int secondMove;
+	if (step & STEP_TOWARD_Y_FIRST)
 	{
-		random = (random - 0.5) * 2;
-		if (random > 0.5)
-		{
-			++x;
-			if (random > 0.75)
-				++y;
-			else
-				--y;
-		}
-		else
-		{
-			--x;
-			if (random > 0.25)
-				++y;
-			else
-				--y;
-		}
+		move = selfLocation + changeToInsertY;
+		secondMove = selfLocation + changeToInsertX;
 	}
 	else
 	{
-		random *= 2;
-		if (random > 0.5)
-		{
-			if (random > 0.75)
-				++y;
-			else
-				--y;
-		}
-		else
+		move = selfLocation + changeToInsertX;
+		secondMove = selfLocation + changeToInsertY;
+	}
+
+	// return the best valid move
+	if (move < numLocations && ValidLocation(state, move))
+		return move;
+	else if (secondMove < numLocations && ValidLocation(state, secondMove))
+		return secondMove;
+
+	// if any move wasn't succesful return self location as no move
+	return selfLocation;
+}
+
+int nxnGrid::MoveFrom(const nxnGridStateView & state, int location) const
+{
+	int selfLocation = state[0];
+
+	// run on moves ordered from the farthest and return the first valid move
+	unsigned int directions = m_stepsFrom[selfLocation * NumMoveGoals() + location];
+	for (int i = 0; i < s_numMoves && (directions & NO_DIRECTION) != NO_DIRECTION; ++i, directions >>= 4)
+	{
+		int move = m_neighbors[selfLocation * s_numMoves + (directions & NO_DIRECTION)];
+		if (ValidLocation(state, move))
+			return move;
+	}
+
+	return selfLocation;
+}
+
+void nxnGrid::InitMoveTables()
+{
+	int numLocations = m_gridSize * m_gridSize;
+	
+	m_neighbors.resize(numLocations * s_numMoves);
+	for (int loc = 0; loc < numLocations; ++loc)
+	{
+		for (int d = 0; d < s_numMoves; ++d)
 		{
-			if (random > 0.25)
-				++x;
-			else
-				--x;
+			int x = loc % m_gridSize + s_lutDirections[d][0];
+			int y = loc / m_gridSize + s_lutDirections[d][1];
+			bool inGrid = (x >= 0) & (x < m_gridSize) & (y >= 0) & (y < m_gridSize);
+			m_neighbors[loc * s_numMoves + d] = inGrid ? x + y * m_gridSize : -1;
 		}
 	}
 
-	if ((x >= 0) & (x < gridSize) & (y >= 0) & (y < gridSize))
-		return x + y * gridSize;
+	int numGoals = NumMoveGoals();
+	m_stepToward.resize(numLocations * numGoals);
+	m_stepsFrom.resize(numLocations * numGoals);
+	for (int loc = 0; loc < numLocations; ++loc)
+	{
+		Coordinate location(loc % m_gridSize, loc / m_gridSize);
+		// goals below the grid are the coordinates of idx >= gridSize^2 (the dead location is (0, gridSize))
+		for (int other = 0; other < numGoals; ++other)
+		{
+			Coordinate otherLocation(other % m_gridSize, other / m_gridSize);
+
+			// step toward other: change in each axis and order of single axis moves by distance to other
+			int xDiff = otherLocation.X() - location.X();
+			int yDiff = otherLocation.Y() - location.Y();
+			int changeX = xDiff != 0 ? xDiff / Abs(xDiff) : 0;
+			int changeY = yDiff != 0 ? yDiff / Abs(yDiff) : 0;
+			bool yFirst = Distance(other, loc + changeX, m_gridSize) > Distance(other, loc + changeY * m_gridSize, m_gridSize);
+			m_stepToward[loc * numGoals + other] = (changeX + 1) + 3 * (changeY + 1) + STEP_TOWARD_Y_FIRST * yFirst;
+
+			// steps from other: moves that are farther than current location ordered by distance (same distance by direction order)
+			std::vector<std::pair<int, int>> farther;
+			int dist = location.Distance(otherLocation);
+			for (int d = 0; d < s_numMoves; ++d)
+			{
+				int move = m_neighbors[loc * s_numMoves + d];
+				if (move < 0)
+					continue;
+
+				Coordinate moveLocation(move % m_gridSize, move / m_gridSize);
+				int moveDist = otherLocation.Distance(moveLocation);
+				if (moveDist > dist)
+					farther.emplace_back(-moveDist, d);
+			}
+			std::sort(farther.begin(), farther.end());
 
-	return currLocation;
+			unsigned int directions = ~0u;
+			for (int i = farther.size() - 1; i >= 0; --i)
+				directions = (directions << 4) | farther[i].second;
+			m_stepsFrom[loc * numGoals + other] = directions;
+		}
+	}
 }
 
 bool nxnGrid::InSquare(int location, int location2, int squareSize,int gridSize)
@@ -1049,7 +1302,7 @@ bool nxnGrid::InSquare(int location, int location2, int squareSize,int gridSize)
 
 void nxnGrid::SendAction(int action)
 {
-	s_udpServer.Write(reinterpret_cast<char *>(&action), sizeof(int));
+	m_context->m_udpServer->Write(reinterpret_cast<char *>(&action), sizeof(int));
 }
 
 bool nxnGrid::RcvState(State * s, int action, OBS_TYPE & obs, double & reward)
@@ -1064,8 +1317,8 @@ bool nxnGrid::RcvState(State * s, int action, OBS_TYPE & obs, double & reward)
 		return true;
 	}
 	
-	s->state_id = nxnGridState::StateToIdx(state);
-	obs = nxnGridState::StateToIdx(observation);
+	s->state_id = m_context->StateToIdx(state);
+	obs = m_context->StateToIdx(observation);
 
 	reward = 0.0;
 	if (state[0] == m_gridSize * m_gridSize)
@@ -1080,41 +1333,41 @@ bool nxnGrid::RcvState(State * s, int action, OBS_TYPE & obs, double & reward)
 
 void nxnGrid::InitState()
 {
-	if (s_modelType == VBS)
+	if (m_context->m_modelType == VBS)
 		InitStateVBS();
 	else
 		InitStateRandom();
 }
 
-/// init state according to s_objectsInitLocations
+/// init state according to the init locations of objects
 void nxnGrid::InitStateRandom()
 {
 	int obj = 0;
-	int idx = rand() % s_objectsInitLocations[obj].size();
-	int loc = s_objectsInitLocations[obj][idx];
+	int idx = rand() % m_context->m_objectsInitLocations[obj].size();
+	int loc = m_context->m_objectsInitLocations[obj][idx];
 	m_self.SetLocation(Coordinate(loc % m_gridSize, loc / m_gridSize));
 	++obj;
 
 	for (int i = 0; i < m_enemyVec.size(); ++i, ++obj)
 	{
-		idx = rand() % s_objectsInitLocations[obj].size();
-		loc = s_objectsInitLocations[obj][idx];
+		idx = rand() % m_context->m_objectsInitLocations[obj].size();
+		loc = m_context->m_objectsInitLocations[obj][idx];
 		m_enemyVec[i].SetLocation(Coordinate(loc % m_gridSize, loc / m_gridSize));
 	}
 	
 	for (int i = 0; i < m_nonInvolvedVec.size(); ++i, ++obj)
 	{
-		idx = rand() % s_objectsInitLocations[obj].size();
-		loc = s_objectsInitLocations[obj][idx];
+		idx = rand() % m_context->m_objectsInitLocations[obj].size();
+		loc = m_context->m_objectsInitLocations[obj][idx];
 		m_nonInvolvedVec[i].SetLocation(Coordinate(loc % m_gridSize, loc / m_gridSize));
 	}
 
 	for (int i = 0; i < m_shelters.size(); ++i, ++obj)
 	{
-		idx = rand() % s_objectsInitLocations[obj].size();
-		loc = s_objectsInitLocations[obj][idx];
+		idx = rand() % m_context->m_objectsInitLocations[obj].size();
+		loc = m_context->m_objectsInitLocations[obj][idx];
 		m_shelters[i].SetLocation(Coordinate(loc % m_gridSize, loc / m_gridSize));
-		nxnGridState::s_shelters[i] = loc;
+		m_sheltersLocations[i] = loc;
 	}
 
 }
@@ -1157,7 +1410,7 @@ void nxnGrid::InitStateVBS()
 void nxnGrid::InitStateIMP(intVec & state, intVec & observation)
 {
 	int buffer[40];
-	int length = s_udpServer.Read(reinterpret_cast<char *>(buffer));
+	int length = m_context->m_udpServer->Read(reinterpret_cast<char *>(buffer));
 
 	int vbsGridSize = buffer[0];
 
@@ -1201,7 +1454,6 @@ void nxnGrid::InitStateIMP(intVec & state, intVec & observation)
 	// read and scale target
 	int vbsTarget = FindObject(readState, identity, TARGET, 0);
 	m_targetIdx = vbsTarget * (((double)(m_gridSize)) / vbsGridSize);
-	nxnGridState::s_targetLoc = m_targetIdx;
 
 	intVec scaledState(organizedState.size());
 	ScaleState(organizedState, scaledState, m_gridSize, vbsGridSize);
@@ -1217,7 +1469,7 @@ void nxnGrid::InitStateIMP(intVec & state, intVec & observation)
 	//insert scaled shelters location
 	for (int i = 0; i < m_shelters.size(); ++i, ++obj)
 	{
-		nxnGridState::s_shelters[i] = scaledState[obj];
+		m_sheltersLocations[i] = scaledState[obj];
 		m_shelters[i].SetLocation(Coordinate(scaledState[obj] % m_gridSize, scaledState[obj] / m_gridSize));
 	}
 }
@@ -1256,28 +1508,34 @@ int nxnGrid::FindObject(intVec & state, intVec & identity, int object, int obser
 	return m_gridSize * m_gridSize;
 }
 
-void nxnGrid::ChoosePreferredAction(POMCPPrior * prior, const DSPOMDP* m, doubleVec & expectedRewards)
+const nxnGrid::doubleVec & nxnGrid::ChoosePreferredAction(POMCPPrior * prior, const DSPOMDP* m)
 {
 	const nxnGrid * model = static_cast<const nxnGrid *>(m);
-	if (prior->history().Size() > 0)
-	{
-		intVec beliefState;
-		model->InitBeliefState(beliefState, prior->history());
-		model->ChoosePreferredActionIMP(beliefState, expectedRewards);
-	}
-	else
+	/// rewards of the last preferred action query of this thread when the prior is not nxnGridPOMCPPrior
+	static thread_local doubleVec s_preferredRewards;
+	if (prior->history().Size() == 0)
 	{
-		expectedRewards = doubleVec(model->NumActions(), REWARD_LOSS);
+		s_preferredRewards.assign(model->NumActions(), REWARD_LOSS);
+		return s_preferredRewards;
 	}
+
+	// use tracked locations and memoized rewards when possible (history scan is linear in history length)
+	nxnGridPOMCPPrior * gridPrior = dynamic_cast<nxnGridPOMCPPrior *>(prior);
+	if (gridPrior != nullptr)
+		return gridPrior->PreferredRewards();
+
+	intVec beliefState;
+	model->InitBeliefState(beliefState, prior->history());
+	model->ChoosePreferredActionIMP(beliefState, s_preferredRewards);
+	return s_preferredRewards;
 }
 
 int nxnGrid::ChoosePreferredAction(POMCPPrior * prior, const DSPOMDP* m, double expectedReward)
 {	
-	doubleVec rewards;
-	ChoosePreferredAction(prior, m, rewards);
+	const nxnGrid * model = static_cast<const nxnGrid *>(m);
 	// if calc type != without return lut result else return random decision
-	if (s_calculationType != WITHOUT)
-		return FindMaxReward(rewards, expectedReward);
+	if (model->m_context->m_calculationType != WITHOUT)
+		return FindMaxReward(ChoosePreferredAction(prior, m), expectedReward);
 	else
 	{
 		expectedReward = REWARD_LOSS;
@@ -1293,7 +1551,7 @@ void nxnGrid::InitBeliefState(intVec & beliefState,const History & h) const
 	beliefState[0] = GetObsLoc(obs, 0);
 	
 	intVec observedState;
-	nxnGridState::IdxToState(obs, observedState);
+	m_context->IdxToState(obs, observedState);
 	int obj = 1;
 	for (; obj < CountMovingObjects() ; ++obj)
 	{
@@ -1312,10 +1570,137 @@ void nxnGrid::InitBeliefState(intVec & beliefState,const History & h) const
 	AddSheltersLocations(beliefState);
 }
 
+void nxnGrid::InitBeliefState(intVec & beliefState, const nxnGridPOMCPPrior & prior) const
+{
+	prior.LastObservedLocations(beliefState);
+	AddSheltersLocations(beliefState);
+}
+
 void nxnGrid::AddSheltersLocations(intVec & state) const
 {
 	for (auto v : m_shelters)
 		state.emplace_back(v.GetLocation().GetIdx(m_gridSize));
 }
 
-} //end ns despot
\ No newline at end of file
+POMCPPrior* nxnGrid::CreatePOMCPPrior(std::string name) const
+{
+	if (name == "UNIFORM" || name == "DEFAULT")
+		return new nxnGridPOMCPPrior(this);
+
+	return DSPOMDP::CreatePOMCPPrior(name);
+}
+
+/* =============================================================================
+* nxnGridPOMCPPrior Functions
+* =============================================================================*/
+
+nxnGridPOMCPPrior::nxnGridPOMCPPrior(const nxnGrid * model)
+: UniformPOMCPPrior(model)
+, m_model(model)
+, m_context(model->GetContext())
+, m_numObjects(model->CountMovingObjects())
+, m_runs(model->CountMovingObjects())
+, m_cache(CACHE_SIZE)
+, m_beliefState()
+, m_cacheHits(0)
+, m_cacheMisses(0)
+{
+}
+
+void nxnGridPOMCPPrior::history(History h)
+{
+	PopAll();
+	for (int i = 0; i < h.Size(); ++i)
+		PushObservation(h.Observation(i));
+
+	history_ = h;
+}
+
+void nxnGridPOMCPPrior::Add(int action, OBS_TYPE obs)
+{
+	UniformPOMCPPrior::Add(action, obs);
+	PushObservation(obs);
+}
+
+void nxnGridPOMCPPrior::PopLast()
+{
+	UniformPOMCPPrior::PopLast();
+	for (auto & runs : m_runs)
+	{
+		if (--runs.back().m_count == 0)
+			runs.pop_back();
+	}
+}
+
+void nxnGridPOMCPPrior::PopAll()
+{
+	UniformPOMCPPrior::PopAll();
+	for (auto & runs : m_runs)
+		runs.clear();
+}
+
+void nxnGridPOMCPPrior::PushObservation(OBS_TYPE obs)
+{
+	nxnGridStateView obsState(obs, *m_context);
+	for (int obj = 0; obj < m_numObjects; ++obj)
+	{
+		std::vector<LocationRun> & runs = m_runs[obj];
+		if (!runs.empty() && runs.back().m_loc == obsState[obj])
+			++runs.back().m_count;
+		else
+			runs.push_back({ obsState[obj], 1 });
+	}
+}
+
+void nxnGridPOMCPPrior::LastObservedLocations(intVec & locations) const
+{
+	locations.resize(m_numObjects);
+	int selfLoc = m_runs[0].back().m_loc;
+	locations[0] = selfLoc;
+	
+	int deadLoc = m_context->m_gridSize * m_context->m_gridSize;
+	for (int obj = 1; obj < m_numObjects; ++obj)
+	{
+		// non observed object is observed in self location. the last location different from current self location is the last observed location
+		const std::vector<LocationRun> & runs = m_runs[obj];
+		int loc = runs.back().m_loc;
+		if (loc == selfLoc)
+			loc = runs.size() > 1 ? runs[runs.size() - 2].m_loc : deadLoc;
+
+		locations[obj] = loc;
+	}
+}
+
+const std::vector<double> & nxnGridPOMCPPrior::PreferredRewards()
+{
+	LastObservedLocations(m_beliefState);
+	STATE_TYPE key = nxnGridState::StateToLUTIdx(m_beliefState, m_context->m_gridSize);
+	
+	// fibonacci hashing of the belief key to cache entry
+	unsigned long long hash = static_cast<unsigned long long>(key) * 0x9E3779B97F4A7C15ULL;
+	CacheEntry & entry = m_cache[hash >> (64 - CACHE_BITS)];
+	if (entry.m_valid && entry.m_key == key)
+	{
+		++m_cacheHits;
+		return entry.m_rewards;
+	}
+
+	++m_cacheMisses;
+	m_model->AddSheltersLocations(m_beliefState);
+	m_model->ChoosePreferredActionIMP(m_beliefState, entry.m_rewards);
+	entry.m_valid = true;
+	entry.m_key = key;
+
+	return entry.m_rewards;
+}
+
+void nxnGridPOMCPPrior::CollectStatistics(SearchStatistics & statistics)
+{
+	statistics.prior_cache_used = true;
+	statistics.num_prior_cache_hits += m_cacheHits;
+	statistics.num_prior_cache_misses += m_cacheMisses;
+	m_cacheHits = 0;
+	m_cacheMisses = 0;
+}
+
+} //end ns despot
@@ -2,8 +2,10 @@
 #define NXNGRID_H
 
 #include <string>
+#include <memory>
 
-#include "..\include\despot\core\pomdp.h"
+#include "../include/despot/core/pomdp.h"
+#include "../include/despot/solver/pomcp.h"
 
 #include <UDP_Prot.h>
 
@@ -11,60 +13,81 @@
 #include "Attack_Obj.h"
 #include "Movable_Obj.h"
 #include "ObjInGrid.h"
+#include "OfflineLUT.h"
 
 namespace despot 
 {
 
+class nxnGridContext;
+class nxnGridPOMCPPrior;
+
 /* =============================================================================
 * NxNState class
 * =============================================================================*/
 /// the class is non-thread safe. 
-/// the static members are specialized to one type of nxnGrid, so only one problem simulation can simultanuasely
+/// the problem constants (grid size, num of objects etc.) are taken from the context of the model that created the state
 class nxnGridState : public State 
 {
 
 public:
 	using intVec = std::vector<int>;
 	nxnGridState() = default;
-	nxnGridState(STATE_TYPE state_id, double weight = 0.0);
+	nxnGridState(STATE_TYPE state_id, double weight = 0.0, const nxnGridContext * context = nullptr);
 	
 	/// print the state
 	std::string text() const;
+	/// print the state with the shelters and the target of the episode
+	std::string text(const intVec & shelters, int targetLoc) const;
 
 	///update state given a new state
 	void UpdateState(STATE_TYPE newStateIdx);
 	void UpdateState(intVec newState);
 
-	/// init static members so previous model will not affect current
+	/// kept for compatibility. each model holds its own context so there are no static members to reset
 	static void InitStatic();
 
-	/// return the state vector given idx
-	static void IdxToState(STATE_TYPE state, intVec & stateVec);
-	/// return the state vector given observation
-	//static void IdxToState(OBS_TYPE obs, intVec & stateVec) { IdxToState(static_cast<STATE_TYPE>(obs), stateVec); };
-	/// return the state vector given state
-	static void IdxToState(const State * state, intVec & stateVec) { IdxToState(state->state_id, stateVec); };
-	/// return state given state vector
-	static STATE_TYPE StateToIdx(const intVec & state);
-	/// return state given state vector and grid size
-	static STATE_TYPE StateToIdx(const intVec & state, int gridSize);
+	/// return offline (lut) state idx given state vector and grid size (location of each object as digit in base gridSize^2 + 1)
+	static STATE_TYPE StateToLUTIdx(const intVec & state, int gridSize);
 
-	static STATE_TYPE MaxState();
+	/// context of the model the state belongs to
+	const nxnGridContext * m_context = nullptr;
+};
 
-	/// return idx of object that exist in location -1 if the object does not exist
-	static char ObjIdentity(intVec & state, int location);
+/* =============================================================================
+* nxnGridStateView class
+* =============================================================================*/
+/// fixed capacity in-place view of a packed state idx. each object location is a fixed width bit field of the idx
+/// so unpacking and packing are done using shifts and masks only (no heap allocation and no divisions)
+class nxnGridStateView
+{
+public:
+	using intVec = std::vector<int>;
+	/// max num of objects in state (self, enemies and non-involved)
+	static const int MAX_OBJECTS = 8;
 
-	/// number of objects in grid (size of state vector)
-	static int s_sizeState;
-	/// the border between the enemies location and the non-involved location in the state vector
-	static int s_numEnemies;
-	/// gridSize
-	static int s_gridSize;
-	/// target location
-	static int s_targetLoc;
-	/// shelter vector
-	static std::vector<int> s_shelters;
-	
+	nxnGridStateView() : m_size(0), m_bitsPerObj(1) {};
+	nxnGridStateView(STATE_TYPE idx, const nxnGridContext & context) { Unpack(idx, context); };
+	nxnGridStateView(const intVec & state, const nxnGridContext & context);
+
+	/// unpack state idx to view
+	void Unpack(STATE_TYPE idx, const nxnGridContext & context);
+	/// return the packed state idx of the view
+	STATE_TYPE Pack() const;
+	/// copy view to state vector
+	void ToVec(intVec & state) const;
+
+	int & operator[](int idx) { return m_locations[idx]; };
+	int operator[](int idx) const { return m_locations[idx]; };
+	int size() const { return m_size; };
+	int * data() { return m_locations; };
+
+	const int * begin() const { return m_locations; };
+	const int * end() const { return m_locations + m_size; };
+
+private:
+	int m_locations[MAX_OBJECTS];
+	int m_size;
+	int m_bitsPerObj;
 };
 
 /* =============================================================================
@@ -72,13 +95,13 @@ public:
 * =============================================================================*/
 /// base class for nxnGrid model. derived classes are including step and actions implementations
 /// the class is non thread safe. 
-/// the static members are specialized to one type of nxnGrid so only one problem can simultaneously run
+/// the problem constants are held in a per model context so different models can run simultaneously (each on its own thread)
 class nxnGrid : public DSPOMDP
 {	
 public:
 	using intVec = std::vector<int>;
 	using doubleVec = std::vector<double>;
-	using lut_t = std::map < STATE_TYPE, doubleVec >;
+	using lut_t = OfflineLUT::lut_t;
 	///	enum of objects
 	enum OBJECT { SELF, ENEMY, NON_INV, SHELTER, TARGET, NUM_OBJECTS };
 	enum VBS_OBJECTS { SELF_VBS, ENEMY_VBS, NON_INVOLVED_VBS, SHELTER_VBS, TARGET_VBS, OBSERVED_ENEMY_VBS, OBSERVED_NON_INVOLVED_VBS };
@@ -86,20 +109,42 @@ public:
 	/// enum of type of calculation using sarsop data map
 	enum CALCULATION_TYPE { WITHOUT, ALL, WO_NINV, JUST_ENEMY, ONE_ENEMY, WO_NINV_STUPID };
 	 
-	explicit nxnGrid(int gridSize, int traget, Self_Obj & self, std::vector<intVec> & objectsInitLoc);
+	/// level of offline lut pyramid (lut and the grid size it was created for)
+	struct LUTLevel
+	{
+		std::shared_ptr<const OfflineLUT> m_LUT;
+		int m_gridSize;
+	};
+
+	/// offline data and simulator connection of a model (the default is without lut and without simulator)
+	struct Settings
+	{
+		Settings();
+
+		/// lut pyramid (single level for one lut)
+		std::vector<LUTLevel> m_LUTs;
+		MODEL_TYPE m_modelType;
+		CALCULATION_TYPE m_calculationType;
+		/// for comunication with simulator (needed only for VBS model)
+		std::shared_ptr<UDP_Server> m_udpServer;
+	};
+
+	explicit nxnGrid(int gridSize, int traget, Self_Obj & self, std::vector<intVec> & objectsInitLoc, const Settings & settings = Settings());
 	~nxnGrid() = default;
 	
 	// Functions for self use
 
-	static MODEL_TYPE GetModelType() { return s_modelType; };
+	/// return model type
+	MODEL_TYPE GetModelType() const;
 
-	/// init udp server
-	static bool InitUDP(int portNum = -1);
-	/// init offline decision lut
-	static void InitLUT(lut_t & offlineLut, int offlineGridSize, MODEL_TYPE mType = ONLINE, CALCULATION_TYPE cType = WITHOUT);
-	/// add enemy object
+	/// create and init udp server for models communicating with the simulator
+	static std::shared_ptr<UDP_Server> InitUDP(int portNum = -1);
+
+	/// return the context of the model
+	std::shared_ptr<const nxnGridContext> GetContext() const { return m_context; };
+	/// add enemy object (exit if states of the model are allocated)
 	void AddObj(Attack_Obj&& obj); 
-	/// add non involved object
+	/// add non involved object (exit if states of the model are allocated)
 	void AddObj(Movable_Obj&& obj);
 	/// add shelter
 	void AddObj(ObjInGrid&& obj);
@@ -113,13 +158,15 @@ public:
 	/// get observed location of object (identified by idx) given observation
 	int GetObsLoc(OBS_TYPE obs, int objIdx) const;
 
-	/// return vector of rewards given model and prior
-	static void ChoosePreferredAction(POMCPPrior * prior, const DSPOMDP* m, doubleVec & expectedRewards);
+	/// return vector of rewards given model and prior (valid until the next query of the model or prior)
+	static const doubleVec & ChoosePreferredAction(POMCPPrior * prior, const DSPOMDP* m);
 	/// return a preferred action given model and prior
 	static int ChoosePreferredAction(POMCPPrior * prior, const DSPOMDP* m, double expectedReward);
 
 	/// initialize beliefState according to history
 	void InitBeliefState(intVec & beliefState, const History & h) const;
+	/// initialize beliefState according to the last observed locations tracked by the prior (without scanning the history)
+	void InitBeliefState(intVec & beliefState, const nxnGridPOMCPPrior & prior) const;
 
 	/// add to state shelter locations
 	void AddSheltersLocations(intVec & state) const;
@@ -135,6 +182,14 @@ public:
 
 	/// return the probability for an observation given a state and an action
 	virtual double ObsProb(OBS_TYPE obs, const State& state, int action) const override;
+	/// return the probability for an observation for each particle (particles are unpacked in chunks)
+	virtual void ObsProbBatch(OBS_TYPE obs, const std::vector<State*>& particles, int action, doubleVec & probs) const override;
+	/// return the part of last observation that affects the transition (only enemy related actions are using the last observation)
+	virtual OBS_TYPE TransitionObs(int action, OBS_TYPE lastObs) const override;
+	/// the state is fully described by its index and step is a function of (state, action, random, last observation)
+	virtual bool SupportsTransitionCache() const override { return true; };
+	/// step and particles are safe to use from concurrent search threads (the memory pool is locked and random numbers are per thread)
+	virtual bool IsThreadSafe() const override { return true; };
 	/// return the probability for an observation given a state and an action
 	double ObsProbOneObj(OBS_TYPE obs, const State& state, int action, int objIdx) const;
 
@@ -153,6 +208,9 @@ public:
 	virtual void Free(State* particle) const override;
 	virtual int NumActiveParticles() const override;
 
+	/// create prior for pomcp (default prior is uniform prior tracking the last observed location of each object)
+	virtual POMCPPrior* CreatePOMCPPrior(std::string name = "DEFAULT") const override;
+
 	/// return the max reward available
 	virtual double GetMaxReward() const override{ return REWARD_WIN; };
 
@@ -165,23 +223,25 @@ protected:
 	/// check if 2 idx are in a given range on the grid
 	static bool InRange(int idx1, int idx2, double range, int gridSize);
 
-	/// return true if the robot is dead by enemy attack given random num(0-1). state is not reference by reason
-	bool CalcIfDead(int enemyIdx, intVec state, double & randomNum) const;
+	/// return true if the robot is dead by enemy attack given random num(0-1)
+	bool CalcIfDead(int enemyIdx, const nxnGridStateView & state, double & randomNum) const;
 
 	/// return identity of the objIdx
 	enum OBJECT WhoAmI(int objIdx) const;
 
-	/// create a vector of random numbers between 0 - 1
-	static void CreateRandomVec(doubleVec & randomVec, int size);
+	/// return random number between 0 - 1 derived from the scenario random number and a counter (same input gives the same output)
+	static double ScenarioRandom(double randomNum, int counter);
+	/// fill an array with random numbers between 0 - 1 derived from the scenario random number (counters firstCounter - firstCounter + size)
+	static void CreateRandomVec(double * randomVec, int size, double randomNum, int firstCounter);
 
 	/// retrieve the observed state given current state and random number
-	OBS_TYPE FindObservation(intVec & state, double p) const;
+	OBS_TYPE FindObservation(const nxnGridStateView & state, double p) const;
 
 	/// advance the state to the next step position (regarding to other objects movement)
-	void SetNextPosition(intVec & state, doubleVec & randomNum) const;
+	void SetNextPosition(nxnGridStateView & state, const double * randomNum) const;
 
 	/// change object location according to its movement properties and random number
-	void CalcMovement(intVec & state, const Movable_Obj *object, double rand, int objIdx) const;
+	void CalcMovement(nxnGridStateView & state, const Movable_Obj *object, double rand, int objIdx) const;
 
 	// CHECK LOCATIONS :
 	/// check if the next location (location + (x,y)) is in grid boundary
@@ -189,11 +249,23 @@ protected:
 	/// return true if the object idx location does not repeat in state
 	static bool NoRepetitions(intVec & state, int currIdx, int gridSize);
 	/// return true if location is valid for a given state (no repeats)
-	static bool ValidLocation(intVec & state, int location);
+	static bool ValidLocation(const nxnGridStateView & state, int location);
 	/// return true if location is valid for a given state (no repeats & in grid)
-	static bool ValidLegalLocation(intVec & state, Coordinate location, int end, int gridSize);
+	static bool ValidLegalLocation(const intVec & state, Coordinate location, int end, int gridSize);
+	static bool ValidLegalLocation(const nxnGridStateView & state, Coordinate location, int end, int gridSize);
+
+	/// return the best valid move of self toward location (self location when there is no valid move).
+	/// location may be below the grid (y = gridSize, dead objects are at gridSize^2) the move is chosen as for any location but stays in grid
+	int MoveToward(const nxnGridStateView & state, int location) const;
+	/// return the farthest valid move of self from location (self location when there is no farther valid move). location may be below the grid
+	int MoveFrom(const nxnGridStateView & state, int location) const;
+	/// move a specific object closer to robot
+	void GetCloser(nxnGridStateView & state, int objIdx) const;
+	/// return move given random number (0-1)
+	int FindObjMove(int currLocation, double random) const;
 
 private:
+	friend class nxnGridPOMCPPrior;
 	/// implementation of choose prefferred action
 	void ChoosePreferredActionIMP(intVec & state, doubleVec & expectedReward) const;
 
@@ -205,26 +277,35 @@ private:
 	void InitialBeliefStateRec(intVec & state, int currObj, double stateProb, std::vector<State*> & particles) const;
 
 	/// find the observed state according to random number and original state
-	void DecreasePObsRec(intVec & currState, const intVec & originalState, int currIdx, double pToDecrease, double &pLeft) const;
+	void DecreasePObsRec(nxnGridStateView & currState, const nxnGridStateView & originalState, int currIdx, double pToDecrease, double &pLeft) const;
 
 	/// return movement properties of an object
 	const Move_Properties & GetMovement(int objIdx);
-	
-	/// move a specific object closer to robot
-	void GetCloser(intVec & state, int objIdx, int gridSize) const;
 
-	/// return move given random number (0-1)
-	int FindObjMove(int currLocation, double random, int gridSize) const;
+	/// init neighbors and move tables of the grid
+	void InitMoveTables();
 
 	/// return true if observedLocation is surrouning a location (in 1 of the 8 directions to location)
 	static bool InSquare(int location, int location2, int squareSize, int gridSize);
 
+	/// insert lut values of state to values. the state is looked up in the finest lut level where the scaled state 
+	/// needs no fix-up (no 2 objects in the same scaled location), otherwise in the coarsest level. return false if the state is not found
+	bool FindLUTValues(const intVec & state, double * values) const;
+	/// init scale table of each lut level
+	void InitLUTScaleTables();
+	/// sort lut levels from the finest grid to the coarsest (exit if the levels are empty or have different num of actions)
+	static void OrganizeLUTLevels(std::vector<LUTLevel> & levels);
+
 	// Rescaling state functions:
-	void ScaleState(const intVec & beliefState, intVec & scaledState) const;
 	void ScaleState(const intVec & beliefState, intVec & scaledState, int newGridSize, int prevGridSize) const;
+	void ScaleState(const intVec & beliefState, intVec & scaledState, const intVec & scaleTable, int newGridSize) const;
+	/// init table of scaled location for each location in prev grid up to maxLocation (default is the out of grid location prevGridSize^2)
+	static void InitScaleTable(intVec & scaleTable, int newGridSize, int prevGridSize, int maxLocation = -1);
+	/// return true if the scaled state needs fix-up (self on target or 2 objects in the same scaled location)
+	static bool ScaleCollision(const intVec & scaledState, int newGridSize);
 
 	/// initialize rewards vector of 2 enemies from 2 vectors of rewards vec of 1 enemy
-	void Combine2EnemiesRewards(const intVec & beliefState, const doubleVec & rewards1E, const doubleVec & rewards2E, doubleVec & rewards) const;
+	void Combine2EnemiesRewards(const intVec & beliefState, const double * rewards1E, const double * rewards2E, doubleVec & rewards) const;
 
 
 	/// move non protected shelters to close non-object location
@@ -236,13 +317,19 @@ private:
 	/// drop shelter from state (make shelter in accessible)
 	void DropUnProtectedShelter(intVec & woShelter, int gridSize) const;
 
+	/// return a copy of the context to change and publish (published contexts are never changed). states point to the context
+	/// of the model, so exit if states are allocated (the published context would be released while they are in use)
+	std::shared_ptr<nxnGridContext> CopyContext() const;
+	/// update size of state after adding object (exit if the state cannot be packed to state idx)
+	void UpdateStateSize(nxnGridContext & context) const;
+
 	/// return num enemies in calculation
 	int NumEnemiesInCalc() const;
 	/// return true if the lut is without non-involved
 	int NumNonInvInCalc() const;
 
 
-	/// init state according to s_objectsInitLocations
+	/// init state according to the init locations of objects
 	void InitStateRandom();
 	/// init state from vbs simulator
 	void InitStateVBS();
@@ -268,22 +355,30 @@ protected:
 	std::vector<Movable_Obj> m_nonInvolvedVec;
 	
 	std::vector<ObjInGrid> m_shelters;
-
-	/// for comunication with simulator
-	static UDP_Server s_udpServer;
-
-	// init locations of objects (needs to be in the size of number of objects - including self)
-	static std::vector<intVec> s_objectsInitLocations;
-
-	static int s_numBasicActions;
-	static int s_numEnemyRelatedActions;
-
-	/// offline data LUT
-	static lut_t s_LUT;
-	static int s_lutGridSize;
-	/// type of model
-	static enum MODEL_TYPE s_modelType;
-	static enum CALCULATION_TYPE s_calculationType;
+	/// location of each shelter in the current episode
+	intVec m_sheltersLocations;
+
+	/// actions layout (enemy related actions of each enemy follow the basic actions)
+	int m_numBasicActions = -1;
+	int m_numEnemyRelatedActions = -1;
+
+	/// neighbor of each location in each of the 8 directions (-1 when out of grid)
+	intVec m_neighbors;
+	/// step toward location for each (location, goTo) (idx = location * NumMoveGoals() + goTo). 
+	/// the step is coded as (xChange + 1) + 3 * (yChange + 1) with flag for the order of the single axis moves
+	std::vector<char> m_stepToward;
+	/// directions farther from location for each (location, goFrom) ordered from the farthest (4 bits each, idx as m_stepToward)
+	std::vector<unsigned int> m_stepsFrom;
+	/// num of goTo and goFrom locations in the move tables: the grid and the row below it (y = gridSize) where goals of dead objects are
+	int NumMoveGoals() const { return m_gridSize * (m_gridSize + 1); };
+	/// scaled location in lut grid of each location in grid for each lut level (initialized when the lut is set)
+	std::vector<intVec> m_lutScaleTables;
+
+	/// problem constants shared by the model and its states
+	std::shared_ptr<const nxnGridContext> m_context;
+
+	/// counters of the random numbers drawn in step from the scenario random number
+	enum STEP_RANDOM { OBSERVATION_RANDOM = 0, OBJECT_MOVES_RANDOM = 1, ENEMIES_ATTACKS_RANDOM = OBJECT_MOVES_RANDOM + nxnGridStateView::MAX_OBJECTS };
 
 	/// rewards for different events
 	static const double REWARD_WIN;
@@ -296,6 +391,144 @@ protected:
 	mutable MemoryPool<nxnGridState> memory_pool_;
 };
 
+/* =============================================================================
+* nxnGridPOMCPPrior class
+* =============================================================================*/
+/// uniform prior that keeps the last observed location of each moving object up to date while the history grows and shrinks.
+/// for each object the history observations are kept as runs of identical locations so Add and PopLast cost O(objects)
+/// the lut rewards of a belief are memoized in a bounded direct mapped cache keyed by the belief (before scaling)
+class nxnGridPOMCPPrior : public UniformPOMCPPrior
+{
+public:
+	using intVec = std::vector<int>;
+
+	explicit nxnGridPOMCPPrior(const nxnGrid * model);
+
+	using UniformPOMCPPrior::history;
+	virtual void history(History h) override;
+	virtual void Add(int action, OBS_TYPE obs) override;
+	virtual void PopLast() override;
+	virtual void PopAll() override;
+
+	/// fill location of self and the last location each moving object was observed in (dead location if it was never observed)
+	/// same result as scanning the history backwards. history should not be empty
+	void LastObservedLocations(intVec & locations) const;
+
+	/// return the lut rewards of the current belief (valid until the next call). history should not be empty
+	const std::vector<double> & PreferredRewards();
+
+	/// add cache hits and misses since the last call to statistics
+	virtual void CollectStatistics(SearchStatistics & statistics) override;
+
+	/// num of entries in rewards cache (2 ^ CACHE_BITS)
+	static const int CACHE_BITS = 14;
+	static const int CACHE_SIZE = 1 << CACHE_BITS;
+
+private:
+	/// sequence of consecutive observations with the same location of an object
+	struct LocationRun
+	{
+		int m_loc;
+		int m_count;
+	};
+
+	/// rewards of one belief
+	struct CacheEntry
+	{
+		bool m_valid = false;
+		STATE_TYPE m_key = 0;
+		std::vector<double> m_rewards;
+	};
+
+	/// add observation to runs of all objects
+	void PushObservation(OBS_TYPE obs);
+
+	const nxnGrid * m_model;
+	std::shared_ptr<const nxnGridContext> m_context;
+	int m_numObjects;
+	/// runs of each moving object (idx = object idx). the last run is the most recent
+	std::vector<std::vector<LocationRun>> m_runs;
+
+	std::vector<CacheEntry> m_cache;
+	intVec m_beliefState;
+	long m_cacheHits;
+	long m_cacheMisses;
+};
+
+/* =============================================================================
+* nxnGridContext class
+* =============================================================================*/
+/// constants of one nxnGrid problem shared by the model and its states. 
+/// the context is filled by the model while it is built and is never changed after it is published (a new object replaces the
+/// context of the model with an updated copy) so it can be read without locks
+class nxnGridContext
+{
+public:
+	using intVec = std::vector<int>;
+
+	/// init bit fields of the packed state idx given grid size
+	void InitPacking(int gridSize);
+
+	/// return the state vector given idx
+	void IdxToState(STATE_TYPE idx, intVec & stateVec) const;
+	/// return state idx given state vector
+	STATE_TYPE StateToIdx(const intVec & state) const;
+	/// return the upper bound of state idx
+	STATE_TYPE MaxState() const;
+
+	/// return identity of object that exist in location ('_' if there is no object)
+	char ObjIdentity(const intVec & state, int location, const intVec & shelters, int targetLoc) const;
+
+	/// number of objects in grid (size of state vector)
+	int m_sizeState = 1;
+	/// the border between the enemies location and the non-involved location in the state vector
+	int m_numEnemies = 0;
+	/// gridSize
+	int m_gridSize = 0;
+	/// num of bits of each object location in the packed state idx
+	int m_bitsPerObj = 1;
+	/// mask of one object location in the packed state idx
+	STATE_TYPE m_objMask = 1;
+
+	// init locations of objects (needs to be in the size of number of objects - including self)
+	std::vector<intVec> m_objectsInitLocations;
+
+	/// observation probabilities of self precomputed for the grid
+	std::shared_ptr<const ObservationTable> m_observationTable;
+	/// attack data of self and of each enemy (idx = enemy idx) precomputed for the grid
+	std::shared_ptr<const AttackTable> m_selfAttackTable;
+	std::vector<std::shared_ptr<const AttackTable>> m_enemyAttackTables;
+
+	/// offline data LUT levels ordered from the finest grid to the coarsest
+	std::vector<nxnGrid::LUTLevel> m_LUTs;
+	/// type of model
+	enum nxnGrid::MODEL_TYPE m_modelType = nxnGrid::ONLINE;
+	enum nxnGrid::CALCULATION_TYPE m_calculationType = nxnGrid::WITHOUT;
+
+	/// for comunication with simulator
+	std::shared_ptr<UDP_Server> m_udpServer;
+};
+
+inline void nxnGridStateView::Unpack(STATE_TYPE idx, const nxnGridContext & context)
+{
+	m_size = context.m_sizeState;
+	m_bitsPerObj = context.m_bitsPerObj;
+	for (int i = m_size - 1; i >= 0; --i)
+	{
+		m_locations[i] = static_cast<int>(idx & context.m_objMask);
+		idx >>= m_bitsPerObj;
+	}
+}
+
+inline STATE_TYPE nxnGridStateView::Pack() const
+{
+	STATE_TYPE idx = 0;
+	for (int i = 0; i < m_size; ++i)
+		idx = (idx << m_bitsPerObj) | m_locations[i];
+
+	return idx;
+}
+
 } // end ns despot
 
 #endif	// NXNGRID_H
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <random>
+#include <vector>
+
+// properties of objects
+#include "Coordinate.h"
+#include "Attacks.h"
+
+/// randomized check that the table walk of DirectAttack::AttackOnline (state array) gives the same state as the attack
+/// calculated on state vector. attackers and targets are drawn mostly in range of each other, with dead attackers and dead targets
+
+using intVec = std::vector<int>;
+
+static const int s_NUM_CHECKS = 200000;
+static const int s_MAX_OBJECTS = 5;
+static const int s_MAX_SHELTERS = 2;
+
+/// return number of attacks with different results for a grid size
+int CheckGrid(int gridSize, double range, double pHit, std::mt19937 & generator);
+
+int main(int argc, char* argv[])
+{
+	std::mt19937 generator(1);
+	int numDiff = 0;
+	for (int gridSize : { 5, 10, 20 })
+	{
+		// range of the models (gridSize / 4) and a non-integer range
+		numDiff += CheckGrid(gridSize, gridSize / 4, 0.5, generator);
+		numDiff += CheckGrid(gridSize, 2.5, 0.3, generator);
+	}
+
+	std::cout << (numDiff == 0 ? "attack equivalence passed\n" : "attack equivalence failed\n");
+	return numDiff == 0 ? 0 : 1;
+}
+
+int CheckGrid(int gridSize, double range, double pHit, std::mt19937 & generator)
+{
+	DirectAttack attack(range, pHit);
+	std::shared_ptr<const AttackTable> table = attack.CreateAttackTable(gridSize);
+
+	int numLocations = gridSize * gridSize;
+	int deadLoc = numLocations;
+	int radius = static_cast<int>(range);
+	std::uniform_real_distribution<double> random(0.0, 1.0);
+
+	int numDiff = 0;
+	int numChanged = 0;
+	for (int i = 0; i < s_NUM_CHECKS; ++i)
+	{
+		// objects (the attacker is object 0 and the target is object 1) in different locations or dead
+		int numObjects = 2 + generator() % (s_MAX_OBJECTS - 1);
+		intVec state;
+		while (state.size() < numObjects)
+		{
+			int loc = random(generator) < 0.1 ? deadLoc : generator() % numLocations;
+			// most targets are near the attacker so the shot is in range
+			if (state.size() == 1 && state[0] != deadLoc && random(generator) < 0.8)
+			{
+				int x = state[0] % gridSize + static_cast<int>(generator() % (2 * radius + 1)) - radius;
+				int y = state[0] / gridSize + static_cast<int>(generator() % (2 * radius + 1)) - radius;
+				loc = (x >= 0 & x < gridSize & y >= 0 & y < gridSize) ? x + y * gridSize : deadLoc;
+			}
+
+			bool repeats = false;
+			for (int l : state)
+				repeats |= (l == loc) & (loc != deadLoc);
+			if (!repeats)
+				state.emplace_back(loc);
+		}
+
+		intVec shelters(generator() % (s_MAX_SHELTERS + 1));
+		for (int & s : shelters)
+			s = generator() % numLocations;
+
+		int attackerLoc = state[0];
+		int targetLoc = state[1];
+		double rand = random(generator);
+
+		intVec vecState(state);
+		attack.AttackOnline(attackerLoc, targetLoc, vecState, shelters, gridSize, rand);
+
+		intVec arrState(state);
+		attack.AttackOnline(attackerLoc, targetLoc, arrState.data(), arrState.size(), shelters, gridSize, rand, table.get());
+		numChanged += vecState != state;
+
+		if (vecState != arrState)
+		{
+			if (numDiff < 10)
+			{
+				std::cout << "grid " << gridSize << " range " << range << ": attacker " << attackerLoc << " target " << targetLoc << " random " << rand << " state (";
+				for (int l : state)
+					std::cout << l << ", ";
+				std::cout << ")\n";
+			}
+			++numDiff;
+		}
+	}
+
+	std::cout << "grid " << gridSize << " range " << range << ": " << numDiff << " different attacks out of " << s_NUM_CHECKS << " (" << numChanged << " attacks killed an object)\n";
+	return numDiff;
+}
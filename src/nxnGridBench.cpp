@@ -0,0 +1,272 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "nxnGridToolModel.h"
+#include "OfflineLUT.h"
+
+using namespace despot;
+
+/// benchmarks of the nxnGrid model. run all benchmarks or the benchmarks given as arguments:
+/// nxnGridBench [step] [belief] [lut]
+
+static const int s_NUM_STEP_INPUTS = 100000;
+static const int s_NUM_STEPS = 2000000;
+static const int s_NUM_PARTICLES = 5000;
+static const int s_NUM_BELIEF_UPDATES = 400;
+static const int s_NUM_LUT_STATES = 500000;
+static const int s_NUM_LUT_ACTIONS = 7;
+static const int s_NUM_LUT_LOOKUPS = 2000000;
+
+void CreateRandomStates(const nxnGrid * model, int numStates, std::mt19937 & generator, std::vector<STATE_TYPE> & states);
+double SecondsSince(std::chrono::steady_clock::time_point start);
+
+void BenchStep(int gridSize);
+void BenchBeliefUpdate(int gridSize);
+void BenchLUT();
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> benchmarks(argv + 1, argv + argc);
+	if (benchmarks.empty())
+		benchmarks = { "step", "belief", "lut" };
+
+	for (const std::string & benchmark : benchmarks)
+	{
+		if (benchmark == "step")
+		{
+			BenchStep(10);
+			BenchStep(20);
+		}
+		else if (benchmark == "belief")
+		{
+			BenchBeliefUpdate(10);
+			BenchBeliefUpdate(20);
+		}
+		else if (benchmark == "lut")
+		{
+			BenchLUT();
+		}
+		else
+		{
+			std::cerr << "unknown benchmark " << benchmark << "\n";
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/// create states with objects in random locations (non-self objects may be dead)
+void CreateRandomStates(const nxnGrid * model, int numStates, std::mt19937 & generator, std::vector<STATE_TYPE> & states)
+{
+	const nxnGridContext & context = *model->GetContext();
+	int numLocations = model->GetGridSize() * model->GetGridSize();
+	std::vector<int> state(model->CountMovingObjects());
+
+	states.resize(numStates);
+	for (STATE_TYPE & idx : states)
+	{
+		for (int o = 0; o < state.size(); ++o)
+			state[o] = generator() % (numLocations + (o > 0));
+		idx = context.StateToIdx(state);
+	}
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// steps per second of random (state, action, scenario random number) inputs
+void BenchStep(int gridSize)
+{
+	std::unique_ptr<nxnGrid> model(nxnGridToolModel::Create(gridSize, nxnGridToolModel::GLOBAL));
+	std::mt19937 generator(5);
+	std::uniform_real_distribution<double> random(0.0, 1.0);
+
+	std::vector<STATE_TYPE> states;
+	CreateRandomStates(model.get(), s_NUM_STEP_INPUTS, generator, states);
+	std::vector<int> actions(s_NUM_STEP_INPUTS);
+	std::vector<double> randoms(s_NUM_STEP_INPUTS);
+	for (int i = 0; i < s_NUM_STEP_INPUTS; ++i)
+	{
+		actions[i] = generator() % model->NumActions();
+		randoms[i] = random(generator);
+	}
+
+	State * state = model->Allocate(0, 1.0);
+	double sumRewards = 0.0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < s_NUM_STEPS; ++i)
+	{
+		int input = i % s_NUM_STEP_INPUTS;
+		state->state_id = states[input];
+		double reward;
+		OBS_TYPE obs;
+		// the state is its own last observation (all objects are observed)
+		model->Step(*state, randoms[input], actions[input], states[input], reward, obs);
+		sumRewards += reward;
+	}
+	double seconds = SecondsSince(start);
+	model->Free(state);
+
+	std::cout << "step " << gridSize << "x" << gridSize << ": " << static_cast<long>(s_NUM_STEPS / seconds) << " steps/sec (sum of rewards = " << sumRewards << ")\n";
+}
+
+/// particles per second of belief update (step of each particle and probability of the observation as in ParticleBelief::Update)
+void BenchBeliefUpdate(int gridSize)
+{
+	std::unique_ptr<nxnGrid> model(nxnGridToolModel::Create(gridSize, nxnGridToolModel::GLOBAL));
+	const nxnGridContext & context = *model->GetContext();
+	std::mt19937 generator(9);
+	std::uniform_real_distribution<double> random(0.0, 1.0);
+
+	// self location is known, the other objects are spread in the grid
+	std::vector<STATE_TYPE> states;
+	CreateRandomStates(model.get(), s_NUM_PARTICLES, generator, states);
+	std::vector<int> stateVec;
+	for (STATE_TYPE & idx : states)
+	{
+		context.IdxToState(idx, stateVec);
+		stateVec[0] = gridSize + 1;
+		idx = context.StateToIdx(stateVec);
+	}
+
+	std::vector<State*> particles(s_NUM_PARTICLES);
+	for (int i = 0; i < s_NUM_PARTICLES; ++i)
+		particles[i] = model->Allocate(states[i], 1.0 / s_NUM_PARTICLES);
+
+	std::vector<double> randomNums(s_NUM_PARTICLES);
+	for (double & r : randomNums)
+		r = random(generator);
+
+	std::vector<double> rewards, probs;
+	std::vector<OBS_TYPE> observations;
+	std::vector<bool> terminals;
+	double sumProbs = 0.0;
+	auto start = std::chrono::steady_clock::now();
+	for (int u = 0; u < s_NUM_BELIEF_UPDATES; ++u)
+	{
+		for (int i = 0; i < s_NUM_PARTICLES; ++i)
+			particles[i]->state_id = states[i];
+
+		int action = u % model->NumActions();
+		model->StepBatch(particles, randomNums, action, states, rewards, observations, terminals);
+		// the real observation is taken from one of the particles
+		model->ObsProbBatch(observations[u % s_NUM_PARTICLES], particles, action, probs);
+		for (double p : probs)
+			sumProbs += p;
+	}
+	double seconds = SecondsSince(start);
+
+	for (State * particle : particles)
+		model->Free(particle);
+
+	std::cout << "belief update " << gridSize << "x" << gridSize << ": " << static_cast<long>(static_cast<double>(s_NUM_PARTICLES) * s_NUM_BELIEF_UPDATES / seconds)
+		<< " particles/sec (sum of probabilities = " << sumProbs << ")\n";
+}
+
+/// load time and lookups per second of lut files. the std::map rows are loaded and searched the way luts were used before OfflineLUT
+void BenchLUT()
+{
+	std::mt19937 generator(13);
+	std::uniform_real_distribution<double> random(-2.0, 1.0);
+
+	// states of 4 objects in 10x10 grid (lut idx base is 10^2 + 1)
+	STATE_TYPE maxKey = 101 * 101 * 101 * 101;
+	OfflineLUT::lut_t lut;
+	while (lut.size() < s_NUM_LUT_STATES)
+	{
+		OfflineLUT::doubleVec values(s_NUM_LUT_ACTIONS);
+		for (double & v : values)
+			v = random(generator);
+		lut[generator() % maxKey] = values;
+	}
+
+	// old format file (int size, int numActions, {int state, double values[numActions]}) and flat file
+	std::string oldFName("nxnGridBench_old_LUT.bin");
+	std::string flatFName("nxnGridBench_flat_LUT.bin");
+	{
+		std::ofstream out(oldFName, std::ios::out | std::ios::binary | std::ios::trunc);
+		int size = lut.size();
+		int numActions = s_NUM_LUT_ACTIONS;
+		out.write(reinterpret_cast<const char *>(&size), sizeof(int));
+		out.write(reinterpret_cast<const char *>(&numActions), sizeof(int));
+		for (const auto & row : lut)
+		{
+			int state = static_cast<int>(row.first);
+			out.write(reinterpret_cast<const char *>(&state), sizeof(int));
+			out.write(reinterpret_cast<const char *>(row.second.data()), numActions * sizeof(double));
+		}
+	}
+	OfflineLUT(lut).Write(flatFName);
+
+	// load (files are in the page cache after they are written)
+	auto start = std::chrono::steady_clock::now();
+	OfflineLUT::lut_t mapLUT;
+	{
+		std::ifstream in(oldFName, std::ios::in | std::ios::binary);
+		int size, numActions;
+		in.read(reinterpret_cast<char *>(&size), sizeof(int));
+		in.read(reinterpret_cast<char *>(&numActions), sizeof(int));
+		for (int i = 0; i < size; ++i)
+		{
+			int state;
+			in.read(reinterpret_cast<char *>(&state), sizeof(int));
+			OfflineLUT::doubleVec values(numActions);
+			in.read(reinterpret_cast<char *>(values.data()), numActions * sizeof(double));
+			mapLUT[state] = values;
+		}
+	}
+	double mapLoad = SecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	OfflineLUT oldLUT;
+	oldLUT.Load(oldFName);
+	double oldLoad = SecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	OfflineLUT flatLUT;
+	flatLUT.Load(flatFName);
+	double flatLoad = SecondsSince(start);
+
+	std::cout << "lut load (" << lut.size() << " states): std::map " << mapLoad * 1000 << " ms, old format " << oldLoad * 1000 << " ms, flat (mapped) " << flatLoad * 1000 << " ms\n";
+
+	// lookups of states in the lut and of absent states
+	std::vector<STATE_TYPE> keys(s_NUM_LUT_LOOKUPS);
+	std::vector<STATE_TYPE> lutKeys;
+	for (const auto & row : lut)
+		lutKeys.emplace_back(row.first);
+	for (STATE_TYPE & key : keys)
+		key = generator() % 10 == 0 ? generator() % maxKey : lutKeys[generator() % lutKeys.size()];
+
+	double sumValues = 0.0;
+	start = std::chrono::steady_clock::now();
+	for (STATE_TYPE key : keys)
+	{
+		auto itr = mapLUT.find(key);
+		if (itr != mapLUT.end())
+			sumValues += itr->second[0];
+	}
+	double mapLookup = SecondsSince(start);
+
+	double values[s_NUM_LUT_ACTIONS];
+	start = std::chrono::steady_clock::now();
+	for (STATE_TYPE key : keys)
+	{
+		if (flatLUT.Find(key, values))
+			sumValues += values[0];
+	}
+	double flatLookup = SecondsSince(start);
+
+	std::cout << "lut lookup: std::map " << static_cast<long>(s_NUM_LUT_LOOKUPS / mapLookup) << " lookups/sec, flat " << static_cast<long>(s_NUM_LUT_LOOKUPS / flatLookup)
+		<< " lookups/sec (sum of values = " << sumValues << ")\n";
+
+	remove(oldFName.c_str());
+	remove(flatFName.c_str());
+}
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <thread>
+#include <memory>
+#include <random>
+
+#include "../include/despot/solver/pomcp.h"
+
+#include "nxnGridToolModel.h"
+
+using namespace despot;
+
+/// run of 2 nxnGrid models (different grid sizes and settings) on separate threads. each model steps a fixed sequence of
+/// (state, action, random) triples that is compared to a run of the model alone and plans a short pomcp episode.
+/// the models share their observation and attack objects so build with thread sanitizer to check for data races
+
+static const int s_NUM_STEP_CHECKS = 20000;
+static const int s_NUM_PLAN_STEPS = 5;
+static const double s_TIME_PER_MOVE = 0.05;
+
+unsigned long long StepHash(const nxnGrid * model);
+bool PlanEpisode(const nxnGrid * model);
+
+int main(int argc, char* argv[])
+{
+	Globals::config.time_per_move = s_TIME_PER_MOVE;
+	Globals::config.silence = true;
+
+	// attack and observation objects are shared by both models (the tables of each grid are kept in the context of the model)
+	nxnGridToolModel::Objects objects(2);
+
+	nxnGrid::Settings globalSettings;
+	nxnGrid::Settings localSettings;
+	localSettings.m_calculationType = nxnGrid::ALL;
+
+	std::unique_ptr<nxnGrid> models[2] = { std::unique_ptr<nxnGrid>(nxnGridToolModel::Create(5, nxnGridToolModel::GLOBAL, globalSettings, objects)),
+		std::unique_ptr<nxnGrid>(nxnGridToolModel::Create(10, nxnGridToolModel::LOCAL, localSettings, objects)) };
+
+	// reference run of each model alone
+	unsigned long long expected[2];
+	for (int m = 0; m < 2; ++m)
+		expected[m] = StepHash(models[m].get());
+
+	unsigned long long hash[2];
+	bool planned[2];
+	std::thread threads[2];
+	for (int m = 0; m < 2; ++m)
+	{
+		threads[m] = std::thread([&, m]()
+		{
+			hash[m] = StepHash(models[m].get());
+			planned[m] = PlanEpisode(models[m].get());
+		});
+	}
+
+	for (int m = 0; m < 2; ++m)
+		threads[m].join();
+
+	bool passed = true;
+	for (int m = 0; m < 2; ++m)
+	{
+		std::cout << "model " << m << " (grid size = " << models[m]->GetGridSize() << "): steps " << (hash[m] == expected[m] ? "identical" : "DIFFERENT")
+			<< ", planning " << (planned[m] ? "succeeded" : "FAILED") << "\n";
+		passed &= (hash[m] == expected[m]) & planned[m];
+	}
+
+	std::cout << (passed ? "concurrent run passed\n" : "concurrent run failed\n");
+	return passed ? 0 : 1;
+}
+
+/// return hash of the results of stepping a fixed sequence of states, actions and random numbers
+unsigned long long StepHash(const nxnGrid * model)
+{
+	// local generator so the sequence does not depend on other threads (Random is using the shared rand())
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<double> random(0.0, 1.0);
+	const nxnGridContext & context = *model->GetContext();
+	int numLocations = model->GetGridSize() * model->GetGridSize();
+	std::vector<int> stateVec(model->CountMovingObjects());
+
+	unsigned long long hash = 1469598103934665603ull;
+	auto mix = [&hash](unsigned long long v) { hash ^= v; hash *= 1099511628211ull; };
+	for (int i = 0; i < s_NUM_STEP_CHECKS; ++i)
+	{
+		for (int o = 0; o < stateVec.size(); ++o)
+			stateVec[o] = generator() % (numLocations + (o > 0));
+
+		State * state = model->Allocate(context.StateToIdx(stateVec), 1.0);
+		OBS_TYPE lastObs = state->state_id;
+		int action = generator() % model->NumActions();
+		double reward;
+		OBS_TYPE obs;
+		bool terminal = model->Step(*state, random(generator), action, lastObs, reward, obs);
+		double pObs = model->ObsProb(obs, *state, action);
+
+		mix(state->state_id);
+		mix(obs);
+		mix(terminal);
+		mix(static_cast<unsigned long long>(reward * 1000));
+		mix(static_cast<unsigned long long>(pObs * 1e9));
+		model->Free(state);
+	}
+
+	return hash;
+}
+
+/// plan a short episode with pomcp. return true if all planned actions are valid
+bool PlanEpisode(const nxnGrid * model)
+{
+	std::mt19937 generator(11);
+	std::uniform_real_distribution<double> random(0.0, 1.0);
+	std::unique_ptr<State> state(model->CreateStartState("DEFAULT"));
+	std::unique_ptr<POMCPPrior> prior(model->CreatePOMCPPrior("DEFAULT"));
+	std::unique_ptr<Belief> belief(model->InitialBelief(state.get(), "DEFAULT"));
+	POMCP solver(model, prior.get(), belief.get());
+
+	OBS_TYPE lastObs = state->state_id;
+	for (int step = 0; step < s_NUM_PLAN_STEPS; ++step)
+	{
+		int action = solver.Search().action;
+		if (action < 0 || action >= model->NumActions())
+			return false;
+
+		double reward;
+		OBS_TYPE obs;
+		bool terminal = model->Step(*state, random(generator), action, lastObs, reward, obs);
+		if (terminal)
+			break;
+
+		solver.Update(action, obs);
+		lastObs = obs;
+	}
+
+	return true;
+}
@@ -1,9 +1,10 @@
 #include <string>
 #include <math.h>
 #include <limits.h>
+#include <random>
 
-#include "..\include\despot\util\random.h"
-#include "..\include\despot\solver\pomcp.h"
+#include "../include/despot/util/random.h"
+#include "../include/despot/solver/pomcp.h"
 
 #include "nxnGridGlobalActions.h"
 #include "Coordinate.h"
@@ -14,9 +15,6 @@ namespace despot
 static const int s_numMoves = 8;
 static const int s_lutDirections[s_numMoves][2] = { { 0, 1 }, { 0, -1 }, { 1, 0 }, { -1, 0 }, { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
 
-static bool s_IS_MOVE_FROM_ENEMY = true;
-/// string array for all actions (enum as idx)
-static std::vector<std::string> s_ACTION_STR;
 
 /// observation for loss and win (does not important)
 static int OB_LOSS = 0;
@@ -57,30 +55,29 @@ inline int Distance(int a, int b, int gridSize)
 * nxnGridGlobalActions Functions
 * =============================================================================*/
 
-nxnGridGlobalActions::nxnGridGlobalActions(int gridSize, int target, Self_Obj & self, std::vector<intVec> & objectsInitLoc, bool isMoveFromEnemyExist)
-: nxnGrid(gridSize, target, self, objectsInitLoc)
+nxnGridGlobalActions::nxnGridGlobalActions(int gridSize, int target, Self_Obj & self, std::vector<intVec> & objectsInitLoc, bool isMoveFromEnemyExist, const Settings & settings)
+: nxnGrid(gridSize, target, self, objectsInitLoc, settings)
+, m_actionStr()
+, m_isMoveFromEnemy(isMoveFromEnemyExist)
 {
 	// init vector for string of actions
-	s_ACTION_STR.clear();
-	s_ACTION_STR.emplace_back("Move To Target");
-	s_numBasicActions = NumBasicActions();
-	s_numEnemyRelatedActions = 1 + isMoveFromEnemyExist;
-	s_IS_MOVE_FROM_ENEMY = isMoveFromEnemyExist;
+	m_actionStr.emplace_back("Move To Target");
+	m_numBasicActions = NumBasicActions();
+	m_numEnemyRelatedActions = 1 + isMoveFromEnemyExist;
 }
 
 bool nxnGridGlobalActions::Step(State& s, double randomSelfAction, int action, OBS_TYPE lastObs, double& reward, OBS_TYPE& obs) const
 {
-	intVec state;
-	nxnGridState::IdxToState(&s, state);
+	nxnGridStateView state(s.state_id, *m_context);
 
-	// drawing more random numbers for each variable
-	double randomSelfObservation = Random::RANDOM.NextDouble();
+	// drawing more random numbers for each variable (derived from the scenario random number so step is deterministic)
+	double randomSelfObservation = ScenarioRandom(randomSelfAction, OBSERVATION_RANDOM);
 
-	std::vector<double> randomObjectMoves;
-	CreateRandomVec(randomObjectMoves, CountMovingObjects() - 1);
+	double randomObjectMoves[nxnGridStateView::MAX_OBJECTS];
+	CreateRandomVec(randomObjectMoves, CountMovingObjects() - 1, randomSelfAction, OBJECT_MOVES_RANDOM);
 	
-	std::vector<double> randomEnemiesAttacks;
-	CreateRandomVec(randomEnemiesAttacks, m_enemyVec.size());
+	double randomEnemiesAttacks[nxnGridStateView::MAX_OBJECTS];
+	CreateRandomVec(randomEnemiesAttacks, m_enemyVec.size(), randomSelfAction, ENEMIES_ATTACKS_RANDOM);
 
 	// run on all enemies and check if the robot was killed
 	for (int i = 0; i < m_enemyVec.size(); ++i)
@@ -151,7 +148,7 @@ bool nxnGridGlobalActions::Step(State& s, double randomSelfAction, int action, O
 	
 	//update state
 	nxnGridState& stateClass = static_cast<nxnGridState&>(s);
-	stateClass.UpdateState(state);
+	stateClass.UpdateState(state.Pack());
 	return false;
 }
 
@@ -162,7 +159,7 @@ int nxnGridGlobalActions::NumBasicActions() const
 
 int nxnGridGlobalActions::NumEnemyActions() const
 {
-	return 1 + s_IS_MOVE_FROM_ENEMY;
+	return 1 + m_isMoveFromEnemy;
 }
 
 int nxnGridGlobalActions::NumActions() const
@@ -174,37 +171,39 @@ int nxnGridGlobalActions::NumActions() const
 
 ValuedAction nxnGridGlobalActions::GetMinRewardAction() const
 {
-	return ValuedAction(rand() % NumActions(), -10.0);
+	// generator per thread (seeded from rand()) so concurrent search threads do not share a random state
+	static thread_local std::minstd_rand s_generator(rand());
+	return ValuedAction(s_generator() % NumActions(), -10.0);
 }
 
 void nxnGridGlobalActions::PrintAction(int action, std::ostream & out) const
 {
-	out << s_ACTION_STR[action] << std::endl;
+	out << m_actionStr[action] << std::endl;
 }
 
 void nxnGridGlobalActions::AddActionsToEnemy()
 {
 	int enemyNum = m_enemyVec.size();
-	s_ACTION_STR.push_back("Attack enemy #" + std::to_string(enemyNum));
-	if (s_IS_MOVE_FROM_ENEMY)
-		s_ACTION_STR.push_back("Move from enemy #" + std::to_string(enemyNum));
+	m_actionStr.push_back("Attack enemy #" + std::to_string(enemyNum));
+	if (m_isMoveFromEnemy)
+		m_actionStr.push_back("Move from enemy #" + std::to_string(enemyNum));
 }
 
 void nxnGridGlobalActions::AddActionsToShelter()
 {
 	// insert move to shelter after first action (move to target)
 	if (m_shelters.size() == 1)
-		s_ACTION_STR.insert(s_ACTION_STR.begin() + 1, "Move to shelter");
+		m_actionStr.insert(m_actionStr.begin() + 1, "Move to shelter");
 
-	s_numBasicActions = NumBasicActions();
+	m_numBasicActions = NumBasicActions();
 }
-bool nxnGridGlobalActions::MoveToTarget(intVec & state, double random) const
+bool nxnGridGlobalActions::MoveToTarget(nxnGridStateView & state, double random) const
 {
 	Coordinate target(m_targetIdx % m_gridSize, m_targetIdx / m_gridSize);
 	return MoveToLocation(state, target, random);
 }
 
-bool nxnGridGlobalActions::MoveToShelter(intVec & state, double random) const
+bool nxnGridGlobalActions::MoveToShelter(nxnGridStateView & state, double random) const
 {
 	// go to the nearest shelter
 	int shelterLoc = NearestShelter(state[0]);
@@ -218,22 +217,17 @@ bool nxnGridGlobalActions::MoveToShelter(intVec & state, double random) const
 	return true;
 }
 
-void nxnGridGlobalActions::Attack(intVec & state, int idxEnemy, double random, OBS_TYPE lastObs) const
+void nxnGridGlobalActions::Attack(nxnGridStateView & state, int idxEnemy, double random, OBS_TYPE lastObs) const
 {
-	intVec observedState;
-	nxnGridState::IdxToState(lastObs, observedState);
+	nxnGridStateView observedState(lastObs, *m_context);
 	
 	// if enemy was not observed do nothing, if enemy in range make attack o.w. move toward enemy
 	if (observedState[0] == observedState[idxEnemy])
 		return;
 	else if (m_self.GetAttack()->InRange(state[0], state[idxEnemy], m_gridSize))
 	{
-		intVec shelters(m_shelters.size());
-		for (size_t i = 0; i < m_shelters.size(); ++i)
-			shelters[i] = m_shelters[i].GetLocation().GetIdx(m_gridSize);
-
 		int attackLoc = observedState[idxEnemy];
-		m_self.AttackOnline(state[0], attackLoc, state, shelters, m_gridSize, random);
+		m_self.GetAttack()->AttackOnline(state[0], attackLoc, state.data(), state.size(), m_sheltersLocations, m_gridSize, random, m_context->m_selfAttackTable.get());
 	}
 	else
 	{
@@ -242,25 +236,24 @@ void nxnGridGlobalActions::Attack(intVec & state, int idxEnemy, double random, O
 	}
 }
 
-void nxnGridGlobalActions::MoveFromEnemy(intVec & state, int idxEnemy, double random, OBS_TYPE lastObs) const
+void nxnGridGlobalActions::MoveFromEnemy(nxnGridStateView & state, int idxEnemy, double random, OBS_TYPE lastObs) const
 {
 	// if according to probability the robot is moving and the enemy is not dead move toward enemy
 	if (random < m_self.GetSelfPMove())
 	{
-		intVec observedState; 
-		nxnGridState::IdxToState(lastObs, observedState);
+		nxnGridStateView observedState(lastObs, *m_context);
 		// if enemy unobserved do nothing
 		if (observedState[idxEnemy] != observedState[0])
 		{
 			Coordinate enemy(observedState[idxEnemy] % m_gridSize, observedState[idxEnemy] / m_gridSize);
-			state[0] = MoveFromLocation(state, enemy);
+			state[0] = MoveFrom(state, enemy.GetIdx(m_gridSize));
 		}
 	}
 }
 
-bool nxnGridGlobalActions::MoveToLocation(intVec & state, Coordinate & goTo, double random) const
+bool nxnGridGlobalActions::MoveToLocation(nxnGridStateView & state, Coordinate & goTo, double random) const
 {
-	int move = MoveToLocationIMP(state, goTo);
+	int move = MoveToward(state, goTo.GetIdx(m_gridSize));
 
 	random -= m_self.GetMovement().GetToward();
 	if (random <= 0)
@@ -269,85 +262,6 @@ bool nxnGridGlobalActions::MoveToLocation(intVec & state, Coordinate & goTo, dou
 	return move != state[0];
 }
 
-int nxnGridGlobalActions::MoveFromLocation(intVec & state, Coordinate & goFrom) const
-{
-	Coordinate self(state[0] % m_gridSize, state[0] / m_gridSize);
-
-	int maxLocation = state[0];
-	int maxDist = self.Distance(goFrom);
-
-	// run on all possible move locations and find the farthest point from goFrom
-	for (size_t i = 0; i < s_numMoves; ++i)
-	{
-		Coordinate move(state[0] % m_gridSize, state[0] / m_gridSize);
-		move.X() += s_lutDirections[i][0];
-		move.Y() += s_lutDirections[i][1];
-
-		// if move is not on grid continue for next move
-		if (move.X() < 0 | move.X() >= m_gridSize | move.Y() < 0 | move.Y() >= m_gridSize)
-			continue;
-
-		// if move is valid calculate distance
-		int currLocation = move.X() + move.Y() * m_gridSize;
-		if (ValidLocation(state, currLocation))
-		{
-			int currDist = goFrom.Distance(move);
-			if (currDist > maxDist)
-			{
-				maxLocation = currLocation;
-				maxDist = currDist;
-			}
-		}
-	}
-
-	return maxLocation;
-}
-
-int nxnGridGlobalActions::MoveToLocationIMP(intVec & state, Coordinate & goTo) const
-{
-	int selfLocation = state[0];
-	int goToLocation = goTo.X() + goTo.Y() * m_gridSize;
-	int move = selfLocation;
-
-	int xDiff = goTo.X() - selfLocation % m_gridSize;
-	int yDiff = goTo.Y() - selfLocation / m_gridSize;
-
-	int changeToInsertX = xDiff != 0 ? xDiff / Abs(xDiff) : 0;
-	int changeToInsertY = yDiff != 0 ? (yDiff / Abs(yDiff)) * m_gridSize : 0;
-
-	// insert to move the best valid option
-
-	// if the best move is valid return it
-	move += changeToInsertX + changeToInsertY;
-	if (ValidLocation(state, move))
-		return move;
-
-	// if the best move is not availabe compute the new best move and the second best move according to the distance between the available moves
-
-	int secondMove;
-	changeToInsertX += selfLocation;
-	changeToInsertY += selfLocation;
-	if (Distance(goToLocation, changeToInsertX, m_gridSize) > Distance(goToLocation, changeToInsertY, m_gridSize))
-	{
-		move = changeToInsertY;
-		secondMove = changeToInsertX;
-	}
-	else
-	{
-		move = changeToInsertX;
-		secondMove = changeToInsertY;
-	}
-
-	// return the best valid move
-	if (ValidLocation(state, move))
-		return move;
-	else if (ValidLocation(state, secondMove))
-		return secondMove;
-
-	// if any move wasn't succesful return self location as no move
-	return selfLocation;
-}
-
 int nxnGridGlobalActions::NearestShelter(int loc) const
 {
 	Coordinate location(loc % m_gridSize, loc / m_gridSize);
@@ -4,7 +4,7 @@
 #pragma once
 #include <string>
 
-#include "..\include\despot\core\pomdp.h"
+#include "../include/despot/core/pomdp.h"
 
 #include "nxnGrid.h"
 #include "Coordinate.h"
@@ -16,14 +16,14 @@ namespace despot
 * Global Actions class
 * =============================================================================*/
 /// the class is non thread safe. 
-/// the static members are specialized to one type of nxnGrid so only one problem can simultaneously run
+/// different instances are independent so each problem can run on its own thread
 class nxnGridGlobalActions : public nxnGrid
 {	
 public:
 	enum ACTION { MOVE_TO_TARGET, MOVE_TO_SHELTER};
 	enum ENEMY_ACTION { ATTACK, MOVE_FROM_ENEMY, NUM_ENEMY_ACTIONS };
 
-	explicit nxnGridGlobalActions(int gridSize, int traget, Self_Obj & self, std::vector<intVec> & objectsInitLoc, bool isMoveFromEnemyExist = true);
+	explicit nxnGridGlobalActions(int gridSize, int traget, Self_Obj & self, std::vector<intVec> & objectsInitLoc, bool isMoveFromEnemyExist = true, const Settings & settings = Settings());
 	~nxnGridGlobalActions() = default;
 	
 	// Functions for self use
@@ -45,18 +45,13 @@ private:
 	virtual void AddActionsToShelter() override;
 
 	// ACTIONS FUNCTION:
-	bool MoveToTarget(intVec & state, double random) const;
-	bool MoveToShelter(intVec & state, double random) const;
-	void Attack(intVec & state, int idxEnemy, double random, OBS_TYPE lastObs) const;
-	void MoveFromEnemy(intVec & state, int idxEnemy, double random, OBS_TYPE lastObs) const;
+	bool MoveToTarget(nxnGridStateView & state, double random) const;
+	bool MoveToShelter(nxnGridStateView & state, double random) const;
+	void Attack(nxnGridStateView & state, int idxEnemy, double random, OBS_TYPE lastObs) const;
+	void MoveFromEnemy(nxnGridStateView & state, int idxEnemy, double random, OBS_TYPE lastObs) const;
 
 	/// try move to goTo (depend on random number)
-	bool MoveToLocation(intVec & state, Coordinate & goTo, double random) const;
-	/// implementation of MoveToLocation
-	int MoveToLocationIMP(intVec & state, Coordinate & goTo) const;
-
-	/// return the farthest available location from goFrom
-	int MoveFromLocation(intVec & state, Coordinate & goFrom) const;
+	bool MoveToLocation(nxnGridStateView & state, Coordinate & goTo, double random) const;
 
 	/// return the nearest shelter location
 	int NearestShelter(int loc) const;
@@ -68,6 +63,10 @@ private:
 
 	/// return true if the action is enemy related action
 	virtual bool EnemyRelatedAction(int action) const override;
+
+	/// string array for all actions (enum as idx)
+	std::vector<std::string> m_actionStr;
+	bool m_isMoveFromEnemy;
 };
 
 } // end ns despot
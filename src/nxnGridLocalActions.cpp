@@ -1,7 +1,7 @@
 #include <string>
 #include <math.h>
 
-#include "..\include\despot\solver\pomcp.h"
+#include "../include/despot/solver/pomcp.h"
 #include "nxnGridLocalActions.h"
 #include "Coordinate.h"
 
@@ -12,11 +12,9 @@ namespace despot
 static const int s_numMoves = 8;
 static const int s_lutDirections[s_numMoves][2] = { { 0, 1 }, { 0, -1 }, { 1, 0 }, { -1, 0 }, { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
 
-/// string array for all actions (enum as idx)
-static std::vector<std::string> s_ACTION_STR(nxnGridLocalActions::NUM_BASIC_ACTIONS + 1);
-
-/// lut connecting coordinate change to move action
-static std::vector<std::pair<int, int>> s_ACTION_CHANGE(nxnGridLocalActions::NUM_BASIC_ACTIONS);
+/// lut connecting coordinate change to move action (enum as idx)
+static const std::pair<int, int> s_ACTION_CHANGE[nxnGridLocalActions::NUM_BASIC_ACTIONS] = { { 0, 0 }, { 0, -1 }, { 0, 1 }, { 1, 0 }, { -1, 0 }, 
+																							{ 1, -1 }, { -1, -1 }, { 1, 1 }, { -1, 1 } };
 
 /// observation for loss and win (does not important)
 static int OB_LOSS = 0;
@@ -57,51 +55,40 @@ inline int Distance(int a, int b, int gridSize)
 * nxnGridGlobalActions Functions
 * =============================================================================*/
 
-nxnGridLocalActions::nxnGridLocalActions(int gridSize, int target, Self_Obj & self, std::vector<intVec> & objectsInitLoc)
-: nxnGrid(gridSize, target, self, objectsInitLoc)
+nxnGridLocalActions::nxnGridLocalActions(int gridSize, int target, Self_Obj & self, std::vector<intVec> & objectsInitLoc, const Settings & settings)
+: nxnGrid(gridSize, target, self, objectsInitLoc, settings)
+, m_actionStr(NUM_BASIC_ACTIONS + 1)
 {
 	// init vector for string of actions
-	s_ACTION_STR[STAY] = "Stay";
-
-	s_ACTION_STR[NORTH] = "North";
-	s_ACTION_STR[SOUTH] = "South";
-	s_ACTION_STR[WEST] = "West";
-	s_ACTION_STR[EAST] = "East";
-
-	s_ACTION_STR[NORTH_WEST] = "North-West";
-	s_ACTION_STR[NORTH_EAST] = "North-East";
-	s_ACTION_STR[SOUTH_WEST] = "South-West";
-	s_ACTION_STR[SOUTH_EAST] = "South-East";
-
-	s_ACTION_CHANGE[NORTH] = std::make_pair(0, -1);
-	s_ACTION_CHANGE[SOUTH] = std::make_pair(0, 1);
-	s_ACTION_CHANGE[WEST] = std::make_pair(-1, 0);
-	s_ACTION_CHANGE[EAST] = std::make_pair(1, 0);
-
-	s_ACTION_CHANGE[NORTH_WEST] = std::make_pair(-1, -1);
-	s_ACTION_CHANGE[NORTH_EAST] = std::make_pair(1, -1);
-	s_ACTION_CHANGE[SOUTH_WEST] = std::make_pair(-1, 1);
-	s_ACTION_CHANGE[SOUTH_EAST] = std::make_pair(1, 1);
-
-	s_numBasicActions = NUM_BASIC_ACTIONS;
-	s_numEnemyRelatedActions = 1;
+	m_actionStr[STAY] = "Stay";
+
+	m_actionStr[NORTH] = "North";
+	m_actionStr[SOUTH] = "South";
+	m_actionStr[WEST] = "West";
+	m_actionStr[EAST] = "East";
+
+	m_actionStr[NORTH_WEST] = "North-West";
+	m_actionStr[NORTH_EAST] = "North-East";
+	m_actionStr[SOUTH_WEST] = "South-West";
+	m_actionStr[SOUTH_EAST] = "South-East";
+
+	m_numBasicActions = NUM_BASIC_ACTIONS;
+	m_numEnemyRelatedActions = 1;
 }
 
 bool nxnGridLocalActions::Step(State& s, double randomSelfAction, int a, OBS_TYPE lastObs, double& reward, OBS_TYPE& obs) const
 {
-	intVec state;
-	nxnGridState::IdxToState(&s, state);
+	nxnGridStateView state(s.state_id, *m_context);
 	enum ACTION action = static_cast<enum ACTION>(a);
 
-	// drawing more random numbers for each variable
-	double randomSelfObservation = rand();
-	randomSelfObservation /=  RAND_MAX;
+	// drawing more random numbers for each variable (derived from the scenario random number so step is deterministic)
+	double randomSelfObservation = ScenarioRandom(randomSelfAction, OBSERVATION_RANDOM);
 
-	std::vector<double> randomObjectMoves;
-	CreateRandomVec(randomObjectMoves, CountMovingObjects() - 1);
+	double randomObjectMoves[nxnGridStateView::MAX_OBJECTS];
+	CreateRandomVec(randomObjectMoves, CountMovingObjects() - 1, randomSelfAction, OBJECT_MOVES_RANDOM);
 	
-	std::vector<double> randomEnemiesAttacks;
-	CreateRandomVec(randomEnemiesAttacks, m_enemyVec.size());
+	double randomEnemiesAttacks[nxnGridStateView::MAX_OBJECTS];
+	CreateRandomVec(randomEnemiesAttacks, m_enemyVec.size(), randomSelfAction, ENEMIES_ATTACKS_RANDOM);
 
 	// run on all enemies and check if the robot was killed
 	for (int i = 0; i < m_enemyVec.size(); ++i)
@@ -134,7 +121,7 @@ bool nxnGridLocalActions::Step(State& s, double randomSelfAction, int a, OBS_TYP
 			int enemyIdx = action - NUM_BASIC_ACTIONS;
 			if (state[enemyIdx] != m_gridSize * m_gridSize)
 			{
-				Attack(state, enemyIdx, randomSelfAction, obs);
+				Attack(state, enemyIdx, randomSelfAction, lastObs);
 				for (size_t i = 0; i < m_nonInvolvedVec.size(); ++i)
 				{
 					if (state[i + 1 + m_enemyVec.size()] == m_gridSize * m_gridSize)
@@ -154,7 +141,7 @@ bool nxnGridLocalActions::Step(State& s, double randomSelfAction, int a, OBS_TYP
 	obs = FindObservation(state, randomSelfObservation);
 	//update state
 	nxnGridState& stateClass = static_cast<nxnGridState&>(s);
-	stateClass.UpdateState(state);
+	stateClass.UpdateState(state.Pack());
 	return false;
 }
 
@@ -165,19 +152,19 @@ int nxnGridLocalActions::NumActions() const
 };
 void nxnGridLocalActions::PrintAction(int action, std::ostream & out) const
 {
-	out << s_ACTION_STR[action] << std::endl;
+	out << m_actionStr[action] << std::endl;
 }
 
 void nxnGridLocalActions::AddActionsToEnemy()
 {
-	s_ACTION_STR.push_back("Attack enemy #" + std::to_string(m_enemyVec.size()));
+	m_actionStr.push_back("Attack enemy #" + std::to_string(m_enemyVec.size()));
 }
 
 void nxnGridLocalActions::AddActionsToShelter()
 {
 }
 
-bool nxnGridLocalActions::MakeMove(intVec & state, double random, ACTION action) const
+bool nxnGridLocalActions::MakeMove(nxnGridStateView & state, double random, ACTION action) const
 {
 	int x = state[0] % m_gridSize + s_ACTION_CHANGE[action].first;
 	int y = state[0] / m_gridSize + s_ACTION_CHANGE[action].second;
@@ -190,22 +177,17 @@ bool nxnGridLocalActions::MakeMove(intVec & state, double random, ACTION action)
 
 	return false;
 }
-void nxnGridLocalActions::Attack(intVec & state, int enemyIdx, double random, OBS_TYPE lastObs) const
+void nxnGridLocalActions::Attack(nxnGridStateView & state, int enemyIdx, double random, OBS_TYPE lastObs) const
 {
-	intVec observedState; 
-	nxnGridState::IdxToState(lastObs, observedState);
+	nxnGridStateView observedState(lastObs, *m_context);
 	
 	// if enemy is not observed do nothing
 	if (observedState[enemyIdx] == observedState[0])
 		return;
 	if (m_self.GetObservation()->InRange(state[0], observedState[enemyIdx], m_gridSize))
 	{
-		intVec shelters(m_shelters.size());
-		for (size_t i = 0; i < m_shelters.size(); ++i)
-			shelters[i] = m_shelters[i].GetLocation().GetIdx(m_gridSize);
-
 		int attackLoc = observedState[enemyIdx];
-		m_self.AttackOnline(state[0], attackLoc, state, shelters, m_gridSize, random);
+		m_self.GetAttack()->AttackOnline(state[0], attackLoc, state.data(), state.size(), m_sheltersLocations, m_gridSize, random, m_context->m_selfAttackTable.get());
 	}
 	else
 	{
@@ -214,60 +196,15 @@ void nxnGridLocalActions::Attack(intVec & state, int enemyIdx, double random, OB
 	}
 }
 
-void nxnGridLocalActions::MoveToLocation(intVec & state, Coordinate & goTo, double random) const
+void nxnGridLocalActions::MoveToLocation(nxnGridStateView & state, Coordinate & goTo, double random) const
 {
-	int move = MoveToLocationIMP(state, goTo);
+	int move = MoveToward(state, goTo.GetIdx(m_gridSize));
 
 	random -= m_self.GetMovement().GetToward();
 	if (random <= 0)
 		state[0] = move;	
 }
 
-int nxnGridLocalActions::MoveToLocationIMP(intVec & state, Coordinate & goTo) const
-{
-	int selfLocation = state[0];
-	int goToLocation = goTo.X() + goTo.Y() * m_gridSize;
-	int move = selfLocation;
-
-	int xDiff = goTo.X() - selfLocation % m_gridSize;
-	int yDiff = goTo.Y() - selfLocation / m_gridSize;
-
-	int changeToInsertX = xDiff != 0 ? xDiff / Abs(xDiff) : 0;
-	int changeToInsertY = yDiff != 0 ? (yDiff / Abs(yDiff)) * m_gridSize : 0;
-
-	// insert to move the best valid option
-
-	// if the best move is valid return it
-	move += changeToInsertX + changeToInsertY;
-	if (ValidLocation(state, move))
-		return move;
-
-	// if the best move is not availabe compute the new best move and the second best move according to the distance between the available moves
-
-	int secondMove;
-	changeToInsertX += selfLocation;
-	changeToInsertY += selfLocation;
-	if (Distance(goToLocation, changeToInsertX, m_gridSize) > Distance(goToLocation, changeToInsertY, m_gridSize))
-	{
-		move = changeToInsertY;
-		secondMove = changeToInsertX;
-	}
-	else
-	{
-		move = changeToInsertX;
-		secondMove = changeToInsertY;
-	}
-
-	// return the best valid move
-	if (ValidLocation(state, move))
-		return move;
-	else if (ValidLocation(state, secondMove))
-		return secondMove;
-
-	// if any move wasn't succesful return self location as no move
-	return selfLocation;
-}
-
 bool nxnGridLocalActions::EnemyRelatedAction(int action) const
 {
 	return action >= NUM_BASIC_ACTIONS;
@@ -4,7 +4,7 @@
 #pragma once
 #include <string>
 
-#include "..\include\despot\core\pomdp.h"
+#include "../include/despot/core/pomdp.h"
 
 #include "nxnGrid.h"
 #include "Self_Obj.h"
@@ -17,14 +17,14 @@ namespace despot
 * Global Actions class
 * =============================================================================*/
 /// the class is non thread safe. 
-/// the static members are specialized to one type of nxnGrid so only one problem can simultaneously run
+/// different instances are independent so each problem can run on its own thread
 class nxnGridLocalActions : public nxnGrid
 {	
 public:
 	///	enum of all actions
 	enum ACTION { STAY, NORTH, SOUTH, EAST, WEST, NORTH_EAST, NORTH_WEST, SOUTH_EAST, SOUTH_WEST, NUM_BASIC_ACTIONS };
 
-	explicit nxnGridLocalActions(int gridSize, int traget, Self_Obj & self, std::vector<intVec> & objectsInitLoc);
+	explicit nxnGridLocalActions(int gridSize, int traget, Self_Obj & self, std::vector<intVec> & objectsInitLoc, const Settings & settings = Settings());
 	~nxnGridLocalActions() = default;
 	
 	// Functions for self use
@@ -46,16 +46,17 @@ private:
 
 	// ACTIONS FUNCTION:
 	/// make move and update state return true if the move is valid (regardless if the move was successful or not) 
-	bool MakeMove(intVec & state, double random, ACTION action) const;
+	bool MakeMove(nxnGridStateView & state, double random, ACTION action) const;
 	/// make attack and update state
-	void Attack(intVec & state, int enemyIdx, double random, OBS_TYPE lastObs) const;
+	void Attack(nxnGridStateView & state, int enemyIdx, double random, OBS_TYPE lastObs) const;
 
 	/// try move to goTo (depend on random number)
-	void MoveToLocation(intVec & state, Coordinate & goTo, double random) const;
-	/// implementation of MoveToLocation
-	int MoveToLocationIMP(intVec & state, Coordinate & goTo) const;
+	void MoveToLocation(nxnGridStateView & state, Coordinate & goTo, double random) const;
 
 	virtual bool EnemyRelatedAction(int action) const override;
+
+	/// string array for all actions (enum as idx)
+	std::vector<std::string> m_actionStr;
 };
 
 } // end ns despot
@@ -0,0 +1,300 @@
+#include <iostream>
+#include <random>
+#include <vector>
+
+/// models available
+#include "nxnGridGlobalActions.h"
+#include "nxnGridToolModel.h"
+
+// properties of objects
+#include "Coordinate.h"
+
+using namespace despot;
+using intVec = std::vector<int>;
+
+/// randomized check that the table moves of nxnGrid (MoveToward, MoveFrom, GetCloser and FindObjMove) give the same location as
+/// the moves calculated on coordinates. goals include locations below the grid (observed dead enemy) where the coordinate move may
+/// leave the grid. in that case the table move should be the coordinate move when only locations in grid are valid
+
+static const int s_NUM_CHECKS = 200000;
+
+/// exposes the move functions of nxnGrid
+class MoveTestModel : public nxnGridGlobalActions
+{
+public:
+	using nxnGridGlobalActions::nxnGridGlobalActions;
+	using nxnGrid::MoveToward;
+	using nxnGrid::MoveFrom;
+	using nxnGrid::GetCloser;
+	using nxnGrid::FindObjMove;
+};
+
+/* =============================================================================
+* coordinate moves (the moves calculated per call before the move tables)
+* =============================================================================*/
+
+inline int Abs(int x)
+{
+	return x * (x >= 0) - x * (x < 0);
+}
+
+inline int Distance(int a, int b, int gridSize)
+{
+	int xDiff = a % gridSize - b % gridSize;
+	int yDiff = a / gridSize - b / gridSize;
+	return xDiff * xDiff + yDiff * yDiff;
+}
+
+bool ValidLocation(const intVec & state, int location, int gridSize, bool inGridOnly)
+{
+	if (inGridOnly && location >= gridSize * gridSize)
+		return false;
+
+	for (int v : state)
+	{
+		if (location == v)
+			return false;
+	}
+
+	return true;
+}
+
+int MoveToLocation(const intVec & state, Coordinate & goTo, int gridSize, bool inGridOnly)
+{
+	int selfLocation = state[0];
+	int goToLocation = goTo.X() + goTo.Y() * gridSize;
+	int move = selfLocation;
+
+	int xDiff = goTo.X() - selfLocation % gridSize;
+	int yDiff = goTo.Y() - selfLocation / gridSize;
+
+	int changeToInsertX = xDiff != 0 ? xDiff / Abs(xDiff) : 0;
+	int changeToInsertY = yDiff != 0 ? (yDiff / Abs(yDiff)) * gridSize : 0;
+
+	move += changeToInsertX + changeToInsertY;
+	if (ValidLocation(state, move, gridSize, inGridOnly))
+		return move;
+
+	int secondMove;
+	changeToInsertX += selfLocation;
+	changeToInsertY += selfLocation;
+	if (Distance(goToLocation, changeToInsertX, gridSize) > Distance(goToLocation, changeToInsertY, gridSize))
+	{
+		move = changeToInsertY;
+		secondMove = changeToInsertX;
+	}
+	else
+	{
+		move = changeToInsertX;
+		secondMove = changeToInsertY;
+	}
+
+	if (ValidLocation(state, move, gridSize, inGridOnly))
+		return move;
+	else if (ValidLocation(state, secondMove, gridSize, inGridOnly))
+		return secondMove;
+
+	return selfLocation;
+}
+
+int MoveFromLocation(const intVec & state, Coordinate & goFrom, int gridSize)
+{
+	static const int directions[8][2] = { { 0,1 },{ 0,-1 },{ 1,0 },{ -1,0 },{ 1,1 },{ 1,-1 },{ -1,1 },{ -1,-1 } };
+	Coordinate self(state[0] % gridSize, state[0] / gridSize);
+
+	int maxLocation = state[0];
+	int maxDist = self.Distance(goFrom);
+	for (int i = 0; i < 8; ++i)
+	{
+		Coordinate move(state[0] % gridSize + directions[i][0], state[0] / gridSize + directions[i][1]);
+		if (move.X() < 0 | move.X() >= gridSize | move.Y() < 0 | move.Y() >= gridSize)
+			continue;
+
+		int currLocation = move.X() + move.Y() * gridSize;
+		if (ValidLocation(state, currLocation, gridSize, false))
+		{
+			int currDist = goFrom.Distance(move);
+			if (currDist > maxDist)
+			{
+				maxLocation = currLocation;
+				maxDist = currDist;
+			}
+		}
+	}
+
+	return maxLocation;
+}
+
+int GetCloser(const intVec & state, int objIdx, int gridSize)
+{
+	int xDiff = state[0] % gridSize - state[objIdx] % gridSize;
+	int yDiff = state[0] / gridSize - state[objIdx] / gridSize;
+
+	int changeToInsertX = xDiff != 0 ? xDiff / Abs(xDiff) : 0;
+	int changeToInsertY = yDiff != 0 ? (yDiff / Abs(yDiff)) * gridSize : 0;
+
+	int move = state[objIdx];
+	if (ValidLocation(state, move + changeToInsertX, gridSize, false))
+		move += changeToInsertX;
+	if (ValidLocation(state, move + changeToInsertY, gridSize, false))
+		move += changeToInsertY;
+
+	return move;
+}
+
+int FindObjMove(int currLocation, double random, int gridSize)
+{
+	int x = currLocation % gridSize;
+	int y = currLocation / gridSize;
+	if (random > 0.5)
+	{
+		random = (random - 0.5) * 2;
+		if (random > 0.5)
+		{
+			++x;
+			if (random > 0.75)
+				++y;
+			else
+				--y;
+		}
+		else
+		{
+			--x;
+			if (random > 0.25)
+				++y;
+			else
+				--y;
+		}
+	}
+	else
+	{
+		random *= 2;
+		if (random > 0.5)
+		{
+			if (random > 0.75)
+				++y;
+			else
+				--y;
+		}
+		else
+		{
+			if (random > 0.25)
+				++x;
+			else
+				--x;
+		}
+	}
+
+	if ((x >= 0) & (x < gridSize) & (y >= 0) & (y < gridSize))
+		return x + y * gridSize;
+
+	return currLocation;
+}
+
+/* =============================================================================
+* check
+* =============================================================================*/
+
+/// return number of moves with different results for a grid size
+int CheckGrid(int gridSize, std::mt19937 & generator);
+
+int main(int argc, char* argv[])
+{
+	std::mt19937 generator(5);
+	int numDiff = 0;
+	for (int gridSize : { 5, 10, 20 })
+		numDiff += CheckGrid(gridSize, generator);
+
+	std::cout << (numDiff == 0 ? "move equivalence passed\n" : "move equivalence failed\n");
+	return numDiff == 0 ? 0 : 1;
+}
+
+int CheckGrid(int gridSize, std::mt19937 & generator)
+{
+	int numLocations = gridSize * gridSize;
+	int deadLoc = numLocations;
+
+	// the tool model with the move functions exposed
+	nxnGridToolModel::Objects objects(nxnGridToolModel::AttackRange(gridSize));
+	std::vector<intVec> objVec = nxnGridToolModel::InitLocations(gridSize);
+	Self_Obj self = nxnGridToolModel::CreateSelf(objects);
+	MoveTestModel model(gridSize, numLocations - 1, self, objVec);
+	nxnGridToolModel::AddObjects(model, objects);
+
+	const nxnGridContext & context = *model.GetContext();
+	std::uniform_real_distribution<double> random(0.0, 1.0);
+	int numObjects = model.CountMovingObjects();
+
+	int numDiff = 0;
+	int numLeftGrid = 0;
+	for (int i = 0; i < s_NUM_CHECKS; ++i)
+	{
+		// self in grid, other objects in different locations (mostly near self) or dead
+		intVec state;
+		while (state.size() < numObjects)
+		{
+			int loc = generator() % numLocations;
+			if (state.size() > 0 && random(generator) < 0.2)
+				loc = deadLoc;
+			else if (state.size() > 0 && random(generator) < 0.7)
+			{
+				int x = state[0] % gridSize + static_cast<int>(generator() % 5) - 2;
+				int y = state[0] / gridSize + static_cast<int>(generator() % 5) - 2;
+				loc = (x >= 0 & x < gridSize & y >= 0 & y < gridSize) ? x + y * gridSize : deadLoc;
+			}
+
+			bool repeats = false;
+			for (int l : state)
+				repeats |= (l == loc) & (loc != deadLoc);
+			if (!repeats)
+				state.emplace_back(loc);
+		}
+
+		// goal is the location of an object or any location in grid or below it
+		int goal = random(generator) < 0.5 ? state[generator() % numObjects] : generator() % (numLocations + gridSize);
+		Coordinate goalCoordinate(goal % gridSize, goal / gridSize);
+		nxnGridStateView view(state, context);
+
+		int toward = model.MoveToward(view, goal);
+		int expectedToward = MoveToLocation(state, goalCoordinate, gridSize, false);
+		if (expectedToward >= numLocations)
+		{
+			++numLeftGrid;
+			expectedToward = MoveToLocation(state, goalCoordinate, gridSize, true);
+		}
+
+		int from = model.MoveFrom(view, goal);
+		int expectedFrom = MoveFromLocation(state, goalCoordinate, gridSize);
+
+		int objIdx = 1 + generator() % (numObjects - 1);
+		int closer = state[objIdx];
+		if (state[objIdx] != deadLoc)
+		{
+			nxnGridStateView closerView(state, context);
+			model.GetCloser(closerView, objIdx);
+			closer = closerView[objIdx];
+		}
+		int expectedCloser = state[objIdx] != deadLoc ? GetCloser(state, objIdx, gridSize) : state[objIdx];
+
+		double moveRandom = random(generator);
+		int objMove = model.FindObjMove(state[0], moveRandom);
+		int expectedObjMove = FindObjMove(state[0], moveRandom, gridSize);
+
+		if (toward != expectedToward || from != expectedFrom || closer != expectedCloser || objMove != expectedObjMove)
+		{
+			if (numDiff < 10)
+			{
+				std::cout << "grid " << gridSize << ": goal " << goal << " state (";
+				for (int l : state)
+					std::cout << l << ", ";
+				std::cout << ") toward " << toward << "/" << expectedToward << " from " << from << "/" << expectedFrom << " closer (obj " << objIdx << ") "
+					<< closer << "/" << expectedCloser << " obj move " << objMove << "/" << expectedObjMove << "\n";
+			}
+			++numDiff;
+		}
+	}
+
+	std::cout << "grid " << gridSize << ": " << numDiff << " different moves out of " << s_NUM_CHECKS << " (" << numLeftGrid
+		<< " coordinate moves toward goal below the grid left the grid)\n";
+	return numDiff;
+}
@@ -1,11 +1,15 @@
 #include "nxnGridOffline.h"
+#include "PointBasedSolver.h"
+#include "PomdpWriter.h"
 
 #include <iostream>		// cout
 #include <string>		// string
 #include <algorithm>	// algorithms
 #include <fstream>      // std::ofstream
-#include <sstream>		// ostringstream
-#include <iomanip>		// set_percision
+#include <unordered_map>	// unordered_map
+#include <thread>		// thread
+#include <mutex>		// mutex
+#include <condition_variable>	// condition_variable
 
 
 inline int Distance(int a, int b, int gridSize)
@@ -19,6 +23,10 @@ inline int Distance(int a, int b, int gridSize)
 static const std::string s_WinState = "Win";
 static const std::string s_LossState = "Loss";
 
+/// reward for arriving to win and loss states
+static const int s_REWARD_WIN = 50;
+static const int s_REWARD_LOSS = -100;
+
 /// value in move states for non-valid move
 static const int NVALID_MOVE = -1;
 /// all directions which are also all possible moves
@@ -36,7 +44,40 @@ static const int s_lutSecondSquare[s_numPixelsSecondSquare][2] = { { 0, 2 }, { 0
 /// number of moves of an object from a specific location (stay, num moves, moving toward robot)
 static const int s_NUM_OPTIONS_MOVE = s_NUM_DIRECTIONS + 2;
 
-double nxnGridOffline::s_pLeftProbability = 1.0;
+thread_local double nxnGridOffline::s_pLeftProbability = 1.0;
+
+struct nxnGridOffline::SparseBuilder
+{
+	const nxnGridOffline * m_model;
+	int m_winIdx;
+	int m_lossIdx;
+	std::vector<std::string> m_actionNames;
+	/// transitions of the current state for each action
+	std::vector<SparsePomdp::row_t> m_rows;
+
+	int ActionIdx(const std::string & action) const
+	{
+		auto itr = std::find(m_actionNames.begin(), m_actionNames.end(), action);
+		if (itr == m_actionNames.end())
+		{
+			std::cerr << "unknown action " << action << " in sparse pomdp\n";
+			exit(1);
+		}
+		return itr - m_actionNames.begin();
+	}
+
+	int StateIdx(const intVec & state) const
+	{
+		return m_model->State2StateCount(state);
+	}
+
+	void AddTransitions(const std::string & action, const mapProb & pMap)
+	{
+		SparsePomdp::row_t & row = m_rows[ActionIdx(action)];
+		for (auto & v : pMap)
+			row[StateIdx(v.first)] += v.second;
+	}
+};
 
 inline int Abs(int x)
 {
@@ -73,6 +114,7 @@ nxnGridOffline::nxnGridOffline(int gridSize, int targetIdx, Self_Obj& self, bool
 	, m_nonInvolvedVec()
 	, m_shelterVec()
 {
+	CountCompletions();
 }
 
 
@@ -84,11 +126,13 @@ void nxnGridOffline::UpdateSelf(Self_Obj && obj)
 void nxnGridOffline::AddObj(Attack_Obj&& obj)
 {
 	m_enemyVec.emplace_back(std::forward<Attack_Obj>(obj));
+	CountCompletions();
 }
 
 void nxnGridOffline::AddObj(Movable_Obj&& obj)
 {
 	m_nonInvolvedVec.emplace_back(std::forward<Movable_Obj>(obj));
+	CountCompletions();
 }
 
 void nxnGridOffline::AddObj(ObjInGrid&& obj)
@@ -125,14 +169,13 @@ void nxnGridOffline::SetTarget(int idx)
 void nxnGridOffline::SetGridSize(int gridSize)
 {
 	m_gridSize = gridSize;
+	CountCompletions();
 }
 
 long nxnGridOffline::StateCount2StateIdx(long stateCount) const
 {
-	intVec state(CountMovableObj());
 	// add moving objects to state
-	long add1ToCount = stateCount + 1;
-	FindStateCount(state, add1ToCount, 0);
+	intVec state(StateCount2State(stateCount));
 	
 	// insert shelter location to state
 	if (m_shelterVec.size() > 0)
@@ -144,34 +187,102 @@ long nxnGridOffline::StateCount2StateIdx(long stateCount) const
 	return State2Idx(state, m_gridSize);
 }
 
-void nxnGridOffline::FindStateCount(intVec & state, long & count, int currIdx) const
+long nxnGridOffline::CountStates() const
 {
-	// stopping condition when finish running on all objects
-	if (state.size() == currIdx)
+	return m_numCompletions[0];
+}
+
+long nxnGridOffline::State2StateCount(const intVec & state) const
+{
+	int numObj = CountMovableObj();
+	int numLocations = m_gridSize * m_gridSize;
+	long stateCount = 0;
+	int numAlive = 0;
+	for (int i = 0; i < numObj; ++i)
 	{
-		--count;
+		long nextCompletions = m_numCompletions[(i + 1) * (numObj + 1) + numAlive + 1];
+		if (state[i] == numLocations)
+		{
+			// dead is after all the locations
+			stateCount += (numLocations - numAlive) * nextCompletions;
+		}
+		else
+		{
+			// the location count is the location minus the previous objects in lower locations
+			int locationCount = state[i];
+			for (int j = 0; j < i; ++j)
+				locationCount -= state[j] < state[i];
+
+			stateCount += locationCount * nextCompletions;
+			++numAlive;
+		}
 	}
-	else
+
+	return stateCount;
+}
+
+nxnGridOffline::intVec nxnGridOffline::StateCount2State(long stateCount) const
+{
+	int numObj = CountMovableObj();
+	int numLocations = m_gridSize * m_gridSize;
+	intVec state(numObj);
+	int numAlive = 0;
+	for (int i = 0; i < numObj; ++i)
 	{
-		// run on all possible states (without repetitions)
-		for (int i = 0; i < m_gridSize * m_gridSize & count != 0; ++i)
+		long nextCompletions = m_numCompletions[(i + 1) * (numObj + 1) + numAlive + 1];
+		long aliveCompletions = (numLocations - numAlive) * nextCompletions;
+		if (stateCount >= aliveCompletions)
 		{
-			state[currIdx] = i;
-			if (NoRepeats(state, currIdx))
+			state[i] = numLocations;
+			stateCount -= aliveCompletions;
+		}
+		else
+		{
+			// the location is the location count advanced over the locations taken by previous objects (in ascending order)
+			int location = stateCount / nextCompletions;
+			stateCount %= nextCompletions;
+
+			intVec taken;
+			for (int j = 0; j < i; ++j)
 			{
-				FindStateCount(state, count, currIdx + 1);
+				if (state[j] != numLocations)
+					taken.emplace_back(state[j]);
 			}
+			std::sort(taken.begin(), taken.end());
+			for (auto loc : taken)
+				location += loc <= location;
+
+			state[i] = location;
+			++numAlive;
 		}
+	}
+
+	return state;
+}
+
+void nxnGridOffline::CountCompletions()
+{
+	int numObj = CountMovableObj();
+	int numLocations = m_gridSize * m_gridSize;
+
+	// N(i, alive) = (numLocations - alive) * N(i + 1, alive + 1) + isEnemy(i) * N(i + 1, alive). N(numObj, alive) = 1
+	m_numCompletions.assign((numObj + 1) * (numObj + 1), 0);
+	for (int alive = 0; alive <= numObj; ++alive)
+		m_numCompletions[numObj * (numObj + 1) + alive] = 1;
 
-		if (IsEnemy(currIdx) & count != 0)
+	for (int i = numObj - 1; i >= 0; --i)
+	{
+		for (int alive = 0; alive <= i; ++alive)
 		{
-			state[currIdx] = m_gridSize * m_gridSize;
-			FindStateCount(state, count, currIdx + 1);
+			long & n = m_numCompletions[i * (numObj + 1) + alive];
+			n = (numLocations - alive) * m_numCompletions[(i + 1) * (numObj + 1) + alive + 1];
+			if (IsEnemy(i))
+				n += m_numCompletions[(i + 1) * (numObj + 1) + alive];
 		}
 	}
 }
 
-long nxnGridOffline::State2Idx(intVec & state, int gridSize)
+long nxnGridOffline::State2Idx(const intVec & state, int gridSize)
 {
 	long idx = 0;
 	// add 1 for num states for dead objects
@@ -186,7 +297,7 @@ long nxnGridOffline::State2Idx(intVec & state, int gridSize)
 	return idx;
 }
 
-nxnGridOffline::intVec nxnGridOffline::Idx2State(long stateIdx)
+nxnGridOffline::intVec nxnGridOffline::Idx2State(long stateIdx) const
 {
 	intVec state(CountMovableObj());
 	int numStates = m_gridSize * m_gridSize + 1;
@@ -206,33 +317,99 @@ nxnGridOffline::intVec nxnGridOffline::Idx2State(long stateIdx)
 
 void nxnGridOffline::ObservationsAndRewards(FILE * fptr)
 {
-	std::string buffer;
+	PomdpWriter buffer(fptr);
 	// calculate observations
 	CalcObs(buffer);
 	// add rewards
 	buffer += "\n\nR: * : * : * : * 0.0";
-	buffer += "\nR: * : * : " + s_WinState + " : * 50";
-	buffer += "\nR: * : * : " + s_LossState + " : * -100\n";
+	buffer += "\nR: * : * : " + s_WinState + " : * " + std::to_string(s_REWARD_WIN);
+	buffer += "\nR: * : * : " + s_LossState + " : * " + std::to_string(s_REWARD_LOSS) + "\n";
 	buffer += "\nR: * : " + s_WinState + " : " + s_WinState + " : * 0.0";
 	buffer += "\nR: * : " + s_LossState + " : " + s_LossState + " : * 0.0";
-	// save to file 
-	auto err = fputs(buffer.c_str(), fptr);
-	if (err < 0) { std::cerr << "Error Writing to file\n"; return; }
 }
 
-void nxnGridOffline::CalcStatesAndObs(const char * type, std::string& buffer)
+void nxnGridOffline::CalcStatesAndObs(const char * type, PomdpWriter & buffer)
 {
-	intVec state(CountMovableObj());
-	CalcS_ORec(state, 0, type, buffer);
+	ForEachSelfLocation(buffer, [this, type](intVec & state, PomdpWriter & chunk) { CalcS_ORec(state, 1, type, chunk); });
+}
+
+void nxnGridOffline::ForEachSelfLocation(PomdpWriter & buffer, const std::function<void(intVec & state, PomdpWriter & chunk)> & func) const
+{
+	int numLocations = m_gridSize * m_gridSize;
+	int numThreads = m_numThreads > 0 ? m_numThreads : std::max(1u, std::thread::hardware_concurrency());
+	numThreads = std::min(numThreads, numLocations);
+	// workers don't run more than window chunks ahead of the chunk inserted to buffer (to bound memory)
+	int window = 2 * numThreads;
+
+	std::vector<std::string> chunks(numLocations);
+	std::vector<bool> isReady(numLocations, false);
+	int next = 0;
+	int inserted = 0;
+	std::mutex mtx;
+	std::condition_variable cv;
+
+	auto worker = [&]()
+	{
+		intVec state(CountMovableObj());
+		std::unique_lock<std::mutex> lock(mtx);
+		while (true)
+		{
+			cv.wait(lock, [&] { return next >= numLocations || next < inserted + window; });
+			if (next >= numLocations)
+				return;
+
+			int location = next++;
+			lock.unlock();
+			{
+				state[0] = location;
+				PomdpWriter chunk(chunks[location]);
+				func(state, chunk);
+			}
+			lock.lock();
+			isReady[location] = true;
+			cv.notify_all();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < numThreads; ++t)
+		threads.emplace_back(worker);
+
+	// insert chunks to buffer in the order of self location
+	while (inserted < numLocations)
+	{
+		std::unique_lock<std::mutex> lock(mtx);
+		cv.wait(lock, [&] { return isReady[inserted]; });
+		lock.unlock();
+
+		buffer.Append(chunks[inserted].data(), chunks[inserted].size());
+		std::string().swap(chunks[inserted]);
+
+		lock.lock();
+		++inserted;
+		cv.notify_all();
+	}
+
+	for (auto & t : threads)
+		t.join();
+}
+
+bool nxnGridOffline::SaveInSparseFormat(const std::string & fName)
+{
+	SparsePomdp pomdp;
+	std::vector<long> lutKeys;
+	BuildSparsePomdp(pomdp, lutKeys);
+	return pomdp.Write(fName, lutKeys);
 }
 
-void nxnGridOffline::CalcS_ORec(intVec& state, int currIdx, const char * type, std::string & buffer)
+void nxnGridOffline::CalcS_ORec(intVec& state, int currIdx, const char * type, PomdpWriter & buffer)
 {
 	// stopping condition when finish running on all objects
 	if (state.size() == currIdx)
 	{
 		// insert state to buffer
-		buffer += GetStringState(state, type) + " ";
+		AddStringState(buffer, state, type);
+		buffer += ' ';
 	}
 	else
 	{
@@ -339,7 +516,7 @@ bool nxnGridOffline::NoRepeats(intVec& state, int idx) const
 	return true;
 }
 
-void nxnGridOffline::CalcStartState(std::string& buffer)
+void nxnGridOffline::CalcStartState(PomdpWriter & buffer)
 {
 	intVec state(CountMovableObj());
 
@@ -358,7 +535,7 @@ void nxnGridOffline::CalcStartState(std::string& buffer)
 	buffer += "0 0 ";
 }
 
-void nxnGridOffline::CalcStartStateRec(intVec& state, intVec& initState, int currIdx, std::string & buffer)
+void nxnGridOffline::CalcStartStateRec(intVec& state, intVec& initState, int currIdx, PomdpWriter & buffer)
 {
 	// stopping condition when finish running on all objects
 	if (state.size() == currIdx)
@@ -390,11 +567,15 @@ void nxnGridOffline::CalcStartStateRec(intVec& state, intVec& initState, int cur
 	}
 }
 
-void nxnGridOffline::AddTargetPositionRec(intVec & state, int currIdx, std::string & buffer)
+void nxnGridOffline::AddTargetPositionRec(intVec & state, int currIdx, PomdpWriter & buffer)
 {
 	if (currIdx == state.size())
 	{
-		buffer += "T: * : " + GetStringState(state) + " : " + s_WinState + " 1.0000\n";
+		buffer += "T: * : ";
+		AddStringState(buffer, state, "s");
+		buffer += " : ";
+		buffer += s_WinState;
+		buffer += " 1.0000\n";
 	}
 	else
 	{
@@ -432,14 +613,19 @@ bool nxnGridOffline::IsNonInvDead(intVec & state) const
 
 int nxnGridOffline::FindNearestShelter(int location) const
 {
-	// assumption : support only 1 shelter
-	return m_shelterVec[0].GetLocation().GetIdx(m_gridSize);
+	Coordinate loc(location % m_gridSize, location / m_gridSize);
+	int nearest = 0;
+	for (int s = 1; s < m_shelterVec.size(); ++s)
+	{
+		if (loc.RealDistance(m_shelterVec[s].GetLocation()) < loc.RealDistance(m_shelterVec[nearest].GetLocation()))
+			nearest = s;
+	}
+
+	return m_shelterVec[nearest].GetLocation().GetIdx(m_gridSize);
 }
 
-double nxnGridOffline::PositionSingleState(intVec & newState, intVec & currentState, intVec & shelters, std::string & action, std::string & buffer) const
+double nxnGridOffline::PositionSingleState(intVec & newState, intVec & currentState, intVec & shelters, std::string & action, PomdpWriter & buffer) const
 {
-	std::string prefix = "T: " + action + " : " + GetStringState(currentState) + " : ";
-
 	// if the enemy is not dead calculate his attack (not support more than 1 enemy so far)
 	std::vector<double> individualProb2Kill;
 	for (int e = 0; e < m_enemyVec.size(); ++e)
@@ -464,8 +650,6 @@ double nxnGridOffline::PositionSingleState(intVec & newState, intVec & currentSt
 		pToDead *= remember;
 	}
 
-	prefix += "s";
-
 	std::vector<intVec> moveStates(CountMovableObj() - 1);
 	for (int i = 0; i < moveStates.size(); ++i)
 		moveStates[i].resize(s_NUM_OPTIONS_MOVE);
@@ -479,7 +663,14 @@ double nxnGridOffline::PositionSingleState(intVec & newState, intVec & currentSt
 	// calculate the probability of each move state and insert it to pMap
 	AddMoveStatesRec(newState, moveStates, arrOfIdx, 0, pMap);
 	
+	if (m_sparseBuilder != nullptr)
+	{
+		m_sparseBuilder->AddTransitions(action, pMap);
+		return pToDead;
+	}
+
 	// insert the move states to the buffer
+	std::string prefix = "T: " + action + " : " + GetStringState(currentState) + " : s";
 	int numStates = m_gridSize * m_gridSize;
 	std::for_each(pMap.begin(), pMap.end(), [&buffer, &prefix, numStates](pairMap itr)
 	{	buffer += prefix;	AddStateToBuffer(buffer, itr, numStates); });
@@ -487,23 +678,164 @@ double nxnGridOffline::PositionSingleState(intVec & newState, intVec & currentSt
 	return pToDead;
 }
 
-void nxnGridOffline::AddStateToBuffer(std::string& buffer, pairMap & itr, int numLocations)
+void nxnGridOffline::AddLossTransition(const std::string & action, intVec & state, double pLoss, PomdpWriter & buffer) const
 {
-	buffer += std::to_string(itr.first[0]);
+	if (pLoss <= 0.0)
+		return;
+
+	if (m_sparseBuilder != nullptr)
+		m_sparseBuilder->m_rows[m_sparseBuilder->ActionIdx(action)][m_sparseBuilder->m_lossIdx] += pLoss;
+	else
+	{
+		buffer += "T: ";
+		buffer += action;
+		buffer += " : ";
+		AddStringState(buffer, state, "s");
+		buffer += " : ";
+		buffer += s_LossState;
+		buffer += ' ';
+		buffer.AppendDbl(pLoss);
+		buffer += '\n';
+	}
+}
 
-	for (int i = 1; i < itr.first.size(); ++i)
+void nxnGridOffline::BuildSparsePomdp(SparsePomdp & pomdp, std::vector<long> & lutKeys)
+{
+	SparseBuilder builder;
+	builder.m_model = this;
+	ActionNames(builder.m_actionNames);
+	int numActions = builder.m_actionNames.size();
+
+	// states in the order of the pomdp file
+	int numStates = CountStates();
+	std::vector<intVec> states(numStates);
+	for (int s = 0; s < numStates; ++s)
+		states[s] = StateCount2State(s);
+
+	builder.m_winIdx = numStates;
+	builder.m_lossIdx = numStates + 1;
+
+	// lut idx of state includes the shelter location (as in StateCount2StateIdx)
+	lutKeys.resize(numStates);
+	for (int s = 0; s < numStates; ++s)
+	{
+		intVec lutState(states[s]);
+		if (m_shelterVec.size() > 0)
+			lutState.emplace_back(m_shelterVec[0].GetLocation().GetIdx(m_gridSize));
+		lutKeys[s] = State2Idx(lutState, m_gridSize);
+	}
+
+	pomdp = SparsePomdp(numActions, m_discount);
+
+	intVec initState;
+	initState.emplace_back(m_self.GetLocation().GetIdx(m_gridSize));
+	for (int i = 0; i < m_enemyVec.size(); ++i)
+		initState.emplace_back(m_enemyVec[i].GetLocation().GetIdx(m_gridSize));
+	for (int i = 0; i < m_nonInvolvedVec.size(); ++i)
+		initState.emplace_back(m_nonInvolvedVec[i].GetLocation().GetIdx(m_gridSize));
+	pomdp.m_initState = NoRepeatsAll(initState) ? State2StateCount(initState) : -1;
+
+	// transitions (the actions are writing to the builder instead of the buffer)
+	intVec shelters;
+	CreateShleterVec(shelters);
+	PomdpWriter buffer(nullptr, 0);
+	m_sparseBuilder = &builder;
+	for (int s = 0; s < numStates + 2; ++s)
+	{
+		builder.m_rows.assign(numActions, SparsePomdp::row_t());
+		if (s >= numStates)
+		{
+			// win and loss states are absorbing
+			for (int a = 0; a < numActions; ++a)
+				builder.m_rows[a][s] = 1.0;
+		}
+		else if (states[s][0] == m_targetIdx)
+		{
+			for (int a = 0; a < numActions; ++a)
+				builder.m_rows[a][builder.m_winIdx] = 1.0;
+		}
+		else
+		{
+			intVec currState(states[s]);
+			AddActionsSingleState(currState, shelters, buffer);
+		}
+
+		for (int a = 0; a < numActions; ++a)
+			pomdp.AddTransitionRow(builder.m_rows[a]);
+	}
+	m_sparseBuilder = nullptr;
+	s_pLeftProbability = 1.0;
+
+	// observations
+	std::unordered_map<long, int> obsIdx;
+	auto obsId = [&obsIdx, this](const intVec & obs)
+	{
+		return obsIdx.emplace(State2Idx(obs, m_gridSize), static_cast<int>(obsIdx.size())).first->second;
+	};
+
+	for (int s = 0; s < numStates; ++s)
+	{
+		SparsePomdp::row_t row;
+		if (m_isFullyObs)
+			row[obsId(states[s])] = 1.0;
+		else
+		{
+			mapProb pMap;
+			intVec observedState(states[s]);
+			CalcObsMapRec(observedState, states[s], pMap, 1.0, 1);
+			for (auto & v : pMap)
+				row[obsId(v.first)] += v.second;
+		}
+		pomdp.AddObservationRow(row);
+	}
+
+	int winObs = obsIdx.size();
+	int lossObs = winObs + 1;
+	pomdp.AddObservationRow(SparsePomdp::row_t{ { winObs, 1.0 } });
+	pomdp.AddObservationRow(SparsePomdp::row_t{ { lossObs, 1.0 } });
+	pomdp.m_numObservations = lossObs + 1;
+
+	// rewards for arriving to win and loss states
+	std::vector<double> arrivalReward(numStates + 2, 0.0);
+	arrivalReward[builder.m_winIdx] = s_REWARD_WIN;
+	arrivalReward[builder.m_lossIdx] = s_REWARD_LOSS;
+	std::vector<bool> isAbsorbing(numStates + 2, false);
+	isAbsorbing[builder.m_winIdx] = true;
+	isAbsorbing[builder.m_lossIdx] = true;
+	pomdp.SetRewards(arrivalReward, isAbsorbing);
+}
+
+void nxnGridOffline::AddStateToBuffer(PomdpWriter & buffer, pairMap & itr, int numLocations)
+{
+	AddLocations(buffer, itr.first, numLocations);
+	buffer += ' ';
+	buffer.AppendDbl(itr.second);
+	buffer += '\n';
+}
+
+void nxnGridOffline::AddLocations(PomdpWriter & buffer, const intVec & state, int numLocations)
+{
+	buffer.AppendInt(state[0]);
+
+	for (int i = 1; i < state.size(); ++i)
 	{
 		// if object is dead insert dead to buffer
-		if (itr.first[i] == numLocations)
+		if (state[i] == numLocations)
 		{
 			buffer += "xD";
 		}
 		else
 		{
-			buffer += "x" + std::to_string(itr.first[i]);
+			buffer += 'x';
+			buffer.AppendInt(state[i]);
 		}
 	}
-	buffer += " " + Dbl2Str(itr.second) + "\n";
+}
+
+void nxnGridOffline::AddStringState(PomdpWriter & buffer, intVec & state, const char * type) const
+{
+	buffer += type;
+	AddLocations(buffer, state, m_gridSize * m_gridSize);
 }
 
 std::string nxnGridOffline::GetStringState(intVec & state) const
@@ -526,7 +858,7 @@ std::string nxnGridOffline::GetStringState(intVec & state, const char *type) con
 			currentState += "xD";
 		}
 	}
-	return std::move(currentState);
+	return currentState;
 }
 
 bool nxnGridOffline::SearchForShelter(int location) const
@@ -667,21 +999,26 @@ void nxnGridOffline::CalcMoveStates(intVec & state, std::vector<intVec> & moveSt
 	}
 }
 
-void nxnGridOffline::CalcObs(std::string& buffer)
+void nxnGridOffline::CalcObs(PomdpWriter & buffer)
 {
-	intVec state(CountMovableObj());
-	CalcObsRec(state, 0, buffer);
+	ForEachSelfLocation(buffer, [this](intVec & state, PomdpWriter & chunk) { CalcObsRec(state, 1, chunk); });
 
 	buffer += "\nO: * : " + s_WinState + " : " "oWin 1.0";
 	buffer += "\nO: * : " + s_LossState + " : " "oLoss 1.0";
 }
-void nxnGridOffline::CalcObsRec(intVec& state, int currIdx, std::string & buffer)
+void nxnGridOffline::CalcObsRec(intVec& state, int currIdx, PomdpWriter & buffer)
 {
 	if (currIdx == state.size())
 	{
 		// arriving here when state is initialize to a state. run on this state calculation of observations
 		if (m_isFullyObs)
-			buffer += "O: * : " + GetStringState(state) + " : " + GetStringState(state, "o") + " 1\n";
+		{
+			buffer += "O: * : ";
+			AddStringState(buffer, state, "s");
+			buffer += " : ";
+			AddStringState(buffer, state, "o");
+			buffer += " 1\n";
+		}
 		else
 			CalcObsSingleState(state, buffer);
 
@@ -708,7 +1045,7 @@ void nxnGridOffline::CalcObsRec(intVec& state, int currIdx, std::string & buffer
 
 }
 
-void nxnGridOffline::CalcObsSingleState(intVec& state, std::string& buffer)
+void nxnGridOffline::CalcObsSingleState(intVec& state, PomdpWriter & buffer)
 {
 	std::string prefix = "O: * : " + GetStringState(state) + " : o";
 	
@@ -744,12 +1081,12 @@ void nxnGridOffline::CalcObsMapRec(intVec& observedState, intVec& state, mapProb
 	}
 }
 
-inline bool nxnGridOffline::IsEnemy(int idx) const
+bool nxnGridOffline::IsEnemy(int idx) const
 {
 	return idx - 1 < m_enemyVec.size();
 }
 
-inline int nxnGridOffline::CountMovableObj() const
+int nxnGridOffline::CountMovableObj() const
 {
 	return 1 + m_enemyVec.size() + m_nonInvolvedVec.size();
 }
@@ -786,19 +1123,6 @@ inline bool nxnGridOffline::AnyDead(intVec& state) const
 	return false;
 }
 
-// translate to string with higher precision
-std::string nxnGridOffline::Dbl2Str(double d)
-{
-	std::stringstream ss;
-	ss << std::fixed << std::setprecision(10) << d;              //convert double to string w fixed notation, hi precision
-	std::string s = ss.str();                                    //output to std::string
-	s.erase(s.find_last_not_of('0') + 1, std::string::npos);     //remove trailing 000s    (123.1200 => 123.12,  123.000 => 123.)
-
-	double a = strtod(s.c_str(), NULL);
-	return (s[s.size() - 1] == '.') ? s.substr(0, s.size() - 1) : s; //remove dangling decimal (123. => 123)
-}
-
-
 std::ostream& operator<<(std::ostream& o, const nxnGridOffline& pomdp)
 {
 	o << "\ngridSize : " << pomdp.m_gridSize <<
@@ -17,12 +17,16 @@
 
 #include <vector>
 #include <map>
+#include <functional>
 
 #include "Self_Obj.h"
 #include "Attack_Obj.h"
 #include "Movable_Obj.h"
 #include "ObjInGrid.h"
 
+class SparsePomdp;
+class PomdpWriter;
+
 class nxnGridOffline
 {
 	/// operator << to print the pomdp
@@ -35,7 +39,7 @@ class nxnGridOffline
 public:
 	explicit nxnGridOffline() = default;
 	explicit nxnGridOffline(int gridSize, int targetIdx, Self_Obj& self, bool isFullyObs, double discount = 0.95);
-	~nxnGridOffline() = default;
+	virtual ~nxnGridOffline() = default;
 	nxnGridOffline(const nxnGridOffline &) = default;
 	nxnGridOffline& operator=(const nxnGridOffline&) = default;
 
@@ -47,6 +51,11 @@ public:
 
 	/// save model in pomdp format to file
 	virtual void SaveInPomdpFormat(FILE *fptr) = 0;
+	/// build the model as sparse pomdp (states in the order of the pomdp file, win and loss states last). 
+	/// lutKeys is filled with the lut state idx of each state (without win and loss)
+	void BuildSparsePomdp(SparsePomdp & pomdp, std::vector<long> & lutKeys);
+	/// save model as binary sparse matrices (with the lut idx of each state) to file. return false on failure
+	bool SaveInSparseFormat(const std::string & fName);
 
 	// init model functions
 
@@ -65,6 +74,8 @@ public:
 	int CountShelters() const;
 	int GetGridSize() const;
 	bool IsFullyObs() const { return m_isFullyObs; };
+	/// set num of threads used to calculate the pomdp file (0 = all cores)
+	void SetNumThreads(int numThreads) { m_numThreads = numThreads; };
 	// change model functions
 
 	void SetLocationSelf(Coordinate & newLocation);
@@ -76,9 +87,18 @@ public:
 
 	long StateCount2StateIdx(long stateCount) const;
 	/// return state given stateIdx
-	intVec Idx2State(long stateIdx);
+	intVec Idx2State(long stateIdx) const;
+
+	/// return num of states in the pomdp file (without win and loss states)
+	long CountStates() const;
+	/// return the position of state (without shelter) in the order of the pomdp file (state count)
+	long State2StateCount(const intVec & state) const;
+	/// return the state (without shelter) in position stateCount in the order of the pomdp file
+	intVec StateCount2State(long stateCount) const;
 
 	virtual int GetNumActions() const = 0;
+	/// return names of actions (in the order of the actions in the pomdp file)
+	virtual void ActionNames(std::vector<std::string> & names) const = 0;
 /// protected to access for actions implementations
 protected:
 	// map & model properties
@@ -93,8 +113,8 @@ protected:
 	std::vector<ObjInGrid> m_shelterVec;
 
 	/// TODO: implement this variable in function arguments
-	/// to convey probability between calculations
-	static double s_pLeftProbability;
+	/// to convey probability between calculations (per thread because states are calculated in parallel)
+	static thread_local double s_pLeftProbability;
 
 /// functions necessary for actions implementations
 
@@ -104,18 +124,25 @@ protected:
 	void ObservationsAndRewards(FILE *fptr);
 
 	/// insert of possible state or observations(depending on type) to buffer
-	void CalcStatesAndObs(const char * type, std::string& buffer);
+	void CalcStatesAndObs(const char * type, PomdpWriter & buffer);
+	/// run func(state, chunk) for each location of self (state[0]) on worker threads. the chunks are inserted to buffer in the order of self location
+	/// so the output is identical to a serial run
+	void ForEachSelfLocation(PomdpWriter & buffer, const std::function<void(intVec & state, PomdpWriter & chunk)> & func) const;
 
 	/// insert probability to init of all states
-	void CalcStartState(std::string& buffer);
+	void CalcStartState(PomdpWriter & buffer);
 
 	/// insert the end-states positions (states and probabilities) from a single state(state) to buffer
-	double PositionSingleState(intVec& state, intVec& currentState, intVec & shelters, std::string& action, std::string& buffer) const;
+	double PositionSingleState(intVec& state, intVec& currentState, intVec & shelters, std::string& action, PomdpWriter & buffer) const;
+	/// insert transition of action from state to loss state to buffer
+	void AddLossTransition(const std::string & action, intVec & state, double pLoss, PomdpWriter & buffer) const;
+	/// insert the end-states of all actions from a single state to buffer
+	virtual void AddActionsSingleState(intVec & state, intVec & shelters, PomdpWriter & buffer) = 0;
 	
 	/// insert states where robot is in target position transition to win state to buffer
-	void AddTargetPositionRec(intVec & state, int currIdx, std::string& buffer);
+	void AddTargetPositionRec(intVec & state, int currIdx, PomdpWriter & buffer);
 	/// calculation of transition of all actions
-	void AddActionsAllStates(std::string& buffer);
+	void AddActionsAllStates(PomdpWriter & buffer);
 
 	/// return true if there is dead non-involved
 	bool IsNonInvDead(intVec & state) const;
@@ -131,8 +158,8 @@ protected:
 	std::string GetStringState(intVec& state) const;
 	/// translate a state to the pomdp format string with a different initialize char
 	std::string GetStringState(intVec& state, const char * type) const;
-	// translate to string with higher precision
-	static std::string Dbl2Str(double d);
+	/// insert a state in the pomdp format (with initialize char type) to buffer
+	void AddStringState(PomdpWriter & buffer, intVec& state, const char * type) const;
 
 	/// return true if location is not presence on state
 	bool NoRepeatsLocation(intVec& state, int location) const;
@@ -146,6 +173,14 @@ protected:
 	/// return true if objIdx is an idx of an enemy
 	bool IsEnemy(int objIdx) const;
 private:
+	/// collects transitions while the sparse pomdp is built (when null transitions are written to buffer)
+	struct SparseBuilder;
+	SparseBuilder * m_sparseBuilder = nullptr;
+	/// num of threads used to calculate the pomdp file (0 = all cores)
+	int m_numThreads = 0;
+	/// m_numCompletions[currIdx * (numObj + 1) + numAlive] is the num of states of objects from currIdx given numAlive objects
+	/// before currIdx (the table of state ranking)
+	std::vector<long> m_numCompletions;
 
 	// main functions for saving format to file: 
 
@@ -154,17 +189,17 @@ private:
 	/// insert transitions of all actions to file
 	virtual void AddAllActions(FILE *fptr) = 0;
 
-	/// find corresponding state to stateCount (basic count of state)
-	void FindStateCount(intVec & state, long & count, int currIdx) const;
+	/// calculate m_numCompletions (called when the moving objects or the grid size are changed)
+	void CountCompletions();
 	/// return state_id given state and gridSize
-	static long State2Idx(intVec & state, int gridSize);
+	static long State2Idx(const intVec & state, int gridSize);
 
 
 	/// run on all possible states or observations and insert them to buffer
-	void CalcS_ORec(intVec& state, int currIdx, const char * type, std::string& buffer);
+	void CalcS_ORec(intVec& state, int currIdx, const char * type, PomdpWriter & buffer);
 
 	/// run on all states and insert the probability of each state to init in
-	void CalcStartStateRec(intVec& state, intVec& initState, int currIdx, std::string& buffer);
+	void CalcStartStateRec(intVec& state, intVec& initState, int currIdx, PomdpWriter & buffer);
 
 	
 	/// calculate possible move states from a start-state
@@ -173,7 +208,9 @@ private:
 	void AddMoveStatesRec(intVec & state, std::vector<intVec> & moveStates, intVec & arrOfIdx, int currIdx, mapProb & pMap) const;
 
 	/// add state and probability to state (itr) to buffer
-	static void AddStateToBuffer(std::string& buffer, pairMap & itr, int gridSize);
+	static void AddStateToBuffer(PomdpWriter & buffer, pairMap & itr, int gridSize);
+	/// add locations of state (dead object as D) to buffer
+	static void AddLocations(PomdpWriter & buffer, const intVec & state, int numLocations);
 
 	/// returns the real end-state from a given moveState
 	intVec MoveToIdx(intVec stateVec, std::vector<intVec> & moveStates, intVec arrOfIdx) const;
@@ -181,11 +218,11 @@ private:
 	double CalcProb2Move(const intVec & arrOfIdx) const;
 
 	///insert all observations to buffer
-	void CalcObs(std::string& buffer);
+	void CalcObs(PomdpWriter & buffer);
 	/// run on all states and insert observation probability to buffer
-	void CalcObsRec(intVec& state, int currIdx, std::string& buffer);
+	void CalcObsRec(intVec& state, int currIdx, PomdpWriter & buffer);
 	/// insert observation probability of a single state
-	void CalcObsSingleState(intVec& state, std::string& buffer);
+	void CalcObsSingleState(intVec& state, PomdpWriter & buffer);
 	/// calculate probability of observation from originalState
 	void CalcObsMapRec(intVec& state, intVec& originalState, mapProb& pMap, double pCurr, int currObj);
 	/// run on 8 close locations and diverge observation probability to those locations
@@ -1,5 +1,7 @@
 #include "nxnGridOfflineGlobalActions.h"
 
+#include "PomdpWriter.h"
+
 #include <iostream>
 static const std::string s_WinState = "Win";
 static const std::string s_LossState = "Loss";
@@ -31,7 +33,6 @@ nxnGridOfflineGlobalActions::nxnGridOfflineGlobalActions(int gridSize, int targe
 
 void nxnGridOfflineGlobalActions::SaveInPomdpFormat(FILE *fptr)
 {
-	std::string buffer("");
 	//add comments and init lines(state observations etc.) to file
 	CommentsAndInitLines(fptr);
 
@@ -49,7 +50,7 @@ int nxnGridOfflineGlobalActions::GetNumActions() const
 
 void nxnGridOfflineGlobalActions::CommentsAndInitLines(FILE *fptr)
 {
-	std::string buffer;
+	PomdpWriter buffer(fptr);
 
 	// add comments
 	buffer += "# pomdp file:\n";
@@ -105,14 +106,11 @@ void nxnGridOfflineGlobalActions::CommentsAndInitLines(FILE *fptr)
 	// add start states probability
 	CalcStartState(buffer);
 	buffer += "\n\n";
-	//save to file
-	auto err = fputs(buffer.c_str(), fptr);
-	if (err < 0) { std::cerr << "Error Writing to file\n"; exit(1); }
 }
 
 void nxnGridOfflineGlobalActions::AddAllActions(FILE * fptr)
 {
-	std::string buffer;
+	PomdpWriter buffer(fptr);
 
 	// add move to win state from states when the robot is in target
 	intVec state(CountMovableObj());
@@ -122,27 +120,22 @@ void nxnGridOfflineGlobalActions::AddAllActions(FILE * fptr)
 
 	// add actions for all states
 	AddActionsAllStates(buffer);
-
-	// save to file
-	auto err = fputs(buffer.c_str(), fptr);
-	if (err < 0) { std::cerr << "Error Writing to file\n"; exit(1); }
 }
 
-void nxnGridOfflineGlobalActions::AddActionsAllStates(std::string & buffer)
+void nxnGridOfflineGlobalActions::AddActionsAllStates(PomdpWriter & buffer)
 {
-	intVec state(CountMovableObj());
 	std::string action = "*";
 
 	std::vector<int> shelters;
 	CreateShleterVec(shelters);
 
-	AddActionsRec(state, shelters, 0, buffer);
+	ForEachSelfLocation(buffer, [this, &shelters](intVec & state, PomdpWriter & chunk) { AddActionsRec(state, shelters, 1, chunk); });
 
 	buffer += "\n\nT: * : " + s_WinState + " : " + s_WinState + " 1";
 	buffer += "\nT: * : " + s_LossState + " : " + s_LossState + " 1\n\n";
 }
 
-void nxnGridOfflineGlobalActions::AddActionsRec(intVec & state, intVec & shelters, int currObj, std::string & buffer)
+void nxnGridOfflineGlobalActions::AddActionsRec(intVec & state, intVec & shelters, int currObj, PomdpWriter & buffer)
 {
 	if (currObj == state.size())
 	{
@@ -150,21 +143,7 @@ void nxnGridOfflineGlobalActions::AddActionsRec(intVec & state, intVec & shelter
 		if (state[0] == m_targetIdx)
 			return;
 
-		//int m = state[0];
-		//int e1 = state[1];
-		//int e2 = state[2];
-
-		AddMoveToTarget(state, shelters, buffer);
-		
-		// if exist shelter add move to shelter action
-		if (m_shelterVec.size() > 0)
-			AddMoveToShelter(state, shelters, buffer);
-
-		for (int e = 0; e < m_enemyVec.size(); ++e)
-		{
-			AddAttack(state, e, shelters, buffer);
-			AddMoveFromEnemy(state, e, shelters, buffer);
-		}
+		AddActionsSingleState(state, shelters, buffer);
 	}
 	else
 	{
@@ -185,7 +164,36 @@ void nxnGridOfflineGlobalActions::AddActionsRec(intVec & state, intVec & shelter
 	}
 }
 
-void nxnGridOfflineGlobalActions::AddAttack(intVec & state, int enemyIdx, intVec & shelters, std::string & buffer) const
+void nxnGridOfflineGlobalActions::AddActionsSingleState(intVec & state, intVec & shelters, PomdpWriter & buffer)
+{
+	AddMoveToTarget(state, shelters, buffer);
+
+	// if exist shelter add move to shelter action
+	if (m_shelterVec.size() > 0)
+		AddMoveToShelter(state, shelters, buffer);
+
+	for (int e = 0; e < m_enemyVec.size(); ++e)
+	{
+		AddAttack(state, e, shelters, buffer);
+		AddMoveFromEnemy(state, e, shelters, buffer);
+	}
+}
+
+void nxnGridOfflineGlobalActions::ActionNames(std::vector<std::string> & names) const
+{
+	names.clear();
+	names.emplace_back("MoveToTarget");
+	if (m_shelterVec.size() > 0)
+		names.emplace_back("MoveToShelter");
+
+	for (int e = 0; e < m_enemyVec.size(); ++e)
+	{
+		names.emplace_back("Attack" + std::to_string(e));
+		names.emplace_back("MoveFromEnemy" + std::to_string(e));
+	}
+}
+
+void nxnGridOfflineGlobalActions::AddAttack(intVec & state, int enemyIdx, intVec & shelters, PomdpWriter & buffer) const
 {
 	std::string action = "Attack" + std::to_string(enemyIdx);
 	
@@ -196,8 +204,7 @@ void nxnGridOfflineGlobalActions::AddAttack(intVec & state, int enemyIdx, intVec
 	if (state[enemyIdx + 1] == m_gridSize * m_gridSize)
 	{
 		pLoss = PositionSingleState(state, state, shelters, action, buffer);
-		if (pLoss > 0.0)
-			buffer += "T: " + action + " : " + GetStringState(state) + " : " + s_LossState + " " + Dbl2Str(pLoss) + "\n";
+		AddLossTransition(action, state, pLoss, buffer);
 		buffer += "\n";
 		return;
 	}
@@ -227,13 +234,12 @@ void nxnGridOfflineGlobalActions::AddAttack(intVec & state, int enemyIdx, intVec
 	else
 		pLoss += MoveToLocation(state, shelters, state[enemyIdx + 1], action, buffer);
 
-	if (pLoss > 0.0)
-		buffer += "T: " + action + " : " + GetStringState(state) + " : " + s_LossState + " " + Dbl2Str(pLoss) + "\n";
+	AddLossTransition(action, state, pLoss, buffer);
 
 	buffer += "\n";
 }
 
-void nxnGridOfflineGlobalActions::AddMoveToTarget(intVec & state, intVec & shelters, std::string & buffer) const
+void nxnGridOfflineGlobalActions::AddMoveToTarget(intVec & state, intVec & shelters, PomdpWriter & buffer) const
 {
 	std::string action = "MoveToTarget";
 	
@@ -243,13 +249,12 @@ void nxnGridOfflineGlobalActions::AddMoveToTarget(intVec & state, intVec & shelt
 	std::vector<std::pair<int, double>> moveOutComes;
 	pLoss += MoveToLocation(state, shelters, m_targetIdx, action, buffer);
 
-	if (pLoss > 0.0)
-		buffer += "T: " + action + " : " + GetStringState(state) + " : " + s_LossState + " " + Dbl2Str(pLoss) + "\n";
+	AddLossTransition(action, state, pLoss, buffer);
 
 	buffer += "\n";
 }
 
-void nxnGridOfflineGlobalActions::AddMoveToShelter(intVec & state, intVec & shelters, std::string & buffer) const
+void nxnGridOfflineGlobalActions::AddMoveToShelter(intVec & state, intVec & shelters, PomdpWriter & buffer) const
 {
 	std::string action = "MoveToShelter";
 	
@@ -264,13 +269,12 @@ void nxnGridOfflineGlobalActions::AddMoveToShelter(intVec & state, intVec & shel
 	else
 		pLoss += PositionSingleState(state, state, shelters, action, buffer);
 
-	if (pLoss > 0.0)
-		buffer += "T: " + action + " : " + GetStringState(state) + " : " + s_LossState + " " + Dbl2Str(pLoss) + "\n";
+	AddLossTransition(action, state, pLoss, buffer);
 
 	buffer += "\n";
 }
 
-void nxnGridOfflineGlobalActions::AddMoveFromEnemy(intVec & state, int idxEnemy, intVec & shelters, std::string & buffer) const
+void nxnGridOfflineGlobalActions::AddMoveFromEnemy(intVec & state, int idxEnemy, intVec & shelters, PomdpWriter & buffer) const
 {
 	std::string action = "MoveFromEnemy" + std::to_string(idxEnemy);
 
@@ -281,8 +285,7 @@ void nxnGridOfflineGlobalActions::AddMoveFromEnemy(intVec & state, int idxEnemy,
 	if (state[idxEnemy + 1] == m_gridSize * m_gridSize)
 	{
 		pLoss = PositionSingleState(state, state, shelters, action, buffer);
-		if (pLoss > 0.0)
-			buffer += "T: " + action + " : " + GetStringState(state) + " : " + s_LossState + " " + Dbl2Str(pLoss) + "\n";
+		AddLossTransition(action, state, pLoss, buffer);
 		buffer += "\n";
 		return;
 	}
@@ -306,13 +309,12 @@ void nxnGridOfflineGlobalActions::AddMoveFromEnemy(intVec & state, int idxEnemy,
 		pLoss += PositionSingleState(state, state, shelters, action, buffer);
 
 
-	if (pLoss > 0.0)
-		buffer += "T: " + action + " : " + GetStringState(state) + " : " + s_LossState + " " + Dbl2Str(pLoss) + "\n";
+	AddLossTransition(action, state, pLoss, buffer);
 
 	buffer += "\n";
 }
 
-double nxnGridOfflineGlobalActions::MoveToLocation(intVec & state, intVec & shelters, int location, std::string & action, std::string & buffer) const
+double nxnGridOfflineGlobalActions::MoveToLocation(intVec & state, intVec & shelters, int location, std::string & action, PomdpWriter & buffer) const
 {
 	std::pair<double, double> goTo = std::make_pair(location % m_gridSize, location / m_gridSize);
 
@@ -21,6 +21,8 @@ public:
 	void SaveInPomdpFormat(FILE *fptr) override;
 
 	virtual int GetNumActions() const override;
+	/// return names of actions (in the order of the actions in the pomdp file)
+	void ActionNames(std::vector<std::string> & names) const override;
 private:
 	// main functions for saving format to file: 
 
@@ -32,21 +34,23 @@ private:
 	std::string AddActionsString();
 
 	// Calculation of actions result
-	void AddActionsAllStates(std::string & buffer);
+	void AddActionsAllStates(PomdpWriter & buffer);
 	/// run on all possible states and calculate the end-state fro all actions
-	void AddActionsRec(intVec & state, intVec & shelters, int currObj, std::string & buffer);
+	void AddActionsRec(intVec & state, intVec & shelters, int currObj, PomdpWriter & buffer);
+	/// insert the end-states of all actions from a single state to buffer
+	void AddActionsSingleState(intVec & state, intVec & shelters, PomdpWriter & buffer) override;
 
 	/// add action attack with state and shelters to buffer
-	void AddAttack(intVec & state, int enemyIdx, intVec & shelters, std::string & buffer) const;
+	void AddAttack(intVec & state, int enemyIdx, intVec & shelters, PomdpWriter & buffer) const;
 	/// add action move to target with state and shelters to buffer
-	void AddMoveToTarget(intVec & state, intVec & shelters, std::string & buffer) const;
+	void AddMoveToTarget(intVec & state, intVec & shelters, PomdpWriter & buffer) const;
 	/// add action move to shelter with state and shelters to buffer
-	void AddMoveToShelter(intVec & state, intVec & shelters, std::string & buffer) const;
+	void AddMoveToShelter(intVec & state, intVec & shelters, PomdpWriter & buffer) const;
 	/// add action move from enemy with state and shelters to buffer
-	void AddMoveFromEnemy(intVec & state, int idxEnemy, intVec & shelters, std::string & buffer) const;
+	void AddMoveFromEnemy(intVec & state, int idxEnemy, intVec & shelters, PomdpWriter & buffer) const;
 
 	/// move to a specific location return the peobability to loss in that action
-	double MoveToLocation(intVec & state, intVec & shelters, int location, std::string & action, std::string & buffer) const;
+	double MoveToLocation(intVec & state, intVec & shelters, int location, std::string & action, PomdpWriter & buffer) const;
 	/// move to location return new self location (-1 if there is no way to get closer to location)
 	int MoveToLocationIMP(intVec & state, int goTo) const;
 	/// return the farthest point reachable of self from a specific location
@@ -1,5 +1,6 @@
 #include "nxnGridOffline.h"
 #include "nxnGridOfflineLocalActions.h"
+#include "PomdpWriter.h"
 
 #include <iostream>
 static const std::string s_WinState = "Win";
@@ -32,7 +33,6 @@ nxnGridOfflineLocalActions::nxnGridOfflineLocalActions(int gridSize, int targetI
 
 void nxnGridOfflineLocalActions::SaveInPomdpFormat(FILE *fptr)
 {
-	std::string buffer("");
 	//add comments and init lines(state observations etc.) to file
 	CommentsAndInitLines(fptr);
 
@@ -50,7 +50,7 @@ int nxnGridOfflineLocalActions::GetNumActions() const
 
 void nxnGridOfflineLocalActions::CommentsAndInitLines(FILE *fptr)
 {
-	std::string buffer;
+	PomdpWriter buffer(fptr);
 
 	// add comments
 	buffer += "# pomdp file:\n";
@@ -97,14 +97,11 @@ void nxnGridOfflineLocalActions::CommentsAndInitLines(FILE *fptr)
 	// add start states probability
 	CalcStartState(buffer);
 	buffer += "\n\n";
-	//save to file
-	auto err = fputs(buffer.c_str(), fptr);
-	if (err < 0) { std::cerr << "Error Writing to file\n"; exit(1); }
 }
 
 void nxnGridOfflineLocalActions::AddAllActions(FILE * fptr)
 {
-	std::string buffer;
+	PomdpWriter buffer(fptr);
 
 	// add move to win state from states when the robot is in target
 	intVec state(CountMovableObj());
@@ -114,27 +111,22 @@ void nxnGridOfflineLocalActions::AddAllActions(FILE * fptr)
 
 	// add actions for all states
 	AddActionsAllStates(buffer);
-
-	// save to file
-	auto err = fputs(buffer.c_str(), fptr);
-	if (err < 0) { std::cerr << "Error Writing to file\n"; exit(1); }
 }
 
-void nxnGridOfflineLocalActions::AddActionsAllStates(std::string & buffer)
+void nxnGridOfflineLocalActions::AddActionsAllStates(PomdpWriter & buffer)
 {
-	intVec state(CountMovableObj());
 	std::string action = "*";
 
 	std::vector<int> shelters;
 	CreateShleterVec(shelters);
 
-	AddActionsRec(state, shelters, 0, buffer);
+	ForEachSelfLocation(buffer, [this, &shelters](intVec & state, PomdpWriter & chunk) { AddActionsRec(state, shelters, 1, chunk); });
 
 	buffer += "\n\nT: * : " + s_WinState + " : " + s_WinState + " 1";
 	buffer += "\nT: * : " + s_LossState + " : " + s_LossState + " 1\n\n";
 }
 
-void nxnGridOfflineLocalActions::AddActionsRec(intVec & state, intVec & shelters, int currObj, std::string & buffer)
+void nxnGridOfflineLocalActions::AddActionsRec(intVec & state, intVec & shelters, int currObj, PomdpWriter & buffer)
 {
 	if (currObj == state.size())
 	{
@@ -142,8 +134,7 @@ void nxnGridOfflineLocalActions::AddActionsRec(intVec & state, intVec & shelters
 		if (state[0] == m_targetIdx)
 			return;
 
-		AddAllMoves(state, shelters, buffer);
-		AddAttack(state, shelters, buffer);
+		AddActionsSingleState(state, shelters, buffer);
 	}
 	else
 	{
@@ -164,13 +155,12 @@ void nxnGridOfflineLocalActions::AddActionsRec(intVec & state, intVec & shelters
 	}
 }
 
-void nxnGridOfflineLocalActions::AddAllMoves(intVec & state, intVec & shelters, std::string & buffer) const
+void nxnGridOfflineLocalActions::AddAllMoves(intVec & state, intVec & shelters, PomdpWriter & buffer) const
 {
 	// add stay action
 	std::string stayAction("Stay");
 	double pLoss = PositionSingleState(state, state, shelters, stayAction, buffer);
-	if (pLoss > 0.0)
-		buffer += "T: " + stayAction + " : " + GetStringState(state) + " : " + s_LossState + " " + Dbl2Str(pLoss) + "\n";
+	AddLossTransition(stayAction, state, pLoss, buffer);
 
 	// add moves
 	AddSingleMove(state, shelters, "North", Coordinate(0, -1), buffer);
@@ -185,7 +175,7 @@ void nxnGridOfflineLocalActions::AddAllMoves(intVec & state, intVec & shelters,
 	AddSingleMove(state, shelters, "SouthEast", Coordinate(1, 1), buffer);
 }
 
-void nxnGridOfflineLocalActions::AddSingleMove(intVec & state, intVec & shelters, std::string action, Coordinate advance, std::string & buffer) const
+void nxnGridOfflineLocalActions::AddSingleMove(intVec & state, intVec & shelters, std::string action, Coordinate advance, PomdpWriter & buffer) const
 {
 	double pLoss = 0.0;
 	int newLoc = state[0] + advance.X() + advance.Y() * m_gridSize;
@@ -205,14 +195,24 @@ void nxnGridOfflineLocalActions::AddSingleMove(intVec & state, intVec & shelters
 	else
 		pLoss += PositionSingleState(state, state, shelters, action, buffer);
 
-	if (pLoss > 0.0)
-		buffer += "T: " + action + " : " + GetStringState(state) + " : " + s_LossState + " " + Dbl2Str(pLoss) + "\n";
+	AddLossTransition(action, state, pLoss, buffer);
 
 	s_pLeftProbability = 1.0;
 	buffer += "\n";
 }
 
-void nxnGridOfflineLocalActions::AddAttack(intVec & state, intVec & shelters, std::string & buffer) const
+void nxnGridOfflineLocalActions::AddActionsSingleState(intVec & state, intVec & shelters, PomdpWriter & buffer)
+{
+	AddAllMoves(state, shelters, buffer);
+	AddAttack(state, shelters, buffer);
+}
+
+void nxnGridOfflineLocalActions::ActionNames(std::vector<std::string> & names) const
+{
+	names = { "Stay", "North", "South", "West", "East", "NorthWest", "NorthEast", "SouthWest", "SouthEast", "Attack" };
+}
+
+void nxnGridOfflineLocalActions::AddAttack(intVec & state, intVec & shelters, PomdpWriter & buffer) const
 {
 	std::string action = "Attack";
 	double pLoss = 0.0;
@@ -250,14 +250,13 @@ void nxnGridOfflineLocalActions::AddAttack(intVec & state, intVec & shelters, st
 	else
 		pLoss += MoveToLocation(state, shelters, state[1], action, buffer);
 
-	if (pLoss > 0.0)
-		buffer += "T: " + action + " : " + GetStringState(state) + " : " + s_LossState + " " + Dbl2Str(pLoss) + "\n";
+	AddLossTransition(action, state, pLoss, buffer);
 
 	s_pLeftProbability = 1.0;
 	buffer += "\n";
 }
 
-double nxnGridOfflineLocalActions::MoveToLocation(intVec & state, intVec & shelters, int location, std::string & action, std::string & buffer) const
+double nxnGridOfflineLocalActions::MoveToLocation(intVec & state, intVec & shelters, int location, std::string & action, PomdpWriter & buffer) const
 {
 	std::pair<double, double> goTo = std::make_pair(location % m_gridSize, location / m_gridSize);
 
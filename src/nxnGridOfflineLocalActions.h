@@ -22,6 +22,8 @@ public:
 	void SaveInPomdpFormat(FILE *fptr) override;
 
 	virtual int GetNumActions() const override;
+	/// return names of actions (in the order of the actions in the pomdp file)
+	void ActionNames(std::vector<std::string> & names) const override;
 private:
 	// main functions for saving format to file: 
 
@@ -33,18 +35,20 @@ private:
 	std::string AddActionsString();
 
 	// Calculation of actions result
-	void AddActionsAllStates(std::string & buffer);
+	void AddActionsAllStates(PomdpWriter & buffer);
 	/// run on all possible states and calculate the end-state fro all actions
-	void AddActionsRec(intVec & state, intVec & shelters, int currObj, std::string & buffer);
+	void AddActionsRec(intVec & state, intVec & shelters, int currObj, PomdpWriter & buffer);
+	/// insert the end-states of all actions from a single state to buffer
+	void AddActionsSingleState(intVec & state, intVec & shelters, PomdpWriter & buffer) override;
 
 	/// add action attack with state and shelters to buffer
-	void AddAttack(intVec & state, intVec & shelters, std::string & buffer) const;
+	void AddAttack(intVec & state, intVec & shelters, PomdpWriter & buffer) const;
 	/// add action all moves with state and shelters to buffer
-	void AddAllMoves(intVec & state, intVec & shelters, std::string & buffer) const;
-	void AddSingleMove(intVec & state, intVec & shelters, std::string action, Coordinate advance, std::string & buffer) const;
+	void AddAllMoves(intVec & state, intVec & shelters, PomdpWriter & buffer) const;
+	void AddSingleMove(intVec & state, intVec & shelters, std::string action, Coordinate advance, PomdpWriter & buffer) const;
 
 	/// move to a specific location return the peobability to loss in that action
-	double MoveToLocation(intVec & state, intVec & shelters, int location, std::string & action, std::string & buffer) const;
+	double MoveToLocation(intVec & state, intVec & shelters, int location, std::string & action, PomdpWriter & buffer) const;
 	/// move to location return new self location (-1 if there is no way to get closer to location)
 	int MoveToLocationIMP(intVec & state, int goTo) const;
 };
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "nxnGridOfflineGlobalActions.h"
+#include "PomdpWriter.h"
+
+// properties of objects
+#include "Coordinate.h"
+#include "Move_Properties.h"
+#include "Attacks.h"
+#include "Observations.h"
+
+/// round trip check of the closed form state ranking of nxnGridOffline: for each state count the unranked state is ranked back
+/// to the same count and is equal to the state in the same position of the "states:" line of the pomdp file
+
+using intVec = std::vector<int>;
+
+/// exposes the state names of the pomdp file
+class StateNamesModel : public nxnGridOfflineGlobalActions
+{
+public:
+	StateNamesModel(int gridSize, Self_Obj & self)
+		: nxnGridOfflineGlobalActions(gridSize, gridSize * gridSize - 1, self) {}
+
+	/// return names of the states (without win and loss states) in the order of the pomdp file
+	std::vector<std::string> StateNames()
+	{
+		std::string line;
+		{
+			PomdpWriter buffer(line);
+			CalcStatesAndObs("s", buffer);
+		}
+
+		std::vector<std::string> names;
+		std::istringstream stream(line);
+		std::string name;
+		while (stream >> name)
+			names.emplace_back(name);
+		return names;
+	}
+};
+
+/// return number of failed checks for a model
+int CheckModel(int gridSize, int numEnemies, int numNonInv);
+
+int main(int argc, char* argv[])
+{
+	int numFailed = 0;
+	for (int gridSize = 2; gridSize <= 4; ++gridSize)
+	{
+		for (int numEnemies = 0; numEnemies <= 2; ++numEnemies)
+		{
+			for (int numNonInv = 0; numNonInv <= 1; ++numNonInv)
+				numFailed += CheckModel(gridSize, numEnemies, numNonInv);
+		}
+	}
+
+	std::cout << (numFailed == 0 ? "state rank round trip passed\n" : "state rank round trip failed\n");
+	return numFailed == 0 ? 0 : 1;
+}
+
+int CheckModel(int gridSize, int numEnemies, int numNonInv)
+{
+	Coordinate selfLocation(0, 0);
+	Move_Properties selfMovement(0.1, 0.9);
+	std::shared_ptr<Attack> attack(new DirectAttack(1, 0.5));
+	std::shared_ptr<Observation> observation(new ObservationByDistance(0.4));
+	Self_Obj self(selfLocation, selfMovement, attack, observation);
+
+	StateNamesModel model(gridSize, self);
+	model.SetNumThreads(1);
+	for (int e = 0; e < numEnemies; ++e)
+	{
+		Coordinate enemyLocation(gridSize - 1 - e, gridSize - 1);
+		Move_Properties enemyMovement(0.35, 0.4);
+		model.AddObj(Attack_Obj(enemyLocation, enemyMovement, attack));
+	}
+
+	for (int n = 0; n < numNonInv; ++n)
+	{
+		Coordinate nonInvLocation(0, gridSize - 1);
+		Move_Properties nonInvMovement(0.6);
+		model.AddObj(Movable_Obj(nonInvLocation, nonInvMovement));
+	}
+
+	std::vector<std::string> names = model.StateNames();
+	long numStates = model.CountStates();
+	int numFailed = numStates != names.size();
+
+	for (long stateCount = 0; stateCount < numStates && stateCount < names.size(); ++stateCount)
+	{
+		intVec state = model.StateCount2State(stateCount);
+		long rank = model.State2StateCount(state);
+
+		// state name is "s<self>x<object>x..." with D for dead object
+		std::string name = "s" + std::to_string(state[0]);
+		for (int o = 1; o < state.size(); ++o)
+			name += state[o] == gridSize * gridSize ? "xD" : "x" + std::to_string(state[o]);
+
+		if (rank != stateCount || name != names[stateCount])
+		{
+			if (numFailed < 10)
+				std::cout << "grid " << gridSize << " state count " << stateCount << ": unranked " << name << " ranked to " << rank << " expected " << names[stateCount] << "\n";
+			++numFailed;
+		}
+	}
+
+	std::cout << "grid " << gridSize << " enemies " << numEnemies << " non-involved " << numNonInv << ": " << numStates << " states ("
+		<< names.size() << " in pomdp file), " << numFailed << " failed\n";
+	return numFailed;
+}
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "nxnGridToolModel.h"
+
+using namespace despot;
+
+/// check that nxnGrid step is a function of (state, action, scenario random number, last observation):
+/// fixed triples are stepped twice on the same thread and on several threads sharing the model and the results are compared
+
+static const int s_NUM_TRIPLES = 50000;
+static const int s_NUM_THREADS = 4;
+
+/// step input
+struct StepInput
+{
+	STATE_TYPE m_state;
+	int m_action;
+	double m_random;
+	OBS_TYPE m_lastObs;
+};
+
+/// step output
+struct StepResult
+{
+	STATE_TYPE m_state;
+	OBS_TYPE m_obs;
+	double m_reward;
+	bool m_terminal;
+
+	bool operator==(const StepResult & other) const
+	{
+		return m_state == other.m_state && m_obs == other.m_obs && m_reward == other.m_reward && m_terminal == other.m_terminal;
+	}
+};
+
+void CreateInputs(const nxnGrid * model, std::vector<StepInput> & inputs);
+void StepAll(const nxnGrid * model, const std::vector<StepInput> & inputs, std::vector<StepResult> & results);
+
+int main(int argc, char* argv[])
+{
+	bool passed = true;
+	for (int gridSize : { 5, 10 })
+	{
+		for (nxnGridToolModel::ACTION_TYPE actionType : { nxnGridToolModel::GLOBAL, nxnGridToolModel::LOCAL })
+		{
+			std::unique_ptr<nxnGrid> model(nxnGridToolModel::Create(gridSize, actionType));
+			std::vector<StepInput> inputs;
+			CreateInputs(model.get(), inputs);
+
+			std::vector<StepResult> first, second;
+			StepAll(model.get(), inputs, first);
+			StepAll(model.get(), inputs, second);
+			bool repeated = first == second;
+
+			// all threads step the same inputs on the same model
+			std::vector<std::vector<StepResult>> threadResults(s_NUM_THREADS);
+			std::vector<std::thread> threads;
+			for (int t = 0; t < s_NUM_THREADS; ++t)
+				threads.emplace_back(StepAll, model.get(), std::cref(inputs), std::ref(threadResults[t]));
+			for (std::thread & thread : threads)
+				thread.join();
+
+			bool acrossThreads = true;
+			for (const std::vector<StepResult> & results : threadResults)
+				acrossThreads &= results == first;
+
+			std::cout << (actionType == nxnGridToolModel::LOCAL ? "local" : "global") << " actions grid " << gridSize << ": repeated steps " << (repeated ? "identical" : "DIFFERENT")
+				<< ", steps on " << s_NUM_THREADS << " threads " << (acrossThreads ? "identical" : "DIFFERENT") << "\n";
+			passed &= repeated & acrossThreads;
+		}
+	}
+
+	std::cout << (passed ? "step determinism passed\n" : "step determinism failed\n");
+	return passed ? 0 : 1;
+}
+
+/// create random step inputs (objects may be dead and may be non-observed in the last observation)
+void CreateInputs(const nxnGrid * model, std::vector<StepInput> & inputs)
+{
+	std::mt19937 generator(3);
+	std::uniform_real_distribution<double> random(0.0, 1.0);
+	const nxnGridContext & context = *model->GetContext();
+	int numLocations = model->GetGridSize() * model->GetGridSize();
+	std::vector<int> state(model->CountMovingObjects());
+
+	inputs.resize(s_NUM_TRIPLES);
+	for (StepInput & input : inputs)
+	{
+		for (int o = 0; o < state.size(); ++o)
+			state[o] = generator() % (numLocations + (o > 0));
+		input.m_state = context.StateToIdx(state);
+
+		for (int o = 1; o < state.size(); ++o)
+		{
+			if (generator() % 2)
+				state[o] = state[0];
+		}
+		input.m_lastObs = context.StateToIdx(state);
+
+		input.m_action = generator() % model->NumActions();
+		input.m_random = random(generator);
+	}
+}
+
+void StepAll(const nxnGrid * model, const std::vector<StepInput> & inputs, std::vector<StepResult> & results)
+{
+	std::shared_ptr<const nxnGridContext> context = model->GetContext();
+	results.resize(inputs.size());
+	for (int i = 0; i < inputs.size(); ++i)
+	{
+		const StepInput & input = inputs[i];
+		StepResult & result = results[i];
+		// the state is not allocated from the memory pool of the model (the pool is not thread safe)
+		nxnGridState state(input.m_state, 1.0, context.get());
+		result.m_terminal = model->Step(state, input.m_random, input.m_action, input.m_lastObs, result.m_reward, result.m_obs);
+		result.m_state = state.state_id;
+	}
+}
@@ -0,0 +1,86 @@
+#include "nxnGridToolModel.h"
+
+/// models available
+#include "nxnGridGlobalActions.h"
+#include "nxnGridLocalActions.h"
+
+// properties of objects
+#include "Coordinate.h"
+#include "Move_Properties.h"
+
+namespace despot
+{
+
+namespace nxnGridToolModel
+{
+
+Objects::Objects(int attackRange)
+	: m_selfAttack(new DirectAttack(attackRange, 0.5))
+	, m_enemyAttack(new DirectAttack(attackRange, 0.3))
+	, m_observation(new ObservationByDistance(0.3))
+{
+}
+
+int AttackRange(int gridSize)
+{
+	int attackRange = gridSize / 4;
+	return attackRange + (attackRange == 0);
+}
+
+std::vector<intVec> InitLocations(int gridSize)
+{
+	int numLocations = gridSize * gridSize;
+	return { { 0 }, { numLocations - 1 }, { numLocations - 2 }, { numLocations / 2 }, { numLocations / 3 } };
+}
+
+Self_Obj CreateSelf(const Objects & objects)
+{
+	Coordinate selfLocation(0, 0);
+	Move_Properties selfMovement(0.1, 0.9);
+	return Self_Obj(selfLocation, selfMovement, objects.m_selfAttack, objects.m_observation);
+}
+
+void AddObjects(nxnGrid & model, const Objects & objects)
+{
+	int gridSize = model.GetGridSize();
+	int numLocations = gridSize * gridSize;
+
+	Move_Properties enemyMovement(0.4, 0.4);
+	for (int e = 0; e < 2; ++e)
+	{
+		Coordinate enemyLocation(gridSize - 1 - e, gridSize - 1);
+		model.AddObj(Attack_Obj(enemyLocation, enemyMovement, objects.m_enemyAttack));
+	}
+
+	Coordinate nonInvLocation(0, gridSize / 2);
+	Move_Properties nonInvMovement(0.6);
+	model.AddObj(Movable_Obj(nonInvLocation, nonInvMovement));
+
+	Coordinate shelterLocation(numLocations / 3 % gridSize, numLocations / 3 / gridSize);
+	model.AddObj(ObjInGrid(shelterLocation));
+}
+
+nxnGrid * Create(int gridSize, ACTION_TYPE actionType, const nxnGrid::Settings & settings)
+{
+	return Create(gridSize, actionType, settings, Objects(AttackRange(gridSize)));
+}
+
+nxnGrid * Create(int gridSize, ACTION_TYPE actionType, const nxnGrid::Settings & settings, const Objects & objects)
+{
+	std::vector<intVec> objVec = InitLocations(gridSize);
+	Self_Obj self = CreateSelf(objects);
+	int target = gridSize * gridSize - 1;
+
+	nxnGrid * model;
+	if (actionType == LOCAL)
+		model = new nxnGridLocalActions(gridSize, target, self, objVec, settings);
+	else
+		model = new nxnGridGlobalActions(gridSize, target, self, objVec, true, settings);
+
+	AddObjects(*model, objects);
+	return model;
+}
+
+} // namespace nxnGridToolModel
+
+} // namespace despot
@@ -0,0 +1,59 @@
+#ifndef NXNGRIDTOOLMODEL_H
+#define NXNGRIDTOOLMODEL_H
+
+#include <memory>
+#include <vector>
+
+/// models available
+#include "nxnGrid.h"
+
+// properties of objects
+#include "Attacks.h"
+#include "Observations.h"
+#include "Self_Obj.h"
+
+namespace despot
+{
+
+/* =============================================================================
+* nxnGridToolModel
+* =============================================================================*/
+/// model of the nxnGrid checks and benchmarks (the model of despotMain): self in the top left corner, 2 enemies in the bottom right
+/// corner, non-involved object in the left edge and shelter in the first third of the grid. the target is the last location
+namespace nxnGridToolModel
+{
+	using intVec = std::vector<int>;
+
+	enum ACTION_TYPE { GLOBAL, LOCAL };
+
+	/// attack and observation objects of the model (objects can be shared by models of different grid sizes)
+	struct Objects
+	{
+		/// objects of the model with a given attack range
+		explicit Objects(int attackRange);
+
+		std::shared_ptr<Attack> m_selfAttack;
+		std::shared_ptr<Attack> m_enemyAttack;
+		std::shared_ptr<Observation> m_observation;
+	};
+
+	/// return attack range of a grid size (quarter of the grid and at least 1)
+	int AttackRange(int gridSize);
+
+	/// return init locations of self, enemies, non-involved and shelter
+	std::vector<intVec> InitLocations(int gridSize);
+	/// return self object
+	Self_Obj CreateSelf(const Objects & objects);
+	/// add enemies, non-involved and shelter to a model created with CreateSelf and InitLocations
+	void AddObjects(nxnGrid & model, const Objects & objects);
+
+	/// create model with global or local actions
+	nxnGrid * Create(int gridSize, ACTION_TYPE actionType, const nxnGrid::Settings & settings = nxnGrid::Settings());
+	/// create model with given attack and observation objects
+	nxnGrid * Create(int gridSize, ACTION_TYPE actionType, const nxnGrid::Settings & settings, const Objects & objects);
+
+} // namespace nxnGridToolModel
+
+} // namespace despot
+
+#endif // NXNGRIDTOOLMODEL_H
@@ -53,6 +53,16 @@ double RandomStreams::Entry(int stream, int position) const {
 	return streams_[stream][position];
 }
 
+void RandomStreams::Shift() {
+	vector<unsigned> seeds = Seeds::Next(streams_.size());
+
+	for (int i = 0; i < streams_.size(); i++) {
+		Random random(seeds[i]);
+		streams_[i].erase(streams_[i].begin());
+		streams_[i].push_back(random.NextDouble());
+	}
+}
+
 ostream& operator<<(ostream& os, const RandomStreams& stream) {
 	for (int i = 0; i < stream.NumStreams(); i++) {
 		os << "Stream " << i << ":";
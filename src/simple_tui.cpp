@@ -1,6 +1,8 @@
 #include <fstream>      // std::ofstream NATAN CHANGES
+#include <sstream>
 
 #include "../include/despot/simple_tui.h"
+#include "../include/despot/core/transition_cache.h"
 
 #include "nxnGrid.h"
 
@@ -44,6 +46,14 @@ Solver *SimpleTUI::InitializeSolver(DSPOMDP *model, string solver_type,
 
       logi << "Created upper bound " << typeid(*upper_bound).name() << endl;
 
+      if (Globals::config.num_search_threads > 1 &&
+          !DESPOT::SupportsParallelTrials(model, lower_bound, upper_bound)) {
+        cerr << "ERROR: --search-threads > 1 needs a model and bounds that are "
+                "thread-safe (lower bound " << lbtype << ", upper bound "
+             << ubtype << ")" << endl;
+        exit(1);
+      }
+
       solver = new DESPOT(model, lower_bound, upper_bound);
     } else
       solver = lower_bound;
@@ -146,6 +156,21 @@ void SimpleTUI::OptionParse(option::Option *options, int &num_runs,
   if (options[E_NOISE])
     Globals::config.noise = atof(options[E_NOISE].arg);
 
+  if (options[E_TRANSITION_CACHE])
+    Globals::config.transition_cache_size =
+        atoi(options[E_TRANSITION_CACHE].arg);
+
+  if (options[E_SEARCH_THREADS])
+    Globals::config.num_search_threads =
+        atoi(options[E_SEARCH_THREADS].arg);
+
+  if (options[E_EXPAND_THREADS])
+    Globals::config.num_expand_threads =
+        atoi(options[E_EXPAND_THREADS].arg);
+
+  if (options[E_REUSE_TREE])
+    Globals::config.reuse_tree = true;
+
   search_solver = options[E_SEARCH_SOLVER];
 
   if (options[E_SOLVER])
@@ -194,7 +219,14 @@ void SimpleTUI::DisplayParameters(option::Option *options, DSPOMDP *model) {
               << "Upper bound = " << ubtype << endl
               << "Policy simulation depth = "
               << Globals::config.max_policy_sim_len << endl
-              << "Target gap ratio = " << Globals::config.xi << endl;
+              << "Target gap ratio = " << Globals::config.xi << endl
+              << "Transition cache size = "
+              << Globals::config.transition_cache_size << endl
+              << "Search threads = "
+              << Globals::config.num_search_threads << endl
+              << "Expansion threads = "
+              << Globals::config.num_expand_threads << endl
+              << "Tree reuse = " << Globals::config.reuse_tree << endl;
   // << "Solver = " << typeid(*solver).name() << endl << endl;
 }
 
@@ -375,6 +407,11 @@ int SimpleTUI::run(int argc, char *argv[], std::ofstream & result, std::shared_p
 	* initialize model
 	* =========================*/
 	DSPOMDP *model = InitializeModel(options);
+	if (model->SupportsTransitionCache())
+		model->EnableTransitionCache(Globals::config.transition_cache_size);
+	else if (Globals::config.transition_cache_size > 0)
+		cerr << "WARNING: transition cache is not supported by the model, ignored"
+			<< endl;
 
 	/* =========================
 	* initialize solver
@@ -410,6 +447,12 @@ int SimpleTUI::run(int argc, char *argv[], std::ofstream & result, std::shared_p
 
 	std::string resultString;
 	PrintResult(num_runs, simulator, main_clock_start, resultString);
+
+	if (model->transition_cache() != NULL) {
+		std::ostringstream cacheStatistics;
+		model->transition_cache()->PrintStatistics(cacheStatistics);
+		resultString += cacheStatistics.str();
+	}
   
 	// NATAN CHANGES
 	result << resultString;
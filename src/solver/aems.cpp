@@ -110,8 +110,8 @@ void AEMS::FindMaxApproxErrorLeaf(QNode* qnode, double likelihood,
 	double& bestAE, VNode*& bestNode) {
 	likelihood *= Likelihood(qnode);
 
-	map<OBS_TYPE, VNode*>& children = qnode->children();
-	for (map<OBS_TYPE, VNode*>::iterator it = children.begin();
+	ObsChildren& children = qnode->children();
+	for (ObsChildren::iterator it = children.begin();
 			it != children.end(); it++) {
 		VNode* vnode = it->second;
 		FindMaxApproxErrorLeaf(vnode, likelihood, bestAE, bestNode);
@@ -159,8 +159,8 @@ void AEMS::Update(QNode* qnode) {
 	double lower = qnode->step_reward;
 	double upper = qnode->step_reward;
 
-	map<OBS_TYPE, VNode*>& children = qnode->children();
-	for (map<OBS_TYPE, VNode*>::iterator it = children.begin();
+	ObsChildren& children = qnode->children();
+	for (ObsChildren::iterator it = children.begin();
 			it != children.end(); it++) {
 		VNode* vnode = it->second;
 
@@ -210,7 +210,7 @@ void AEMS::InitUpperBound(VNode* vnode, BeliefUpperBound* upper_bound,
 
 void AEMS::Expand(VNode* vnode, BeliefLowerBound* lower_bound,
 	BeliefUpperBound* upper_bound, const BeliefMDP* model, History& history) {
-	vector<QNode*>& children = vnode->children();
+	ActionChildren& children = vnode->children();
 	logd << "- Expanding vnode " << vnode << endl;
 	for (int action = 0; action < model->NumActions(); action++) {
 		logd << " Action " << action << endl;
@@ -226,7 +226,7 @@ void AEMS::Expand(QNode* qnode, BeliefLowerBound* lb, BeliefUpperBound* ub,
 	const BeliefMDP* model, History& history) {
 	VNode* parent = qnode->parent();
 	int action = qnode->edge();
-	map<OBS_TYPE, VNode*>& children = qnode->children();
+	ObsChildren& children = qnode->children();
 
 	const Belief* belief = parent->belief();
 	// cout << *belief << endl;
@@ -1,20 +1,37 @@
+#include <thread>
+#include <memory>
+
 #include "../../include/despot/solver/despot.h"
 #include "../../include/despot/solver/pomcp.h"
 #include "../../include/despot/core/pomdp.h"
+#include "../../include/despot/core/obs_partition.h"
+#include "../../include/despot/util/thread_pool.h"
 
 using namespace std;
 
 namespace despot {
 
+// Threads stepping particles in node expansion (rebuilt when the number of
+// expansion threads changes)
+static ThreadPool* ExpansionPool() {
+	static unique_ptr<ThreadPool> pool;
+	if (pool == NULL || pool->NumThreads() != Globals::config.num_expand_threads) {
+		pool.reset(new ThreadPool(Globals::config.num_expand_threads));
+	}
+	return pool.get();
+}
+
 DESPOT::DESPOT(const DSPOMDP* model, ScenarioLowerBound* lb, ScenarioUpperBound* ub, Belief* belief) :
 	Solver(model, belief),
 	root_(NULL), 
+	tree_arena_(0),
 	lower_bound_(lb),
 	upper_bound_(ub) {
 	assert(model != NULL);
 }
 
 DESPOT::~DESPOT() {
+	ReleaseTree();
 }
 
 ScenarioLowerBound* DESPOT::lower_bound() const {
@@ -77,6 +94,152 @@ VNode* DESPOT::Trial(VNode* root, RandomStreams& streams,
 	return cur;
 }
 
+bool DESPOT::SupportsParallelTrials(const DSPOMDP* model,
+	const ScenarioLowerBound* lower_bound,
+	const ScenarioUpperBound* upper_bound) {
+	return model->IsThreadSafe() && lower_bound->IsThreadSafe()
+		&& upper_bound->IsThreadSafe();
+}
+
+int DESPOT::ParallelTrials(VNode* root, RandomStreams& streams,
+	ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
+	const DSPOMDP* model, History& history, double timeout,
+	SearchStatistics* statistics, double& used_time) {
+	int num_threads = Globals::config.num_search_threads;
+	vector<SearchStatistics> thread_statistics(num_threads);
+	mutex tree_mutex;
+	int num_trials = 0;
+	bool done = false;
+	double start = get_time_second();
+
+	auto worker = [&](int t) {
+		// Stream positions and history change along a trial so each thread
+		// walks the tree with its own copies
+		RandomStreams thread_streams(streams);
+		History thread_history(history);
+		SearchStatistics& thread_stats = thread_statistics[t];
+
+		unique_lock<mutex> tree_lock(tree_mutex);
+		while (!done) {
+			VNode* cur = ParallelTrial(root, tree_lock, thread_streams, lower_bound,
+				upper_bound, model, thread_history, thread_stats);
+
+			double backup_start = get_time_second();
+			Backup(cur);
+			ReleaseVirtualLoss(cur);
+			thread_stats.time_backup += get_time_second() - backup_start;
+
+			if (cur->expanding) {
+				// The trial stopped at a node expanded by another thread
+				tree_lock.unlock();
+				this_thread::yield();
+				tree_lock.lock();
+			} else {
+				num_trials++;
+			}
+
+			used_time = get_time_second() - start;
+			done = num_trials > 0 && (used_time * (num_trials + 1.0) / num_trials >= timeout
+				|| (root->upper_bound() - root->lower_bound()) <= 1e-6);
+		}
+	};
+
+	vector<thread> threads;
+	for (int t = 1; t < num_threads; t++) {
+		threads.push_back(thread(worker, t));
+	}
+	worker(0);
+	for (int t = 0; t < threads.size(); t++) {
+		threads[t].join();
+	}
+
+	if (statistics != NULL) {
+		for (int t = 0; t < num_threads; t++) {
+			const SearchStatistics& thread_stats = thread_statistics[t];
+			statistics->time_path += thread_stats.time_path;
+			statistics->time_backup += thread_stats.time_backup;
+			statistics->time_node_expansion += thread_stats.time_node_expansion;
+			statistics->num_expanded_nodes += thread_stats.num_expanded_nodes;
+			statistics->num_tree_particles += thread_stats.num_tree_particles;
+			statistics->longest_trial_length = max(statistics->longest_trial_length,
+				thread_stats.longest_trial_length);
+		}
+	}
+
+	return num_trials;
+}
+
+VNode* DESPOT::ParallelTrial(VNode* root, unique_lock<mutex>& tree_lock,
+	RandomStreams& streams, ScenarioLowerBound* lower_bound,
+	ScenarioUpperBound* upper_bound, const DSPOMDP* model, History& history,
+	SearchStatistics& statistics) {
+	VNode* cur = root;
+
+	int hist_size = history.Size();
+
+	do {
+		if (cur->depth() > statistics.longest_trial_length) {
+			statistics.longest_trial_length = cur->depth();
+		}
+
+		ExploitBlockers(cur);
+
+		if (Gap(cur) == 0) {
+			break;
+		}
+
+		if (cur->IsLeaf()) {
+			if (cur->expanding) {
+				break;
+			}
+
+			// Particles and depth of the node do not change, so the children
+			// are built without the tree lock and attached after
+			cur->expanding = true;
+			tree_lock.unlock();
+
+			double start = get_time_second();
+			ActionChildren children(cur->children().get_allocator());
+			Expand(cur, children, lower_bound, upper_bound, model, streams, history);
+			statistics.time_node_expansion += get_time_second() - start;
+			statistics.num_expanded_nodes++;
+			statistics.num_tree_particles += cur->particles().size();
+
+			tree_lock.lock();
+			cur->children().swap(children);
+			cur->expanding = false;
+		}
+
+		double start = get_time_second();
+		QNode* qstar = SelectBestUpperBoundNode(cur);
+		VNode* next = SelectBestWEUNode(qstar);
+		statistics.time_path += get_time_second() - start;
+
+		if (next == NULL) {
+			break;
+		}
+
+		qstar->virtual_loss++;
+		next->virtual_loss++;
+
+		cur = next;
+		history.Add(qstar->edge(), cur->edge());
+	} while (cur->depth() < Globals::config.search_depth && WEU(cur) > 0);
+
+	history.Truncate(hist_size);
+
+	return cur;
+}
+
+void DESPOT::ReleaseVirtualLoss(VNode* vnode) {
+	while (vnode->parent() != NULL) {
+		QNode* parentq = vnode->parent();
+		vnode->virtual_loss--;
+		parentq->virtual_loss--;
+		vnode = parentq->parent();
+	}
+}
+
 void DESPOT::ExploitBlockers(VNode* vnode) {
 	if (Globals::config.pruning_constant <= 0) {
 		return;
@@ -93,9 +256,9 @@ void DESPOT::ExploitBlockers(VNode* vnode) {
 				cur->upper_bound(value);
 				cur->utility_upper_bound = value;
 			} else {
-				const map<OBS_TYPE, VNode*>& siblings =
+				const ObsChildren& siblings =
 					cur->parent()->children();
-				for (map<OBS_TYPE, VNode*>::const_iterator it = siblings.begin();
+				for (ObsChildren::const_iterator it = siblings.begin();
 					it != siblings.end(); it++) {
 					VNode* node = it->second;
 					double value = node->default_move().value;
@@ -121,16 +284,12 @@ void DESPOT::ExploitBlockers(VNode* vnode) {
 VNode* DESPOT::ConstructTree(vector<State*>& particles, RandomStreams& streams,
 	ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
 	const DSPOMDP* model, History& history, double timeout,
-	SearchStatistics* statistics) {
-	if (statistics != NULL) {
-		statistics->num_particles_before_search = model->NumActiveParticles();
-	}
-
+	SearchStatistics* statistics, Arena* arena) {
 	for (int i = 0; i < particles.size(); i++) {
 		particles[i]->scenario_id = i;
 	}
 
-	VNode* root = new VNode(particles);
+	VNode* root = VNode::Create(arena, particles);
 
 	logd
 		<< "[DESPOT::ConstructTree] START - Initializing lower and upper bounds at the root node.";
@@ -138,28 +297,45 @@ VNode* DESPOT::ConstructTree(vector<State*>& particles, RandomStreams& streams,
 	logd
 		<< "[DESPOT::ConstructTree] END - Initializing lower and upper bounds at the root node.";
 
+	ExtendTree(root, streams, lower_bound, upper_bound, model, history, timeout,
+		statistics);
+
+	return root;
+}
+
+void DESPOT::ExtendTree(VNode* root, RandomStreams& streams,
+	ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
+	const DSPOMDP* model, History& history, double timeout,
+	SearchStatistics* statistics) {
 	if (statistics != NULL) {
+		statistics->num_particles_before_search = model->NumActiveParticles();
 		statistics->initial_lb = root->lower_bound();
 		statistics->initial_ub = root->upper_bound();
 	}
 
 	double used_time = 0;
 	int num_trials = 0;
-	do {
-		double start = clock();
-		VNode* cur = Trial(root, streams, lower_bound, upper_bound, model, history, statistics);
-		used_time += double(clock() - start) / CLOCKS_PER_SEC;
+	if (Globals::config.num_search_threads > 1
+		&& SupportsParallelTrials(model, lower_bound, upper_bound)) {
+		num_trials = ParallelTrials(root, streams, lower_bound, upper_bound, model,
+			history, timeout, statistics, used_time);
+	} else {
+		do {
+			double start = clock();
+			VNode* cur = Trial(root, streams, lower_bound, upper_bound, model, history, statistics);
+			used_time += double(clock() - start) / CLOCKS_PER_SEC;
 
-		start = clock();
-		Backup(cur);
-		if (statistics != NULL) {
-			statistics->time_backup += double(clock() - start) / CLOCKS_PER_SEC;
-		}
-		used_time += double(clock() - start) / CLOCKS_PER_SEC;
+			start = clock();
+			Backup(cur);
+			if (statistics != NULL) {
+				statistics->time_backup += double(clock() - start) / CLOCKS_PER_SEC;
+			}
+			used_time += double(clock() - start) / CLOCKS_PER_SEC;
 
-		num_trials++;
-	} while (used_time * (num_trials + 1.0) / num_trials < timeout
-		&& (root->upper_bound() - root->lower_bound()) > 1e-6);
+			num_trials++;
+		} while (used_time * (num_trials + 1.0) / num_trials < timeout
+			&& (root->upper_bound() - root->lower_bound()) > 1e-6);
+	}
 
 	if (statistics != NULL) {
 		statistics->num_particles_after_search = model->NumActiveParticles();
@@ -170,8 +346,6 @@ VNode* DESPOT::ConstructTree(vector<State*>& particles, RandomStreams& streams,
 		statistics->time_search = used_time;
 		statistics->num_trials = num_trials;
 	}
-
-	return root;
 }
 
 void DESPOT::Compare() {
@@ -228,9 +402,15 @@ ValuedAction DESPOT::Search() {
 			Globals::NEG_INFTY);
 
 	double start = get_time_second();
-	vector<State*> particles = belief_->Sample(Globals::config.num_scenarios);
-	logi << "[DESPOT::Search] Time for sampling " << particles.size()
-		<< " particles: " << (get_time_second() - start) << "s" << endl;
+	vector<State*> particles;
+	if (root_ == NULL) {
+		particles = belief_->Sample(Globals::config.num_scenarios);
+		logi << "[DESPOT::Search] Time for sampling " << particles.size()
+			<< " particles: " << (get_time_second() - start) << "s" << endl;
+	} else {
+		logi << "[DESPOT::Search] Reusing tree with "
+			<< root_->particles().size() << " particles" << endl;
+	}
 
 	statistics_ = SearchStatistics();
 
@@ -247,28 +427,44 @@ ValuedAction DESPOT::Search() {
 			initialized = true;
 		}
 	} else {
-		streams = RandomStreams(Globals::config.num_scenarios,
-			Globals::config.search_depth);
+		if (root_ != NULL) { // the reused tree is one step deeper in the scenarios
+			streams.Shift();
+		} else {
+			streams = RandomStreams(Globals::config.num_scenarios,
+				Globals::config.search_depth);
+		}
 		lower_bound_->Init(streams);
 		upper_bound_->Init(streams);
 	}
 
-	root_ = ConstructTree(particles, streams, lower_bound_, upper_bound_,
-		model_, history_, Globals::config.time_per_move, &statistics_);
+	if (root_ == NULL) {
+		root_ = ConstructTree(particles, streams, lower_bound_, upper_bound_,
+			model_, history_, Globals::config.time_per_move, &statistics_,
+			&arenas_[tree_arena_]);
+	} else {
+		ExtendTree(root_, streams, lower_bound_, upper_bound_, model_, history_,
+			Globals::config.time_per_move, &statistics_);
+	}
 	logi << "[DESPOT::Search] Time for tree construction: "
 		<< (get_time_second() - start) << "s" << endl;
 
-	start = get_time_second();
-	root_->Free(*model_);
-	logi << "[DESPOT::Search] Time for freeing particles in search tree: "
-		<< (get_time_second() - start) << "s" << endl;
-
-	ValuedAction astar = OptimalAction(root_);
-	start = get_time_second();
-	delete root_;
-
-	logi << "[DESPOT::Search] Time for deleting tree: "
-		<< (get_time_second() - start) << "s" << endl;
+	ValuedAction astar;
+	if (CanReuseTree()) { // the tree is kept until Update re-roots it
+		astar = OptimalAction(root_);
+	} else {
+		start = get_time_second();
+		root_->Free(*model_);
+		logi << "[DESPOT::Search] Time for freeing particles in search tree: "
+			<< (get_time_second() - start) << "s" << endl;
+
+		astar = OptimalAction(root_);
+		start = get_time_second();
+		arenas_[tree_arena_].Reset();
+		root_ = NULL;
+
+		logi << "[DESPOT::Search] Time for deleting tree: "
+			<< (get_time_second() - start) << "s" << endl;
+	}
 	logi << "[DESPOT::Search] Search statistics:" << endl << statistics_
 		<< endl;
 
@@ -393,7 +589,7 @@ VNode* DESPOT::Prune(VNode* vnode, int& pruned_action, double& pruned_value) {
 	VNode* pruned_v = new VNode(empty, vnode->depth(), NULL,
 		vnode->edge());
 
-	vector<QNode*>& children = vnode->children();
+	ActionChildren& children = vnode->children();
 	int astar = -1;
 	double nustar = Globals::NEG_INFTY;
 	QNode* qstar = NULL;
@@ -437,8 +633,8 @@ VNode* DESPOT::Prune(VNode* vnode, int& pruned_action, double& pruned_value) {
 QNode* DESPOT::Prune(QNode* qnode, double& pruned_value) {
 	QNode* pruned_q = new QNode((VNode*) NULL, qnode->edge());
 	pruned_value = qnode->step_reward - Globals::config.pruning_constant;
-	map<OBS_TYPE, VNode*>& children = qnode->children();
-	for (map<OBS_TYPE, VNode*>::iterator it = children.begin();
+	ObsChildren& children = qnode->children();
+	for (ObsChildren::iterator it = children.begin();
 		it != children.end(); it++) {
 		int astar;
 		double nu;
@@ -494,12 +690,16 @@ double DESPOT::WEU(VNode* vnode, double xi) {
 VNode* DESPOT::SelectBestWEUNode(QNode* qnode) {
 	double weustar = Globals::NEG_INFTY;
 	VNode* vstar = NULL;
-	map<OBS_TYPE, VNode*>& children = qnode->children();
-	for (map<OBS_TYPE, VNode*>::iterator it = children.begin();
+	ObsChildren& children = qnode->children();
+	for (ObsChildren::iterator it = children.begin();
 		it != children.end(); it++) {
 		VNode* vnode = it->second;
 
 		double weu = WEU(vnode);
+		// Virtual loss: spread concurrent trials over the observation branches
+		if (weu > 0) {
+			weu /= 1 + vnode->virtual_loss;
+		}
 		if (weu >= weustar) {
 			weustar = weu;
 			vstar = vnode->vstar;
@@ -514,8 +714,15 @@ QNode* DESPOT::SelectBestUpperBoundNode(VNode* vnode) {
 	for (int action = 0; action < vnode->children().size(); action++) {
 		QNode* qnode = vnode->Child(action);
 
-		if (qnode->upper_bound() > upperstar) {
-			upperstar = qnode->upper_bound();
+		// Virtual loss: the upper bound of an action tried by other concurrent
+		// trials is moved toward its lower bound
+		double upper = qnode->upper_bound();
+		if (qnode->virtual_loss > 0) {
+			upper = qnode->lower_bound()
+				+ (upper - qnode->lower_bound()) / (1 + qnode->virtual_loss);
+		}
+		if (upper > upperstar) {
+			upperstar = upper;
 			astar = action;
 		}
 	}
@@ -557,8 +764,8 @@ void DESPOT::Update(QNode* qnode) {
 	double utility_upper = qnode->step_reward
 		+ Globals::config.pruning_constant;
 
-	map<OBS_TYPE, VNode*>& children = qnode->children();
-	for (map<OBS_TYPE, VNode*>::iterator it = children.begin();
+	ObsChildren& children = qnode->children();
+	for (ObsChildren::iterator it = children.begin();
 		it != children.end(); it++) {
 		VNode* vnode = it->second;
 
@@ -623,11 +830,29 @@ void DESPOT::Expand(VNode* vnode,
 	ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
 	const DSPOMDP* model, RandomStreams& streams,
 	History& history) {
-	vector<QNode*>& children = vnode->children();
+	Expand(vnode, vnode->children(), lower_bound, upper_bound, model, streams,
+		history);
+}
+
+void DESPOT::Expand(VNode* vnode, ActionChildren& children,
+	ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
+	const DSPOMDP* model, RandomStreams& streams,
+	History& history) {
 	logd << "- Expanding vnode " << vnode << endl;
+	// Expansion threads are used only when the tree is built by one thread and
+	// the model can be stepped concurrently
+	if (Globals::config.num_expand_threads > 1
+		&& Globals::config.num_search_threads <= 1 && model->IsThreadSafe()) {
+		ParallelExpand(vnode, children, lower_bound, upper_bound, model, streams,
+			history);
+		logd << "* Expansion complete!" << endl;
+		return;
+	}
+
+	children.reserve(model->NumActions());
 	for (int action = 0; action < model->NumActions(); action++) {
 		logd << " Action " << action << endl;
-		QNode* qnode = new QNode(vnode, action);
+		QNode* qnode = QNode::Create(vnode->arena(), vnode, action);
 		children.push_back(qnode);
 
 		Expand(qnode, lower_bound, upper_bound, model, streams, history);
@@ -635,44 +860,131 @@ void DESPOT::Expand(VNode* vnode,
 	logd << "* Expansion complete!" << endl;
 }
 
+void DESPOT::ParallelExpand(VNode* vnode, ActionChildren& children,
+	ScenarioLowerBound* lower_bound, ScenarioUpperBound* upper_bound,
+	const DSPOMDP* model, RandomStreams& streams,
+	History& history) {
+	ThreadPool* pool = ExpansionPool();
+	int num_actions = model->NumActions();
+	int num_particles = vnode->particles().size();
+	int chunk_size = max(1, (num_particles + pool->NumThreads() - 1) / pool->NumThreads());
+	int num_chunks = max(1, (num_particles + chunk_size - 1) / chunk_size);
+
+	vector<QNode*> qnodes(num_actions);
+	vector<vector<State*> > copies(num_actions, vector<State*>(num_particles));
+	vector<vector<double> > rewards(num_actions, vector<double>(num_particles));
+	vector<vector<OBS_TYPE> > obs(num_actions, vector<OBS_TYPE>(num_particles));
+	for (int action = 0; action < num_actions; action++) {
+		qnodes[action] = QNode::Create(vnode->arena(), vnode, action);
+	}
+
+	// Step (action, particle chunk) tasks in parallel. Each task writes its
+	// own slice, so the results do not depend on the order the tasks run in
+	pool->Run(num_actions * num_chunks, [&](int task) {
+		int action = task / num_chunks;
+		int begin = (task % num_chunks) * chunk_size;
+		int end = min(begin + chunk_size, num_particles);
+		Step(qnodes[action], begin, end, model, streams, history,
+			copies[action], rewards[action], obs[action]);
+	});
+
+	// Belief nodes are created in action and particle order as in the serial
+	// expansion, so the tree is the same for any number of threads
+	children.reserve(num_actions);
+	for (int action = 0; action < num_actions; action++) {
+		logd << " Action " << action << endl;
+		children.push_back(qnodes[action]);
+		CreateChildren(qnodes[action], copies[action], rewards[action],
+			obs[action], lower_bound, upper_bound, model, streams, history);
+	}
+}
+
 void DESPOT::Expand(QNode* qnode, ScenarioLowerBound* lb,
 	ScenarioUpperBound* ub, const DSPOMDP* model,
 	RandomStreams& streams,
 	History& history) {
-	VNode* parent = qnode->parent();
-	streams.position(parent->depth());
-	map<OBS_TYPE, VNode*>& children = qnode->children();
+	int num_particles = qnode->parent()->particles().size();
+	vector<State*> copies(num_particles);
+	vector<double> rewards(num_particles);
+	vector<OBS_TYPE> obs(num_particles);
+	Step(qnode, 0, num_particles, model, streams, history, copies, rewards, obs);
 
-	const vector<State*>& particles = parent->particles();
+	CreateChildren(qnode, copies, rewards, obs, lb, ub, model, streams, history);
+}
 
-	double step_reward = 0;
+void DESPOT::Step(QNode* qnode, int begin, int end, const DSPOMDP* model,
+	const RandomStreams& streams, const History& history,
+	vector<State*>& copies, vector<double>& rewards, vector<OBS_TYPE>& obs) {
+	VNode* parent = qnode->parent();
+	const vector<State*>& particles = parent->particles();
 
-	// Partition particles by observation
-	map<OBS_TYPE, vector<State*> > partitions;
-	OBS_TYPE obs;
-	double reward;
-	for (int i = 0; i < particles.size(); i++) {
+	// Scratch of the batch step is kept per thread and reused across expansions
+	static thread_local vector<State*> batch;
+	static thread_local vector<double> randomNums;
+	static thread_local vector<OBS_TYPE> lastObs;
+	static thread_local vector<double> batch_rewards;
+	static thread_local vector<OBS_TYPE> batch_obs;
+	static thread_local vector<bool> terminals;
+
+	// Step copies of particles
+	OBS_TYPE prevObs = history.Size() > 0 ? history.LastObservation() : 0;
+	batch.resize(end - begin);
+	randomNums.resize(end - begin);
+	lastObs.resize(end - begin);
+	for (int i = begin; i < end; i++) {
 		State* particle = particles[i];
-		logd << " Original: " << *particle << endl;
+		batch[i - begin] = model->Copy(particle);
+		randomNums[i - begin] = streams.Entry(particle->scenario_id, parent->depth());
+		lastObs[i - begin] = prevObs + particle->state_id * (prevObs == 0);
+	}
 
-		State* copy = model->Copy(particle);
+	model->CachedStepBatch(batch, randomNums, qnode->edge(), lastObs, batch_rewards,
+		batch_obs, terminals);
 
-		logd << " Before step: " << *copy << endl;
+	for (int i = begin; i < end; i++) {
+		State* copy = batch[i - begin];
+		rewards[i] = batch_rewards[i - begin] * copy->weight;
+		obs[i] = batch_obs[i - begin];
 
-		bool terminal = model->Step(*copy, streams.Entry(copy->scenario_id),
-			qnode->edge(), reward, obs);
+		if (!terminals[i - begin]) {
+			copies[i] = copy;
+		} else {
+			model->Free(copy);
+			copies[i] = NULL;
+		}
+	}
+}
+
+void DESPOT::CreateChildren(QNode* qnode, const vector<State*>& copies,
+	const vector<double>& rewards, const vector<OBS_TYPE>& obs,
+	ScenarioLowerBound* lb, ScenarioUpperBound* ub, const DSPOMDP* model,
+	RandomStreams& streams, History& history) {
+	VNode* parent = qnode->parent();
+	streams.position(parent->depth());
+	ObsChildren& children = qnode->children();
 
-		step_reward += reward * copy->weight;
+	const vector<State*>& particles = parent->particles();
 
-		logd << " After step: " << *copy << " " << (reward * copy->weight)
-			<< " " << reward << " " << copy->weight << endl;
+	static thread_local ObsPartition partition;
+	static thread_local vector<State*> child_particles;
 
-		if (!terminal) {
-			partitions[obs].push_back(copy);
-		} else {
-			model->Free(copy);
+	double step_reward = 0;
+
+	// Partition particles by observation
+	partition.Clear();
+	for (int i = 0; i < copies.size(); i++) {
+		State* copy = copies[i];
+		step_reward += rewards[i];
+
+		logd << " Original: " << *particles[i] << endl;
+		logd << " After step: " << (copy != NULL ? copy->text() : "terminal")
+			<< " " << rewards[i] << endl;
+
+		if (copy != NULL) {
+			partition.Add(obs[i], i);
 		}
 	}
+	partition.Partition();
 	step_reward = Globals::Discount(parent->depth()) * step_reward
 		- Globals::config.pruning_constant;//pruning_constant is used for regularization
 
@@ -680,12 +992,12 @@ void DESPOT::Expand(QNode* qnode, ScenarioLowerBound* lb,
 	double upper_bound = step_reward;
 
 	// Create new belief nodes
-	for (map<OBS_TYPE, vector<State*> >::iterator it = partitions.begin();
-		it != partitions.end(); it++) {
-		OBS_TYPE obs = it->first;
+	for (int r = 0; r < partition.NumRanges(); r++) {
+		OBS_TYPE obs = partition.Observation(r);
+		partition.Gather(r, copies, child_particles);
 		logd << " Creating node for obs " << obs << endl;
-		VNode* vnode = new VNode(partitions[obs], parent->depth() + 1,
-			qnode, obs);
+		VNode* vnode = VNode::Create(qnode->arena(), child_particles,
+			parent->depth() + 1, qnode, obs);
 		logd << " New node created!" << endl;
 		children[obs] = vnode;
 
@@ -732,8 +1044,10 @@ ValuedAction DESPOT::Evaluate(VNode* root, vector<State*>& particles,
 
 			double reward;
 			OBS_TYPE obs;
+			OBS_TYPE lastObs = prior->history().Size() > 0 ?
+				prior->history().LastObservation() : copy->state_id;
 			bool terminal = model->Step(*copy, streams.Entry(copy->scenario_id),
-				action, reward, obs);
+				action, lastObs, reward, obs);
 
 			val += discount * reward;
 			discount *= Globals::Discount();
@@ -745,7 +1059,7 @@ ValuedAction DESPOT::Evaluate(VNode* root, vector<State*>& particles,
 
 				if (cur != NULL && !cur->IsLeaf()) {
 					QNode* qnode = cur->Child(action);
-					map<OBS_TYPE, VNode*>& vnodes = qnode->children();
+					ObsChildren& vnodes = qnode->children();
 					cur = vnodes.find(obs) != vnodes.end() ? vnodes[obs] : NULL;
 				}
 			} else {
@@ -770,6 +1084,7 @@ void DESPOT::belief(Belief* b) {
 	logi << "[DESPOT::belief] Start: Set initial belief." << endl;
 	belief_ = b;
 	history_.Truncate(0);
+	ReleaseTree();
 
 	lower_bound_->belief(b); // needed for POMCPScenarioLowerBound
 	logi << "[DESPOT::belief] End: Set initial belief." << endl;
@@ -778,6 +1093,10 @@ void DESPOT::belief(Belief* b) {
 void DESPOT::Update(int action, OBS_TYPE obs) {
 	double start = get_time_second();
 
+	if (root_ != NULL) {
+		RerootTree(action, obs);
+	}
+
 	belief_->Update(action, obs);
 	history_.Add(action, obs);
 
@@ -788,4 +1107,88 @@ void DESPOT::Update(int action, OBS_TYPE obs) {
 		<< " in " << (get_time_second() - start) << "s" << endl;
 }
 
+bool DESPOT::CanReuseTree() const {
+	// Values are rescaled when the tree is re-rooted, which does not hold for
+	// the pruning constant subtracted at every node. LookaheadUpperBound keeps
+	// its streams fixed, so they cannot follow the reused scenarios
+	return Globals::config.reuse_tree && Globals::config.pruning_constant == 0
+		&& dynamic_cast<LookaheadUpperBound*>(upper_bound_) == NULL;
+}
+
+void DESPOT::RerootTree(int action, OBS_TYPE obs) {
+	VNode* node = NULL;
+	if (!root_->IsLeaf()) {
+		ObsChildren& children = root_->Child(action)->children();
+		ObsChildren::iterator it = children.find(obs);
+		if (it != children.end() && it->second->particles().size()
+			>= Globals::config.reuse_min_scenarios * Globals::config.num_scenarios) {
+			node = it->second;
+			children.erase(it);
+		}
+	}
+
+	if (node == NULL) {
+		logi << "[DESPOT::RerootTree] No subtree with enough particles for action "
+			<< action << ", observation " << obs << endl;
+		ReleaseTree();
+		return;
+	}
+
+	// Release the rest of the tree and move the subtree to the other arena
+	root_->Free(*model_);
+	int reuse_arena = 1 - tree_arena_;
+	root_ = node->MoveSubtree(&arenas_[reuse_arena]);
+	arenas_[tree_arena_].Reset();
+	tree_arena_ = reuse_arena;
+
+	Reroot(root_, root_->Weight());
+	logi << "[DESPOT::RerootTree] Reusing subtree with "
+		<< root_->particles().size() << " particles and " << root_->Size()
+		<< " nodes" << endl;
+}
+
+void DESPOT::Reroot(VNode* vnode, double weight) {
+	// Values at depth d are discounted by Discount(d) and weighted by the
+	// particle weights, both of which change
+	double scale = 1.0 / (Globals::Discount() * weight);
+
+	vnode->depth(vnode->depth() - 1);
+	const vector<State*>& particles = vnode->particles();
+	for (int i = 0; i < particles.size(); i++) {
+		particles[i]->weight /= weight;
+	}
+
+	ValuedAction move = vnode->default_move();
+	move.value *= scale;
+	vnode->default_move(move);
+	vnode->lower_bound(vnode->lower_bound() * scale);
+	vnode->upper_bound(vnode->upper_bound() * scale);
+	vnode->utility_upper_bound *= scale;
+
+	for (int action = 0; action < vnode->children().size(); action++) {
+		QNode* qnode = vnode->Child(action);
+		qnode->lower_bound(qnode->lower_bound() * scale);
+		qnode->upper_bound(qnode->upper_bound() * scale);
+		qnode->utility_upper_bound *= scale;
+		qnode->step_reward *= scale;
+		qnode->default_value *= scale;
+
+		ObsChildren& children = qnode->children();
+		for (ObsChildren::iterator it = children.begin(); it != children.end();
+			it++) {
+			Reroot(it->second, weight);
+		}
+	}
+}
+
+void DESPOT::ReleaseTree() {
+	if (root_ == NULL) {
+		return;
+	}
+
+	root_->Free(*model_);
+	arenas_[tree_arena_].Reset();
+	root_ = NULL;
+}
+
 } // namespace despot
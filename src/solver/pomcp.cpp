@@ -64,7 +64,8 @@ void UniformPOMCPPrior::ComputePreference(const State& state) {
 
 POMCP::POMCP(const DSPOMDP* model, POMCPPrior* prior, Belief* belief) :
 	Solver(model, belief),
-	root_(NULL) {
+	root_(NULL),
+	tree_arena_(0) {
 	reuse_ = false;
 	prior_ = prior;
 	assert(prior_ != NULL);
@@ -75,10 +76,11 @@ void POMCP::reuse(bool r) {
 }
 ValuedAction POMCP::Search(double timeout) {
 	double start_cpu = clock(), start_real = get_time_second();
+	statistics_ = SearchStatistics();
 
 	if (root_ == NULL) {
 		State* state = belief_->Sample(1)[0];
-		root_ = CreateVNode(0, state, prior_, model_);
+		root_ = CreateVNode(0, state, prior_, model_, &arenas_[tree_arena_]);
 		model_->Free(state);
 	}
 
@@ -112,12 +114,19 @@ ValuedAction POMCP::Search(double timeout) {
 
 	ValuedAction astar = OptimalAction(root_);
 
+	statistics_.num_trials = num_sims;
+	statistics_.num_tree_nodes = root_->Size();
+	statistics_.time_search = (clock() - start_cpu) / CLOCKS_PER_SEC;
+	prior_->CollectStatistics(statistics_);
+
 	logi << "[POMCP::Search] Search statistics" << endl
 		<< "OptimalAction = " << astar << endl 
 		<< "# Simulations = " << root_->count() << endl
 		<< "Time: CPU / Real = " << ((clock() - start_cpu) / CLOCKS_PER_SEC) << " / " << (get_time_second() - start_real) << endl
 		<< "# active particles = " << model_->NumActiveParticles() << endl
 		<< "Tree size = " << root_->Size() << endl;
+	if (statistics_.prior_cache_used)
+		logi << "Prior cache: hits / misses = " << statistics_.num_prior_cache_hits << " / " << statistics_.num_prior_cache_misses << endl;
 
 	if (astar.action == -1) {
 		for (int action = 0; action < model_->NumActions(); action++) {
@@ -138,7 +147,7 @@ void POMCP::belief(Belief* b) {
 	belief_ = b;
 	history_.Truncate(0);
   prior_->PopAll();
-	delete root_;
+	arenas_[tree_arena_].Reset();
 	root_ = NULL;
 }
 
@@ -147,15 +156,13 @@ void POMCP::Update(int action, OBS_TYPE obs) {
 
 	if (reuse_) {
 		VNode* node = root_->Child(action)->Child(obs);
-		root_->Child(action)->children().erase(obs);
-		delete root_;
+		int reuse_arena = 1 - tree_arena_;
+		root_ = node != NULL ? node->MoveSubtree(&arenas_[reuse_arena]) : NULL;
 
-		root_ = node;
-		if (root_ != NULL) {
-			root_->parent(NULL);
-		}
+		arenas_[tree_arena_].Reset();
+		tree_arena_ = reuse_arena;
 	} else {
-		delete root_;
+		arenas_[tree_arena_].Reset();
 		root_ = NULL;
 	}
 
@@ -169,7 +176,7 @@ void POMCP::Update(int action, OBS_TYPE obs) {
 }
 
 int POMCP::UpperBoundAction(const VNode* vnode, double explore_constant) {
-	const vector<QNode*>& qnodes = vnode->children();
+	const ActionChildren& qnodes = vnode->children();
 	double best_ub = Globals::NEG_INFTY;
 	int best_action = -1;
 
@@ -202,7 +209,7 @@ int POMCP::UpperBoundAction(const VNode* vnode, double explore_constant) {
 }
 
 ValuedAction POMCP::OptimalAction(const VNode* vnode) {
-	const vector<QNode*>& qnodes = vnode->children();
+	const ActionChildren& qnodes = vnode->children();
 	ValuedAction astar(-1, Globals::NEG_INFTY);
 	for (int action = 0; action < qnodes.size(); action++) {
 		// cout << action << " " << qnodes[action]->value() << " " << qnodes[action]->count() << " " << vnode->count() << endl;
@@ -259,8 +266,9 @@ void POMCP::SaveTreeInFile(std::ofstream & out) const // NATAN CHANGES
 }
 
 VNode* POMCP::CreateVNode(int depth, const State* state, POMCPPrior* prior,
-	const DSPOMDP* model) {
-	VNode* vnode = new VNode(0, 0.0, depth);
+	const DSPOMDP* model, Arena* arena) {
+	VNode* vnode = VNode::Create(arena, 0, 0.0, depth);
+	vnode->children().reserve(model->NumActions());
 
 	prior->ComputePreference(*state);
 
@@ -270,15 +278,14 @@ VNode* POMCP::CreateVNode(int depth, const State* state, POMCPPrior* prior,
 	int large_count = 1000000;
 	double neg_infty = -1e10;
 	
-	std::vector<double> rewardsVec;
-	nxnGrid::ChoosePreferredAction(prior, model, rewardsVec);
+	const std::vector<double> & rewardsVec = nxnGrid::ChoosePreferredAction(prior, model);
 
 
 	if (legal_actions.size() == 0) { // no prior knowledge, all actions are equal
 
 		for (int action = 0; action < model->NumActions(); action++) 
 		{
-			QNode* qnode = new QNode(vnode, action);
+			QNode* qnode = QNode::Create(vnode->arena(), vnode, action);
 			qnode->count(0);
 			qnode->value(rewardsVec[action]);
 			
@@ -286,7 +293,7 @@ VNode* POMCP::CreateVNode(int depth, const State* state, POMCPPrior* prior,
 		}
 	} else {
 		for (int action = 0; action < model->NumActions(); action++) {
-			QNode* qnode = new QNode(vnode, action);
+			QNode* qnode = QNode::Create(vnode->arena(), vnode, action);
 			qnode->count(large_count);
 			qnode->value(neg_infty);
 
@@ -330,7 +337,7 @@ double POMCP::Simulate(State* particle, RandomStreams& streams, VNode* vnode,
 	if (!terminal) {
 		prior->Add(action, obs);
 		streams.Advance();
-		map<OBS_TYPE, VNode*>& vnodes = qnode->children();
+		ObsChildren& vnodes = qnode->children();
 		if (vnodes[obs] != NULL) {
 			reward += Globals::Discount()
 				* Simulate(particle, streams, vnodes[obs], model, prior);
@@ -338,7 +345,7 @@ double POMCP::Simulate(State* particle, RandomStreams& streams, VNode* vnode,
 			reward += Globals::Discount() 
         * Rollout(particle, streams, vnode->depth() + 1, model, prior);
 			vnodes[obs] = CreateVNode(vnode->depth() + 1, particle, prior,
-				model);
+				model, vnode->arena());
 		}
 		streams.Back();
 		prior->PopLast();
@@ -369,7 +376,7 @@ double POMCP::Simulate(State* particle, VNode* vnode, const DSPOMDP* model,
 	QNode* qnode = vnode->Child(action);
 	if (!terminal) {
 		prior->Add(action, obs);
-		map<OBS_TYPE, VNode*>& vnodes = qnode->children();
+		ObsChildren& vnodes = qnode->children();
 		if (vnodes[obs] != NULL) 
 		{
 			reward += Globals::Discount()
@@ -378,7 +385,7 @@ double POMCP::Simulate(State* particle, VNode* vnode, const DSPOMDP* model,
 		else 
 		{ // Rollout upon encountering a node not in curren tree, then add the node
 			vnodes[obs] = CreateVNode(vnode->depth() + 1, particle, prior,
-				model);
+				model, vnode->arena());
 			reward += Globals::Discount()
 				* Rollout(particle, vnode->depth() + 1, model, prior);
 		}
@@ -405,7 +412,7 @@ double POMCP::Rollout(State* particle, RandomStreams& streams, int depth,
 
 	double reward;
 	OBS_TYPE obs;
-	bool terminal = model->Step(*particle, streams.Entry(particle->scenario_id), action, prior->history().LastObservation(), reward, obs);
+	bool terminal = model->CachedStep(*particle, streams.Entry(particle->scenario_id), action, prior->history().LastObservation(), reward, obs);
 	if (!terminal) {
 		prior->Add(action, obs);
 		streams.Advance();
@@ -476,7 +483,7 @@ ValuedAction POMCP::Evaluate(VNode* root, vector<State*>& particles,
 
 				if (cur != NULL) {
 					QNode* qnode = cur->Child(action);
-					map<OBS_TYPE, VNode*>& vnodes = qnode->children();
+					ObsChildren& vnodes = qnode->children();
 					cur = vnodes.find(obs) != vnodes.end() ? vnodes[obs] : NULL;
 				}
 			} else {
@@ -522,7 +529,7 @@ ValuedAction DPOMCP::Search(double timeout) {
 		Globals::config.search_depth);
 
 	root_ = ConstructTree(particles, streams, model_, prior_, history_,
-		timeout);
+		timeout, &arenas_[tree_arena_]);
 
 	for (int i = 0; i < particles.size(); i++)
 		model_->Free(particles[i]);
@@ -540,15 +547,17 @@ ValuedAction DPOMCP::Search(double timeout) {
 		}
 	}
 
-	delete root_;
+	arenas_[tree_arena_].Reset();
+	root_ = NULL;
 	return astar;
 }
 
 // static
 VNode* DPOMCP::ConstructTree(vector<State*>& particles, RandomStreams& streams,
-	const DSPOMDP* model, POMCPPrior* prior, History& history, double timeout) {
+	const DSPOMDP* model, POMCPPrior* prior, History& history, double timeout,
+	Arena* arena) {
 	prior->history(history);
-	VNode* root = CreateVNode(0, particles[0], prior, model);
+	VNode* root = CreateVNode(0, particles[0], prior, model, arena);
 
 	for (int i = 0; i < particles.size(); i++)
 		particles[i]->scenario_id = i;
@@ -0,0 +1,68 @@
+#include "../../include/despot/util/arena.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace despot {
+
+/* =============================================================================
+ * Arena class
+ * =============================================================================*/
+
+Arena::Arena(size_t chunk_size) :
+	current_(0),
+	offset_(0),
+	chunk_size_(chunk_size),
+	num_bytes_(0) {
+}
+
+Arena::~Arena() {
+	for (int i = 0; i < chunks_.size(); i++) {
+		delete[] chunks_[i].data;
+	}
+}
+
+void* Arena::Allocate(size_t size, size_t alignment) {
+	lock_guard<mutex> guard(lock_);
+
+	while (true) {
+		if (current_ < chunks_.size()) {
+			Chunk& chunk = chunks_[current_];
+			size_t start = (offset_ + alignment - 1) / alignment * alignment;
+			if (start + size <= chunk.size) {
+				offset_ = start + size;
+				num_bytes_ += size;
+				return chunk.data + start;
+			}
+
+			if (current_ + 1 < chunks_.size()) {
+				// move on to a chunk kept from before the last reset
+				current_++;
+				offset_ = 0;
+				continue;
+			}
+		}
+
+		// new[] memory is aligned for any fundamental type
+		Chunk chunk;
+		chunk.size = max(chunk_size_, size);
+		chunk.data = new char[chunk.size];
+		chunks_.push_back(chunk);
+		current_ = chunks_.size() - 1;
+		offset_ = 0;
+	}
+}
+
+void Arena::Reset() {
+	lock_guard<mutex> guard(lock_);
+	current_ = 0;
+	offset_ = 0;
+	num_bytes_ = 0;
+}
+
+size_t Arena::num_bytes() const {
+	return num_bytes_;
+}
+
+} // namespace despot
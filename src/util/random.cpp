@@ -7,6 +7,8 @@
 
 using namespace std;
 
+static const double PI = 3.14159265358979323846;
+
 namespace despot {
 
 Random Random::RANDOM((unsigned) 0);
@@ -51,7 +53,7 @@ double Random::NextDouble() {
 
 double Random::NextGaussian() {
 	double u = NextDouble(), v = NextDouble();
-	return sqrt(-2 * log(u)) * cos(2 * std::_Pi * v);
+	return sqrt(-2 * log(u)) * cos(2 * PI * v);
 }
 
 int Random::NextCategory(const vector<double>& category_probs) {
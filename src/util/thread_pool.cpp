@@ -0,0 +1,76 @@
+#include "../../include/despot/util/thread_pool.h"
+
+using namespace std;
+
+namespace despot {
+
+ThreadPool::ThreadPool(int num_threads) :
+	task_(NULL),
+	num_tasks_(0),
+	next_task_(0),
+	num_running_(0),
+	batch_id_(0),
+	stop_(false) {
+	for (int i = 1; i < num_threads; i++) {
+		workers_.push_back(thread(&ThreadPool::WorkerLoop, this));
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		lock_guard<mutex> guard(lock_);
+		stop_ = true;
+	}
+	batch_ready_.notify_all();
+	for (int i = 0; i < workers_.size(); i++) {
+		workers_[i].join();
+	}
+}
+
+int ThreadPool::NumThreads() const {
+	return workers_.size() + 1;
+}
+
+void ThreadPool::RunTasks(unique_lock<mutex>& lock) {
+	while (next_task_ < num_tasks_) {
+		int task = next_task_++;
+		num_running_++;
+		lock.unlock();
+		(*task_)(task);
+		lock.lock();
+		num_running_--;
+	}
+
+	if (num_running_ == 0) {
+		batch_done_.notify_all();
+	}
+}
+
+void ThreadPool::WorkerLoop() {
+	unique_lock<mutex> lock(lock_);
+	int last_batch = 0;
+	while (true) {
+		batch_ready_.wait(lock, [&] { return stop_ || batch_id_ != last_batch; });
+		if (stop_) {
+			return;
+		}
+
+		last_batch = batch_id_;
+		RunTasks(lock);
+	}
+}
+
+void ThreadPool::Run(int num_tasks, const function<void(int)>& task) {
+	unique_lock<mutex> lock(lock_);
+	task_ = &task;
+	num_tasks_ = num_tasks;
+	next_task_ = 0;
+	batch_id_++;
+	batch_ready_.notify_all();
+
+	RunTasks(lock);
+	batch_done_.wait(lock, [&] { return next_task_ >= num_tasks_ && num_running_ == 0; });
+	task_ = NULL;
+}
+
+} // namespace despot
@@ -1,11 +1,20 @@
 #include "UDP_Prot.h"
 
+#ifdef _WIN32
 #include <Ws2tcpip.h>
+#else
+#include <arpa/inet.h>	// inet_pton
+#include <unistd.h>		// close
+
+#define closesocket close
+#endif
+#include <cstring>		// memset
 #include <iostream>
 
 
 static bool InitWinSock()
 {
+#ifdef _WIN32
 	WSADATA wsaData;
 
 	memset(&wsaData, 0, sizeof(wsaData));
@@ -14,6 +23,9 @@ static bool InitWinSock()
 	int ret = WSAStartup(MAKEWORD(2, 2), &wsaData);
 
 	return 0 == ret;
+#else
+	return true;
+#endif
 }
 
 UDP_Server::UDP_Server()
@@ -63,7 +75,7 @@ bool UDP_Server::Init(int portNum)
 
 int UDP_Server::Read(char * buffer)
 {
-	static int slen = sizeof(m_siOther);
+	socklen_t slen = sizeof(m_siOther);
 
 	return recvfrom(m_socket, buffer, s_BUF_LEN, 0, (struct sockaddr *) &m_siOther, &slen);
 }
@@ -85,7 +97,7 @@ UDP_Client::~UDP_Client()
 {
 	closesocket(m_socket);
 }
-bool UDP_Client::Init(int portNum, char *host)
+bool UDP_Client::Init(int portNum, const char *host)
 {
 	if (!InitWinSock())
 		return false;
@@ -100,18 +112,22 @@ bool UDP_Client::Init(int portNum, char *host)
 	memset(&m_server, 0, sizeof(m_server));
 	m_server.sin_family = AF_INET;
 	m_server.sin_port = htons(portNum);
+#ifdef _WIN32
 	ULONG *srcAddr = new ULONG;
 	InetPton(AF_INET, host, srcAddr);
 	m_server.sin_addr.S_un.S_addr = *srcAddr;
+	delete srcAddr;
+#else
+	inet_pton(AF_INET, host, &m_server.sin_addr);
+#endif
 
 	std::cout << "client init done\n";
-	delete srcAddr;
 	return true;
 }
 
 int UDP_Client::Read(char * buffer)
 {
-	static int slen = sizeof(struct sockaddr_in);
+	socklen_t slen = sizeof(struct sockaddr_in);
 	return recvfrom(m_socket, buffer, s_BUF_LEN, 0, (struct sockaddr *) &m_server, &slen);
 }
 
@@ -1,12 +1,22 @@
 #ifndef UDP_PROT_HPP
 #define UDP_PROT_HPP
 
-#ifndef WIN32_LEAN_AND_MEAN
-	#define WIN32_LEAN_AND_MEAN
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+
+	#include <winsock2.h> // socket
+#else
+	#include <sys/socket.h> // socket
+	#include <netinet/in.h> // sockaddr_in
+
+	// winsock names for the posix socket api
+	typedef int SOCKET;
+	#define INVALID_SOCKET (-1)
+	#define SOCKET_ERROR (-1)
 #endif
 
-#include <winsock2.h> // socket
-
 static const int s_BUF_LEN = 1024;
 static const int DEFAULT_PORT = 5432;
 
@@ -36,7 +46,7 @@ public:
 	~UDP_Client();
 
 	bool IsInit() { return m_socket != INVALID_SOCKET; };
-	bool Init(int portNum = DEFAULT_PORT, char *host = "127.0.0.1");
+	bool Init(int portNum = DEFAULT_PORT, const char *host = "127.0.0.1");
 
 	int Read(char * buffer);
 	bool Write(char * buffer, int size);